@@ -0,0 +1,103 @@
+#!/bin/bash
+
+# Records the payload corpus of highloadcup2021_bench from a running stub server:
+#   cd ../stubserver && python3 -m openapi_server
+#   ./record-corpus.sh
+# Response bodies are stored as is, e.g. the error bodies keep the fields the stub adds
+# on top of code and message.
+
+set -e
+
+ADDRESS=${ADDRESS:-localhost}
+URL="http://"$ADDRESS":8000"
+CORPUS="src/bench/corpus"
+TREASURES_CNT=5
+
+post() {
+  curl -s -X POST $URL/$1 -H 'Content-Type:application/json' --data "$2"
+}
+
+save() {
+  mkdir -p $(dirname $CORPUS/$1)
+  echo "$2" > $CORPUS/$1
+  echo "$1: $(wc -c < $CORPUS/$1) bytes"
+}
+
+save explore/01_row_3500x1.json "$(post explore '{"posX":0,"posY":0,"sizeX":3500,"sizeY":1}')"
+save explore/02_block_64x64.json "$(post explore '{"posX":1728,"posY":640,"sizeX":64,"sizeY":64}')"
+save explore/03_block_8x8.json "$(post explore '{"posX":1736,"posY":696,"sizeX":8,"sizeY":8}')"
+save explore/04_pair_2x1.json "$(post explore '{"posX":3498,"posY":3499,"sizeX":2,"sizeY":1}')"
+save explore/05_cell_1x1.json "$(post explore '{"posX":1739,"posY":701,"sizeX":1,"sizeY":1}')"
+save explore/06_cell_1x1_empty.json "$(post explore '{"posX":17,"posY":3051,"sizeX":1,"sizeY":1}')"
+save error/01_wrong_coordinates.json "$(post explore '{"posX":3500,"posY":0,"sizeX":1,"sizeY":1}')"
+
+# free licenses are issued once per 50ms, the attempts in between end with 502 or 504
+issue_free_license() {
+  while true; do
+    local body=$(post licenses '[]')
+    if echo "$body" | grep -q '"id"'; then
+      LICENSE_BODY=$body
+      LICENSE_ID=$(echo "$body" | grep -o '"id": *[0-9]*' | grep -o '[0-9]*$')
+      return
+    fi
+    if echo "$body" | grep -q '"status": *502'; then
+      save error/09_bad_gateway.json "$body"
+    fi
+    sleep 0.05
+  done
+}
+
+issue_free_license
+save license/01_free.json "$LICENSE_BODY"
+DIGS_LEFT=3
+
+# digs cells of the second row down to the bottom until enough treasures are cashed
+treasures=0
+x=0
+while [ $treasures -lt $TREASURES_CNT ] && [ $x -lt 3500 ]; do
+  for depth in 1 2 3 4 5 6 7 8 9 10; do
+    if [ $DIGS_LEFT -eq 0 ]; then
+      issue_free_license
+      DIGS_LEFT=3
+    fi
+    body=$(post dig '{"licenseID":'$LICENSE_ID',"posX":'$x',"posY":1,"depth":'$depth'}')
+    DIGS_LEFT=$((DIGS_LEFT - 1))
+    if ! echo "$body" | grep -q '^\['; then
+      save error/07_no_treasure.json "$body"
+      continue
+    fi
+    treasures=$((treasures + 1))
+    save dig/0${treasures}_treasure.json "$body"
+    treasure=$(echo "$body" | grep -o '"[0-9a-f-]*"' | head -1)
+    wallet=$(post cash "$treasure")
+    while ! echo "$wallet" | grep -q '^\['; do
+      # 15% of the treasures are cashed with the second attempt
+      save error/08_service_unavailable.json "$wallet"
+      wallet=$(post cash "$treasure")
+    done
+    save cash/0${treasures}_wallet.json "$wallet"
+    if [ $treasures -ge 2 ] && [ $treasures -le 4 ]; then
+      coins=$(echo "$wallet" | tr -d ' \n')
+      save license/0${treasures}_paid.json "$(post licenses "$coins")"
+    fi
+    if [ $treasures -ge $TREASURES_CNT ]; then
+      break
+    fi
+  done
+  x=$((x + 1))
+done
+
+save error/02_wrong_depth.json "$(post dig '{"licenseID":'$LICENSE_ID',"posX":3499,"posY":1,"depth":3}')"
+save error/04_treasure_not_digged.json "$(post cash '"00000000-0000-4000-8000-000000000000"')"
+save error/05_invalid_license.json "$(post dig '{"licenseID":1000000,"posX":3499,"posY":2,"depth":1}')"
+save error/06_bogus_coin.json "$(post licenses '[1000000000]')"
+
+# the stub keeps up to 10 active licenses
+while true; do
+  body=$(post licenses '[]')
+  if echo "$body" | grep -q '"code": *1002'; then
+    save error/03_no_more_licenses.json "$body"
+    break
+  fi
+  sleep 0.05
+done
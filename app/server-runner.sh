@@ -33,7 +33,12 @@ case $1 in
     gdbserver :1234 ./highloadcup2021 2>&1 || echo "Crashed"
     ;;
   *)
-    ./highloadcup2021 2>&1 || echo "Crashed"
+    # PROCESS_SHARDS > 1 splits the field between processes sharing the broker segment
+    for ((i = 1; i < ${PROCESS_SHARDS:-1}; i++)); do
+      PROCESS_SHARD_ID=$i ./highloadcup2021 2>&1 &
+    done
+    PROCESS_SHARD_ID=0 ./highloadcup2021 2>&1 || echo "Crashed"
+    wait
     ;;
 esac
 
@@ -0,0 +1,196 @@
+#include <benchmark/benchmark.h>
+#include <algorithm>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <utility>
+#include <vector>
+#include "json.h"
+
+// Runs every function of json.h over the payloads recorded from the stub server by record-corpus.sh.
+// Each payload is a benchmark of its own, e.g. unmarshalApiError/03_no_more_licenses, so a codec change
+// shows up on the exact shape it affects. Besides the time every benchmark reports bytes_per_op and
+// the throughput.
+
+#ifndef HLC_BENCH_CORPUS_DIR
+#define HLC_BENCH_CORPUS_DIR "src/bench/corpus"
+#endif
+
+namespace {
+
+struct Payload {
+    std::string name_;
+    std::string body_;
+};
+
+std::filesystem::path corpusDir() {
+    auto env = std::getenv("BENCH_CORPUS");
+    if (env != nullptr) {
+        return env;
+    }
+    return HLC_BENCH_CORPUS_DIR;
+}
+
+std::vector<Payload> loadCorpus(const std::string &kind) {
+    std::vector<Payload> payloads;
+    std::error_code ec;
+    for (const auto &entry : std::filesystem::directory_iterator(corpusDir() / kind, ec)) {
+        if (!entry.is_regular_file() || entry.path().extension() != ".json") {
+            continue;
+        }
+        std::ifstream in(entry.path());
+        std::stringstream body;
+        body << in.rdbuf();
+        payloads.push_back(Payload{entry.path().stem().string(), body.str()});
+    }
+    std::sort(payloads.begin(), payloads.end(), [](const Payload &a, const Payload &b) {
+        return a.name_ < b.name_;
+    });
+    return payloads;
+}
+
+// The buffers the HTTP client hands to the RapidJSON fallback.
+struct JsonBuffers {
+    std::unique_ptr<JsonBufferType[]> value_{new JsonBufferType[kJsonValueBufferCap]};
+    std::unique_ptr<JsonBufferType[]> parse_{new JsonBufferType[kJsonParseBufferCap]};
+};
+
+void reportBytes(benchmark::State &state, size_t bytes) {
+    state.SetBytesProcessed((int64_t) state.iterations() * (int64_t) bytes);
+    state.counters["bytes_per_op"] = (double) bytes;
+}
+
+// The fallback parses in situ, so the body is copied back before every call as the HTTP client
+// receives a fresh one. The copy is a part of the measured time.
+template<class F>
+void registerUnmarshal(const std::string &func, const std::vector<Payload> &payloads, F unmarshal) {
+    for (const auto &payload : payloads) {
+        benchmark::RegisterBenchmark((func + "/" + payload.name_).c_str(),
+                                     [body = payload.body_, unmarshal](benchmark::State &state) {
+                                         JsonBuffers buffers;
+                                         std::string data;
+                                         data.reserve(body.size() + 1);
+                                         for (auto _ : state) {
+                                             data.assign(body);
+                                             unmarshal(data, buffers);
+                                         }
+                                         reportBytes(state, body.size());
+                                     });
+    }
+}
+
+template<class T, class F>
+void registerMarshal(const std::string &func, const std::vector<std::pair<std::string, T>> &values, F marshal) {
+    for (const auto &[name, value] : values) {
+        benchmark::RegisterBenchmark((func + "/" + name).c_str(),
+                                     [value = value, marshal](benchmark::State &state) {
+                                         std::string buffer;
+                                         for (auto _ : state) {
+                                             marshal(value, buffer);
+                                             benchmark::DoNotOptimize(buffer.data());
+                                         }
+                                         reportBytes(state, buffer.size());
+                                     });
+    }
+}
+
+// The marshal benchmarks take their values from the decoded corpus.
+template<class T, class F>
+std::vector<std::pair<std::string, T>> decodeCorpus(const std::vector<Payload> &payloads, F unmarshal) {
+    std::vector<std::pair<std::string, T>> values;
+    JsonBuffers buffers;
+    for (const auto &payload : payloads) {
+        auto data = payload.body_;
+        values.emplace_back(payload.name_, unmarshal(data, buffers));
+    }
+    return values;
+}
+
+bool registerJsonCodecBenchmarks() {
+    auto explores = loadCorpus("explore");
+    auto licenses = loadCorpus("license");
+    auto digs = loadCorpus("dig");
+    auto cashes = loadCorpus("cash");
+    auto errors = loadCorpus("error");
+    if (explores.empty() || licenses.empty() || digs.empty() || cashes.empty() || errors.empty()) {
+        std::cerr << "Payload corpus is not found in " << corpusDir() << ", set BENCH_CORPUS" << std::endl;
+    }
+
+    registerUnmarshal("unmarshalApiError", errors, [](std::string &data, JsonBuffers &b) {
+        benchmark::DoNotOptimize(unmarshalApiError(data, b.value_.get(), b.parse_.get()));
+    });
+    registerUnmarshal("unmarshalExploreResponse", explores, [](std::string &data, JsonBuffers &b) {
+        benchmark::DoNotOptimize(unmarshalExploreResponse(data, b.value_.get(), b.parse_.get()));
+    });
+    registerUnmarshal("unmarshalLicense", licenses, [](std::string &data, JsonBuffers &b) {
+        benchmark::DoNotOptimize(unmarshalLicense(data, b.value_.get(), b.parse_.get()));
+    });
+    registerUnmarshal("unmarshallWallet", cashes, [](std::string &data, JsonBuffers &b) {
+        Wallet wallet;
+        unmarshallWallet(data, b.value_.get(), b.parse_.get(), wallet);
+        benchmark::DoNotOptimize(wallet);
+    });
+    registerUnmarshal("unmarshalTreasuriesList", digs, [](std::string &data, JsonBuffers &b) {
+        Treasuries treasuries;
+        unmarshalTreasuriesList(data, b.value_.get(), b.parse_.get(), treasuries);
+        benchmark::DoNotOptimize(treasuries);
+    });
+
+    auto areas = decodeCorpus<Area>(explores, [](std::string &data, JsonBuffers &b) {
+        return unmarshalExploreResponse(data, b.value_.get(), b.parse_.get()).area_;
+    });
+    registerMarshal("marshalArea", areas, [](const Area &area, std::string &buffer) {
+        marshalArea(area, buffer);
+    });
+
+    std::vector<std::pair<std::string, DigRequest>> digRequests;
+    for (const auto &[name, area] : areas) {
+        digRequests.emplace_back(name, DigRequest(10, area.posX_, area.posY_, 10));
+    }
+    registerMarshal("marshalDig", digRequests, [](const DigRequest &request, std::string &buffer) {
+        marshalDig(request, buffer);
+    });
+
+    auto treasuries = decodeCorpus<Treasuries>(digs, [](std::string &data, JsonBuffers &b) {
+        Treasuries buf;
+        unmarshalTreasuriesList(data, b.value_.get(), b.parse_.get(), buf);
+        return buf;
+    });
+    std::vector<std::pair<std::string, TreasureID>> treasureIds;
+    for (const auto &[name, list] : treasuries) {
+        if (!list.empty()) {
+            treasureIds.emplace_back(name, list[0]);
+        }
+    }
+    registerMarshal("marshalTreasureId", treasureIds, [](const TreasureID &id, std::string &buffer) {
+        marshalTreasureId(id, buffer);
+    });
+
+    // the wallets are spent on paid licenses as is
+    auto wallets = decodeCorpus<Wallet>(cashes, [](std::string &data, JsonBuffers &b) {
+        Wallet wallet;
+        unmarshallWallet(data, b.value_.get(), b.parse_.get(), wallet);
+        return wallet;
+    });
+    registerMarshal("marshalIssueLicenseRequest", wallets, [](const Wallet &coins, std::string &buffer) {
+        marshalIssueLicenseRequest(coins, buffer);
+    });
+
+    benchmark::RegisterBenchmark("marshalFreeIssueLicenseRequest", [](benchmark::State &state) {
+        std::string buffer;
+        for (auto _ : state) {
+            marshalFreeIssueLicenseRequest(buffer);
+            benchmark::DoNotOptimize(buffer.data());
+        }
+        reportBytes(state, buffer.size());
+    });
+    return true;
+}
+
+const bool kJsonCodecBenchmarksRegistered = registerJsonCodecBenchmarks();
+
+}
@@ -0,0 +1,108 @@
+#include <benchmark/benchmark.h>
+#include <rapidjson/document.h>
+#include <string>
+#include "json_schema.h"
+
+namespace {
+
+const std::string kExploreBody = R"({"area":{"posX":1750,"posY":0,"sizeX":4,"sizeY":1},"amount":3})";
+const std::string kLicenseBody = R"({"id":12345,"digAllowed":29,"digUsed":0})";
+const std::string kWalletBody = "[3413,3414,3415,3416,3417,3418,3419,3420,3421,3422,3423,3424]";
+const std::string kTreasuriesBody = R"(["ZmM3MTE4ZjMtZDBlYy00NDk0LWE3YjYtNTVjZGY0NWU0ZWVh"])";
+
+// The DOM the RapidJSON fallback builds for every response.
+rapidjson::Document parseDom(const std::string &body) {
+    rapidjson::Document d;
+    d.Parse(body.data(), body.size());
+    return d;
+}
+
+void BM_ExploreResponseSchema(benchmark::State &state) {
+    ExploreResponse resp(Area(), 0);
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(decodeJson(kExploreBody, resp));
+    }
+    state.SetBytesProcessed((int64_t) state.iterations() * (int64_t) kExploreBody.size());
+}
+
+void BM_ExploreResponseRapidJson(benchmark::State &state) {
+    for (auto _ : state) {
+        auto d = parseDom(kExploreBody);
+        const auto &area = d["area"];
+        ExploreResponse resp(Area((int16_t) area["posX"].GetInt(), (int16_t) area["posY"].GetInt(),
+                                  (int16_t) area["sizeX"].GetInt(), (int16_t) area["sizeY"].GetInt()),
+                             (uint32_t) d["amount"].GetInt());
+        benchmark::DoNotOptimize(resp);
+    }
+    state.SetBytesProcessed((int64_t) state.iterations() * (int64_t) kExploreBody.size());
+}
+
+void BM_LicenseSchema(benchmark::State &state) {
+    License license;
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(decodeJson(kLicenseBody, license));
+    }
+    state.SetBytesProcessed((int64_t) state.iterations() * (int64_t) kLicenseBody.size());
+}
+
+void BM_LicenseRapidJson(benchmark::State &state) {
+    for (auto _ : state) {
+        auto d = parseDom(kLicenseBody);
+        License license(d["id"].GetInt(), (uint32_t) d["digAllowed"].GetInt(), (uint32_t) d["digUsed"].GetInt());
+        benchmark::DoNotOptimize(license);
+    }
+    state.SetBytesProcessed((int64_t) state.iterations() * (int64_t) kLicenseBody.size());
+}
+
+void BM_WalletSchema(benchmark::State &state) {
+    Wallet wallet;
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(decodeJson(kWalletBody, wallet));
+    }
+    state.SetBytesProcessed((int64_t) state.iterations() * (int64_t) kWalletBody.size());
+}
+
+void BM_WalletRapidJson(benchmark::State &state) {
+    Wallet wallet;
+    for (auto _ : state) {
+        wallet.coins.clear();
+        auto d = parseDom(kWalletBody);
+        for (auto &val : d.GetArray()) {
+            wallet.coins.push_back((uint32_t) val.GetInt());
+        }
+        benchmark::DoNotOptimize(wallet);
+    }
+    state.SetBytesProcessed((int64_t) state.iterations() * (int64_t) kWalletBody.size());
+}
+
+void BM_TreasuriesListSchema(benchmark::State &state) {
+    Treasuries treasuries;
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(decodeJson(kTreasuriesBody, treasuries));
+    }
+    state.SetBytesProcessed((int64_t) state.iterations() * (int64_t) kTreasuriesBody.size());
+}
+
+void BM_TreasuriesListRapidJson(benchmark::State &state) {
+    Treasuries treasuries;
+    for (auto _ : state) {
+        treasuries.clear();
+        auto d = parseDom(kTreasuriesBody);
+        for (auto &val : d.GetArray()) {
+            treasuries.emplace_back(val.GetString());
+        }
+        benchmark::DoNotOptimize(treasuries);
+    }
+    state.SetBytesProcessed((int64_t) state.iterations() * (int64_t) kTreasuriesBody.size());
+}
+
+}
+
+BENCHMARK(BM_ExploreResponseSchema);
+BENCHMARK(BM_ExploreResponseRapidJson);
+BENCHMARK(BM_LicenseSchema);
+BENCHMARK(BM_LicenseRapidJson);
+BENCHMARK(BM_WalletSchema);
+BENCHMARK(BM_WalletRapidJson);
+BENCHMARK(BM_TreasuriesListSchema);
+BENCHMARK(BM_TreasuriesListRapidJson);
@@ -7,39 +7,52 @@
 #include <thread>
 #include <memory>
 
-Api::Api(std::shared_ptr<Stats> stats, std::shared_ptr<Log> log) :
+Api::Api(std::shared_ptr<Stats> stats, std::shared_ptr<Log> log, size_t shardsCnt, std::shared_ptr<Broker> broker) :
         log_{log},
-        stats_{std::move(stats)} {
+        stats_{std::move(stats)},
+        broker_{std::move(broker)} {
+    for (size_t i = 0; i < shardsCnt; i++) {
+        responses_.push_back(std::make_unique<ResponsesQueue>());
+    }
     auto addressEnv = std::getenv("ADDRESS");
     address_ = "localhost";
     if (addressEnv != nullptr) {
         address_ = addressEnv;
     }
-    for (size_t i = 0; i < kApiThreadCount; i++) {
+    // the tuning harness runs stub servers on their own ports
+    auto portEnv = std::getenv("Port");
+    port_ = portEnv != nullptr ? portEnv : "8000";
+    for (size_t i = 0; i < workersCnt_; i++) {
         std::thread t(&Api::threadLoop, this);
         threads_.push_back(std::move(t));
     }
 }
 
 void Api::threadLoop() {
-    HttpClient client{stats_, address_, "8000", "http"};
+    HttpClient client{stats_, address_, port_, "http"};
     for (;;) {
         std::unique_lock lock(requestsMu_);
         requestCondVar_.wait(lock, [this] {
-            return stopped_ || !requests_.empty();
+            return stopped_ || hasDispatchableRequest();
         });
 
         if (stopped_) {
             break;
         }
 
-        if (requests_.empty()) {
+        if (requests_.empty() && cashLane_.empty()) {
             log_->error() << "Woken up but requests queue is empty";
             stats_->incWokenWithEmptyRequestsQueue();
             continue;
         }
 
-        Request r = std::move(requests_.extract(requests_.begin()).value());
+        Request r;
+        if (!cashLane_.empty() && (cashLanePromoted_ != 0 || requests_.empty())) {
+            r = std::move(cashLane_.extract(cashLane_.begin()).value());
+            stats_->incCashLaneDispatched(cashLanePromoted_ != 0);
+        } else {
+            r = std::move(requests_.extract(requests_.begin()).value());
+        }
 #ifdef _HLC_DEBUG
         if (r.type_ == ApiEndpointType::Dig) {
             for (const auto &it : requests_) {
@@ -56,10 +69,19 @@ void Api::threadLoop() {
         lock.unlock();
 
 //        app_.lock()->getRateLimiter().acquire(r.getCost());
+        if (broker_ != nullptr) {
+            broker_->rate_.acquire(r.getCost());
+        }
 
         inFlightRequestsCnt_++;
         auto ret = makeApiRequest(client, r);
         inFlightRequestsCnt_--;
+        // the freed worker may be the spare one a waiting background cash request needs
+        lock.lock();
+        if (!cashLane_.empty()) {
+            requestCondVar_.notify_one();
+        }
+        lock.unlock();
         if (ret.hasError()) {
             log_->error() << "Error during making API request: " << ret.error();
             throw std::runtime_error("Error during making API request");
@@ -104,8 +126,8 @@ Expected<Response> Api::makeApiRequest(HttpClient &client, Request &r) noexcept
             return Response(std::move(r), client.cash(cashRequest.treasureId_));
         }
         case ApiEndpointType::IssuePaidLicense: {
-            auto coinId = r.getIssueLicenseRequest();
-            return Response(std::move(r), client.issueLicense(coinId));
+            auto resp = client.issueLicense(r.getIssueLicenseRequest());
+            return Response(std::move(r), std::move(resp));
         }
         default: {
             log_->error() << "Unsupported request type: " << r.type_;
@@ -115,58 +137,98 @@ Expected<Response> Api::makeApiRequest(HttpClient &client, Request &r) noexcept
 }
 
 void Api::publishResponse(Response &&r) noexcept {
-    std::unique_lock lock(responsesMu_);
+    auto &queue = *responses_[r.getRequest().shard_];
+    std::unique_lock lock(queue.mu_);
 
-    responses_.push_back(std::move(r));
+    queue.responses_.push_back(std::move(r));
     lock.unlock();
-    responsesCondVar_.notify_one();
+    queue.condVar_.notify_one();
 }
 
 ExpectedVoid Api::scheduleCheckHealth() noexcept {
     return scheduleRequest(Request::NewCheckHealthRequest());
 }
 
-Response Api::getAvailableResponse() noexcept {
-    std::unique_lock lock(responsesMu_);
-    responsesCondVar_.wait(lock, [this] {
-        return !responses_.empty();
+Response Api::getAvailableResponse(uint8_t shard) noexcept {
+    auto &queue = *responses_[shard];
+    std::unique_lock lock(queue.mu_);
+    queue.condVar_.wait(lock, [&queue] {
+        return !queue.responses_.empty();
     });
 
-    auto r = std::move(responses_.front());
-    responses_.pop_front();
+    auto r = std::move(queue.responses_.front());
+    queue.responses_.pop_front();
 
     return r;
 }
 
-ExpectedVoid Api::scheduleExplore(ExploreAreaPtr area) noexcept {
-    return scheduleRequest(Request::NewExploreRequest(std::move(area)));
+ExpectedVoid Api::scheduleExplore(ExploreAreaPtr area, uint8_t shard) noexcept {
+    // an empty explore queue leaves nothing to request
+    if (area == nullptr) {
+        return NoErr;
+    }
+    auto r = Request::NewExploreRequest(std::move(area));
+    r.shard_ = shard;
+    return scheduleRequest(std::move(r));
+}
+
+ExpectedVoid Api::scheduleIssueFreeLicense(uint8_t shard) noexcept {
+    auto r = Request::NewIssueFreeLicenseRequest();
+    r.shard_ = shard;
+    return scheduleRequest(std::move(r));
 }
 
-ExpectedVoid Api::scheduleIssueFreeLicense() noexcept {
-    return scheduleRequest(Request::NewIssueFreeLicenseRequest());
+ExpectedVoid Api::scheduleIssuePaidLicense(Wallet coins, uint8_t shard) noexcept {
+    auto r = Request::NewIssuePaidLicenseRequest(std::move(coins));
+    r.shard_ = shard;
+    return scheduleRequest(std::move(r));
 }
 
-ExpectedVoid Api::scheduleIssuePaidLicense(CoinID coinId) noexcept {
-    return scheduleRequest(Request::NewIssuePaidLicenseRequest(coinId));
+ExpectedVoid Api::scheduleDig(DigRequest digRequest, uint8_t shard) noexcept {
+    auto r = Request::NewDigRequest(digRequest);
+    r.shard_ = shard;
+    return scheduleRequest(std::move(r));
 }
 
-ExpectedVoid Api::scheduleDig(DigRequest r) noexcept {
-    return scheduleRequest(Request::NewDigRequest(r));
+
+ExpectedVoid Api::scheduleCash(TreasureID id, int8_t depth, uint8_t shard) noexcept {
+    auto r = Request::NewCashRequest(std::move(id), depth);
+    r.shard_ = shard;
+    return scheduleRequest(std::move(r));
 }
 
+bool Api::hasDispatchableRequest() const noexcept {
+    if (!requests_.empty()) {
+        return true;
+    }
+    return !cashLane_.empty() &&
+           (cashLanePromoted_ != 0 || inFlightRequestsCnt_ < (int64_t) workersCnt_ - cashLaneReservedCnt_);
+}
 
-ExpectedVoid Api::scheduleCash(TreasureID id, int8_t depth) noexcept {
-    return scheduleRequest(Request::NewCashRequest(std::move(id), depth));
+void Api::setCashLanePromoted(bool promoted, uint8_t shard) noexcept {
+    auto bit = (uint32_t) 1 << shard;
+    auto prev = promoted ? cashLanePromoted_.fetch_or(bit) : cashLanePromoted_.fetch_and(~bit);
+    auto next = promoted ? prev | bit : prev & ~bit;
+    if ((prev != 0) == (next != 0)) {
+        return;
+    }
+    stats_->recordCashLanePromoted(next != 0);
+    if (next != 0) {
+        // wake the workers that skipped the lane for lack of spare capacity
+        std::scoped_lock lock(requestsMu_);
+        requestCondVar_.notify_all();
+    }
 }
 
 ExpectedVoid Api::scheduleRequest(Request r) noexcept {
     std::unique_lock lock(requestsMu_);
 
-    if (requests_.size() >= kMaxApiRequestsQueueSize) {
+    auto &queue = r.type_ == ApiEndpointType::Cash ? cashLane_ : requests_;
+    if (queue.size() >= kMaxApiRequestsQueueSize) {
         return ErrorCode::kMaxApiRequestsQueueSizeExceeded;
     }
 
-    requests_.insert(std::move(r));
+    queue.insert(std::move(r));
 
     lock.unlock();
     requestCondVar_.notify_one();
@@ -175,7 +237,7 @@ ExpectedVoid Api::scheduleRequest(Request r) noexcept {
 
 size_t Api::requestsQueueSize() noexcept {
     std::scoped_lock lock(requestsMu_);
-    return requests_.size();
+    return requests_.size() + cashLane_.size();
 }
 
 std::ostream &operator<<(std::ostream &os, const ApiEndpointType &type) {
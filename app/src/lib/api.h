@@ -18,6 +18,8 @@
 #include "api_entities.h"
 #include <set>
 #include "stats.h"
+#include "broker.h"
+#include "config.h"
 #include <ostream>
 
 enum class ApiEndpointType : int {
@@ -43,7 +45,9 @@ class Request {
     int32_t cost_{1};
 public:
     ApiEndpointType type_{0};
-    std::variant<ExploreAreaPtr, CoinID, DigRequest, CashRequest> request_;
+    // state shard the response is published to
+    uint8_t shard_{0};
+    std::variant<ExploreAreaPtr, Wallet, DigRequest, CashRequest> request_;
 
     Request() = default;
 
@@ -63,8 +67,8 @@ public:
         return cost_;
     }
 
-    CoinID getIssueLicenseRequest() const noexcept {
-        return std::get<CoinID>(request_);
+    [[nodiscard]] const Wallet &getIssueLicenseRequest() const noexcept {
+        return std::get<Wallet>(request_);
     }
 
     DigRequest getDigRequest() const noexcept {
@@ -90,11 +94,11 @@ public:
         return r;
     }
 
-    static Request NewIssuePaidLicenseRequest(CoinID coinId) noexcept {
+    static Request NewIssuePaidLicenseRequest(Wallet coins) noexcept {
         Request r{};
         r.priority = 3;
         r.type_ = ApiEndpointType::IssuePaidLicense;
-        r.request_ = coinId;
+        r.request_ = std::move(coins);
         return r;
     }
 
@@ -106,6 +110,7 @@ public:
         return r;
     }
 
+    // goes to the background cash lane, the priority only orders requests inside it
     static Request NewCashRequest(TreasureID id, int8_t depth) noexcept {
         Request r{};
         r.priority = 4;
@@ -137,19 +142,15 @@ public:
 
 };
 
+template<class T>
+using ApiResult = Expected<HttpResponse<T>>;
+
 class Response {
-    using HealthResponseWrapper = Expected<HttpResponse<HealthResponse>>;
-    using ExploreResponseWrapper = Expected<HttpResponse<ExploreResponse>>;
-    using IssueLicenseWrapper = Expected<HttpResponse<License>>;
-    using DigResponseWrapper = Expected<HttpResponse<std::vector<TreasureID>>>;
-    using CashResponseWrapper = Expected<HttpResponse<Wallet>>;
-
-    std::variant<HealthResponseWrapper, ExploreResponseWrapper, IssueLicenseWrapper,
-            DigResponseWrapper, CashResponseWrapper> response_;
+    std::variant<ApiResult<HealthResponse>, ApiResult<ExploreResponse>, ApiResult<License>,
+            ApiResult<Treasuries>, ApiResult<Wallet>> response_;
     Request request_;
 public:
 
-
     Response(const Response &r) = delete;
 
     Response(Response &&r) = default;
@@ -158,6 +159,11 @@ public:
 
     Response &operator=(Response &&r) = default;
 
+    template<class T>
+    Response(Request &&r, ApiResult<T> &&result) :
+            response_{std::in_place_type<ApiResult<T>>, std::move(result)},
+            request_{std::move(r)} {}
+
     [[nodiscard]] ApiEndpointType getType() const noexcept {
         return request_.type_;
     }
@@ -166,45 +172,24 @@ public:
         return request_;
     }
 
-    Response(Request &&r, Expected<HttpResponse<Wallet>> &&cashResponse) :
-            response_{std::move(cashResponse)},
-            request_{std::move(r)} {}
-
-    Response(Request &&r, Expected<HttpResponse<std::vector<TreasureID>>> &&digResponse) :
-            response_{std::move(digResponse)},
-            request_{std::move(r)} {}
-
-    Response(Request &&r, Expected<HttpResponse<License>> &&licenseResponse) :
-            response_{std::move(licenseResponse)},
-            request_{std::move(r)} {
+    // 0 for a transport error.
+    [[nodiscard]] int32_t getHttpCode() noexcept {
+        return std::visit([](auto &result) -> int32_t {
+            return result.hasError() ? 0 : result.value().getHttpCode();
+        }, response_);
     }
 
-    Response(Request &&r, Expected<HttpResponse<HealthResponse>> &&healthResponse)
-            : response_{std::move(healthResponse)},
-              request_{std::move(r)} {}
-
-    Response(Request &&r, ExploreResponseWrapper &&exploreResponse) :
-            response_{std::move(exploreResponse)},
-            request_{std::move(r)} {}
-
-    [[nodiscard]] HealthResponseWrapper &getHealthResponse() noexcept {
-        return std::get<HealthResponseWrapper>(response_);
-    }
-
-    [[nodiscard]] ExploreResponseWrapper &getExploreResponse() noexcept {
-        return std::get<ExploreResponseWrapper>(response_);
-    }
-
-    [[nodiscard]]IssueLicenseWrapper &getIssueLicenseResponse() noexcept {
-        return std::get<IssueLicenseWrapper>(response_);
-    }
-
-    [[nodiscard]] DigResponseWrapper &getDigResponse() noexcept {
-        return std::get<DigResponseWrapper>(response_);
-    }
-
-    [[nodiscard]] CashResponseWrapper &getCashResponse() noexcept {
-        return std::get<CashResponseWrapper>(response_);
+    // Calls the handler overload the result type is bound to at compile time, the overloads are
+    // reached through the visit jump table and get the request and the result in place.
+    // A transport error is returned to the caller without reaching the handler.
+    template<class Handler>
+    [[nodiscard]] ExpectedVoid dispatch(Handler &handler) noexcept {
+        return std::visit([this, &handler](auto &result) -> ExpectedVoid {
+            if (result.hasError()) {
+                return result.error();
+            }
+            return handler.processResponse(request_, result.value());
+        }, response_);
     }
 
 };
@@ -216,29 +201,49 @@ private:
     std::shared_ptr<Stats> stats_;
     std::atomic<bool> stopped_{false};
 
+    // API_THREADS of the startup config
+    size_t workersCnt_{runtimeConfig().get().apiThreadCount_};
+    // rounded down so a single worker still serves the lane
+    int64_t cashLaneReservedCnt_{(int64_t) ((double) workersCnt_ * kCashLaneReservedShare)};
     std::vector<std::thread> threads_;
 
     std::mutex requestsMu_;
     std::condition_variable requestCondVar_;
     std::multiset<Request> requests_;
+    // cash requests take only spare workers unless the lane is promoted
+    std::multiset<Request> cashLane_;
+    // shards that promoted the lane, one bit per shard
+    std::atomic<uint32_t> cashLanePromoted_{0};
+
+    struct ResponsesQueue {
+        std::mutex mu_;
+        std::list<Response> responses_;
+        std::condition_variable condVar_;
+    };
 
-    std::mutex responsesMu_;
-    std::list<Response> responses_;
-    std::condition_variable responsesCondVar_;
+    // one queue per state shard, each drained by its own thread
+    std::vector<std::unique_ptr<ResponsesQueue>> responses_;
 
     std::atomic<int64_t> inFlightRequestsCnt_{0};
     std::atomic<int64_t> inFlightExploreRequestsCnt_{0};
 
     std::string address_;
+    std::string port_;
+
+    // shards of several processes share the rate budget of the broker
+    std::shared_ptr<Broker> broker_;
 
     void threadLoop();
 
+    [[nodiscard]] bool hasDispatchableRequest() const noexcept;
+
     Expected<Response> makeApiRequest(HttpClient &client, Request &r) noexcept;
 
     void publishResponse(Response &&r) noexcept;
 
 public:
-    Api(std::shared_ptr<Stats> stats, std::shared_ptr<Log> log);
+    Api(std::shared_ptr<Stats> stats, std::shared_ptr<Log> log, size_t shardsCnt = 1,
+        std::shared_ptr<Broker> broker = nullptr);
 
     Api(const Api &o) = delete;
 
@@ -254,17 +259,17 @@ public:
 
     ExpectedVoid scheduleRequest(Request r) noexcept;
 
-    ExpectedVoid scheduleExplore(ExploreAreaPtr area) noexcept;
+    ExpectedVoid scheduleExplore(ExploreAreaPtr area, uint8_t shard = 0) noexcept;
 
-    ExpectedVoid scheduleIssueFreeLicense() noexcept;
+    ExpectedVoid scheduleIssueFreeLicense(uint8_t shard = 0) noexcept;
 
-    ExpectedVoid scheduleIssuePaidLicense(CoinID coinId) noexcept;
+    ExpectedVoid scheduleIssuePaidLicense(Wallet coins, uint8_t shard = 0) noexcept;
 
-    ExpectedVoid scheduleDig(DigRequest r) noexcept;
+    ExpectedVoid scheduleDig(DigRequest r, uint8_t shard = 0) noexcept;
 
-    ExpectedVoid scheduleCash(TreasureID id, int8_t depth) noexcept;
+    ExpectedVoid scheduleCash(TreasureID id, int8_t depth, uint8_t shard = 0) noexcept;
 
-    Response getAvailableResponse() noexcept;
+    Response getAvailableResponse(uint8_t shard = 0) noexcept;
 
     size_t requestsQueueSize() noexcept;
 
@@ -275,6 +280,8 @@ public:
     int64_t getInFlightExploreRequestsCnt() const noexcept {
         return inFlightExploreRequestsCnt_;
     }
+
+    void setCashLanePromoted(bool promoted, uint8_t shard = 0) noexcept;
 };
 
 #endif //HIGHLOADCUP2021_API_H
@@ -9,6 +9,10 @@
 #include <algorithm>
 #include <cassert>
 #include "util.h"
+#include "const.h"
+#include "inline_string.h"
+#include "small_vector.h"
+#include "memory.h"
 
 constexpr int32_t ApiErrorCodeUnknown = 1;
 
@@ -53,7 +57,7 @@ struct ExploreResponse {
 using CoinID = std::uint32_t;
 
 struct Wallet {
-    std::vector<CoinID> coins;
+    SmallVector<CoinID, kWalletInlineCoins> coins;
 
 //    Wallet() = default;
 //
@@ -67,7 +71,9 @@ struct Wallet {
 //
 };
 
-using TreasureID = std::string;
+using TreasureID = InlineString<kTreasureIdCap>;
+// treasures found by one dig
+using Treasuries = SmallVector<TreasureID, kDigTreasuresInlineCap>;
 using LicenseID = int32_t;
 
 struct License {
@@ -101,8 +107,11 @@ struct DigRequest {
 struct ExploreArea {
     using ExploreAreaPtr = std::shared_ptr<ExploreArea>;
 
-    std::shared_ptr<ExploreArea> parent_;
+    // the tree is owned top down through children_, so a subtree is freed with its root
+    std::weak_ptr<ExploreArea> parent_;
     std::vector<ExploreAreaPtr> children_;
+    // adjacent siblings explored together as one rectangle, the node itself is not a child of parent_
+    std::vector<ExploreAreaPtr> unionMembers_;
     Area area_;
     size_t actualTreasuriesCnt_{0};
     size_t exploredChildrenTreasuriesCnt_{0};
@@ -123,10 +132,15 @@ struct ExploreArea {
             exploreDepth_{exploreDepth},
             id_{getNextUniqueId()} {}
 
+    [[nodiscard]] ExploreAreaPtr getParent() const noexcept {
+        return parent_.lock();
+    }
+
     static ExploreAreaPtr
     NewExploreArea(ExploreAreaPtr parent, Area area, size_t exploreDepth,
                    size_t actualTreasuriesCnt) {
-        return std::make_shared<ExploreArea>(parent, area, exploreDepth, actualTreasuriesCnt);
+        return std::allocate_shared<ExploreArea>(ArenaAllocator<ExploreArea, MemoryArenaId::ExploreTree>(), parent,
+                                                 area, exploreDepth, actualTreasuriesCnt);
     }
 
     void addChild(ExploreAreaPtr child) noexcept {
@@ -159,8 +173,8 @@ struct ExploreArea {
 #ifdef _HLC_DEBUG
         assert(it != children_.end());
 #endif
-        // TODO swap better
-        std::iter_swap(it, children_.end() - childSwapsCnt_ - 1);
+        // explored children gather at the end, the rest keeps its order, e.g. the density prior ranking
+        std::rotate(it, it + 1, children_.end() - childSwapsCnt_);
         childSwapsCnt_++;
     }
 
@@ -192,6 +206,35 @@ struct ExploreArea {
         return nullptr;
     }
 
+    // Returns first followed by not explored and not requested siblings continuing it along one axis,
+    // so that every prefix of the result covers a rectangle.
+    [[nodiscard]] std::vector<ExploreAreaPtr>
+    getAdjacentChildrenForRequest(const ExploreAreaPtr &first, size_t maxCnt) const noexcept {
+        std::vector<ExploreAreaPtr> ret{first};
+        for (int axis = 0; axis < 2 && ret.size() == 1; axis++) {
+            for (bool found = true; found && ret.size() < maxCnt;) {
+                found = false;
+                const auto &last = ret.back()->area_;
+                for (const auto &c : children_) {
+                    if (c->explored_ || c->requestInFlight_) {
+                        continue;
+                    }
+                    const auto &a = c->area_;
+                    auto continuesY = axis == 0 && a.posX_ == last.posX_ && a.sizeX_ == last.sizeX_ &&
+                                      a.posY_ == last.posY_ + last.sizeY_;
+                    auto continuesX = axis == 1 && a.posY_ == last.posY_ && a.sizeY_ == last.sizeY_ &&
+                                      a.posX_ == last.posX_ + last.sizeX_;
+                    if (continuesY || continuesX) {
+                        ret.push_back(c);
+                        found = true;
+                        break;
+                    }
+                }
+            }
+        }
+        return ret;
+    }
+
     [[nodiscard]] ExploreAreaPtr getLastNonExploredChild() const noexcept {
         ExploreAreaPtr candidate{nullptr};
         int cnt{0};
@@ -5,11 +5,16 @@
 #include <memory>
 #include <limits>
 #include <cassert>
+#include <algorithm>
+#include <cstdlib>
+#include <sched.h>
 
-App::App(std::shared_ptr<Api> api, std::shared_ptr<Stats> stats, std::shared_ptr<Log> log) :
+App::App(std::shared_ptr<Api> api, std::shared_ptr<Stats> stats, std::shared_ptr<Log> log, ShardConfig shard) :
         log_{std::move(log)},
         api_{std::move(api)},
-        stats_{std::move(stats)} {
+        stats_{std::move(stats)},
+        shard_{std::move(shard)},
+        explorePlanner_{exploreSplitModeFromEnv(), explorePartitionSchemeFromEnv()} {
 #ifndef BUILD_TYPE
 #define BUILD_TYPE "unknown"
 #endif
@@ -19,6 +24,33 @@ App::App(std::shared_ptr<Api> api, std::shared_ptr<Stats> stats, std::shared_ptr
 #endif
 
     log_->info() << "Build type: " << BUILD_TYPE << " commit hash: " << COMMIT_HASH;
+    log_->info() << "State shard: " << (int) shard_.index_ << "/" << (int) shard_.cnt_ << " strip x: "
+                 << shard_.region_.posX_ << "+" << shard_.region_.sizeX_ << " licenses: " << shard_.licensesQuota_;
+    log_->info() << "Explore split mode: " << explorePlanner_.getMode() << " partition: "
+                 << explorePlanner_.getScheme();
+    log_->info() << "Speculative dig: " << speculativeDigs_.isEnabled();
+    log_->info() << "Game duration: " << timeBudget_.getGameDuration().count() << " ms end game mode: "
+                 << endGameModeFromEnv();
+    // the density map covers the whole field, shards would overwrite each other's observations
+    if (auto path = std::getenv("DENSITY_MAP_PATH"); path != nullptr && shard_.cnt_ == 1) {
+        densityMapPath_ = path;
+        if (auto err = densityMap_.load(densityMapPath_); err.hasError()) {
+            log_->warn() << "density prior is not loaded from " << densityMapPath_ << ": " << err.error();
+        } else {
+            log_->info() << "Density prior loaded from " << densityMapPath_;
+        }
+        densityMapWriter_.start(densityMapPath_, [log = log_, stats = stats_, path = densityMapPath_](
+                int64_t saveMcs, ErrorCode err) {
+            if (err != ErrorCode::kNoErr) {
+                log->warn() << "density map is not saved to " << path << ": " << err;
+            }
+            stats->addDensityMapSaveTime(saveMcs);
+        });
+    }
+    // a restored game takes the license records over from the snapshot first
+    if (snapshot_.isEnabled() && !snapshot_.isRestorable()) {
+        state_.getLicenseManager().setMirror(snapshot_.getLicenses());
+    }
     if (auto val = curl_global_init(CURL_GLOBAL_ALL)) {
         log_->error() << "curl global init failed: " << val;
         throw std::runtime_error("curl init failed");
@@ -30,28 +62,191 @@ App::~App() {
     curl_global_cleanup();
 }
 
+CellGrid *App::openSnapshot() noexcept {
+    auto path = snapshotPathFromEnv(shard_.index_, shard_.cnt_);
+    if (path.empty()) {
+        return nullptr;
+    }
+    if (auto err = snapshot_.open(path, shard_.index_, shard_.region_, gameDurationFromEnv()); err.hasError()) {
+        log_->warn() << "snapshot is not opened at " << path << ": " << err.error();
+        return nullptr;
+    }
+    log_->info() << "Snapshot: " << path << " restorable: " << snapshot_.isRestorable();
+    snapshot_.setOnWritten([stats = stats_](int64_t writeMcs, size_t bytes) {
+        stats->recordSnapshotWrite(writeMcs, bytes);
+    });
+    return snapshot_.getCells();
+}
+
 ExpectedVoid App::fireInitRequests() noexcept {
-    for (size_t i = 0; i < kMaxLicensesCount; i++) {
+    if (snapshot_.isRestorable()) {
+        return restoreSnapshot();
+    }
+    for (size_t i = 0; i < shard_.licensesQuota_; i++) {
         if (auto err = scheduleIssueLicense(); err.hasError()) {
             return err;
         }
     }
+    return startExplore();
+}
+
+ExpectedVoid App::startExplore() noexcept {
+    if (shard_.cnt_ > 1) {
+        // the amount of treasures of a strip is unknown, it is split once its explore is processed
+        auto root = ExploreArea::NewExploreArea(nullptr, shard_.region_, 0, 0);
+        state_.setRootExploreArea(root);
+        exploreInFlight_++;
+        return api_->scheduleExplore(std::move(root), shard_.id_);
+    }
     auto root = ExploreArea::NewExploreArea(nullptr, Area(0, 0, kFieldMaxX, kFieldMaxY), 0,
                                             kTreasuriesCount);
     state_.setRootExploreArea(root);
+    rootExplored_ = true;
     if (auto err = createSubAreas(root); err.hasError()) {
         return err.error();
     }
 
-    for (size_t i = 0; i < kExploreConcurrentRequestsCnt; i++) {
-        if (auto err = api_->scheduleExplore(state_.fetchNextExploreArea()); err.hasError()) {
+    return scheduleExplores();
+}
+
+ExpectedVoid App::restoreSnapshot() noexcept {
+    Measure<std::chrono::microseconds> tm;
+    restored_ = true;
+    auto elapsed = snapshot_.getGameElapsed();
+    timeBudget_.rebase(GameClock::now() - elapsed);
+    coinSpendOptimizer_.rebase(LicenseClock::now() - elapsed);
+
+    // digs in flight are lost, so the used ones are taken as confirmed and exhausted licenses are dropped
+    std::vector<License> licenses;
+    auto mirror = snapshot_.getLicenses();
+    for (size_t i = 0; i < LicenseManager::kRecordsCap; i++) {
+        const auto &license = mirror[i].license_;
+        if (mirror[i].inUse_ != 0 && license.digUsed_ < license.digAllowed_) {
+            licenses.push_back(license);
+            licenses.back().digConfirmed_ = license.digUsed_;
+        }
+    }
+    state_.getLicenseManager().setMirror(mirror);
+    for (const auto &license : licenses) {
+        if (auto idle = state_.addLicence(license); idle.hasError()) {
+            return idle.error();
+        }
+    }
+
+    snapshot_.read(snapshotData_);
+    Wallet wallet;
+    for (auto coin : snapshotData_.coins_) {
+        wallet.coins.push_back(coin);
+    }
+    state_.addCoins(wallet);
+
+    int64_t restoredCells{0};
+    int64_t lostCells{0};
+    const auto &r = shard_.region_;
+    for (auto x = r.posX_; x < r.posX_ + r.sizeX_; x++) {
+        for (auto y = r.posY_; y < r.posY_ + r.sizeY_; y++) {
+            auto &cell = state_.getCell(x, y);
+            if ((cell.flags_ & kCellDigInFlight) != 0) {
+                // the server may have processed the dig, the next depth is unknown
+                cell.flags_ = kCellLost;
+                cell.left_ = 0;
+                lostCells++;
+                continue;
+            }
+            // the speculatively dug areas are not restored
+            if ((cell.flags_ & kCellSpeculative) != 0) {
+                cell.left_ = 0;
+                continue;
+            }
+            if (cell.left_ > 0 && (size_t) cell.dugDepth_ < kMaxDigDepth) {
+                restoredCells++;
+                if (auto err = scheduleDigRequest(x, y, (int8_t) (cell.dugDepth_ + 1)); err.hasError()) {
+                    return err;
+                }
+            }
+        }
+    }
+
+    for (const auto &cash : snapshotData_.cash_) {
+        if (auto err = scheduleCash(cash.treasureId_, cash.depth_); err.hasError()) {
             return err;
         }
     }
-    return NoErr;
+
+    for (auto i = licenses.size(); i < shard_.licensesQuota_; i++) {
+        if (auto err = scheduleIssueLicense(); err.hasError()) {
+            return err;
+        }
+    }
+    stats_->recordSnapshotRestore(tm.getInt64(), restoredCells, lostCells);
+    log_->info() << "Snapshot restored: game elapsed " << elapsed.count() << " ms licenses " << licenses.size()
+                 << " coins " << snapshotData_.coins_.size() << " cells " << restoredCells << " lost " << lostCells
+                 << " frontier " << snapshotData_.frontier_.size() << " cash " << snapshotData_.cash_.size();
+    if (!snapshotData_.rootExplored_) {
+        return startExplore();
+    }
+
+    // the frontier areas hang off a synthetic root, they are never explored again
+    auto root = ExploreArea::NewExploreArea(nullptr, shard_.region_, 0, 0);
+    root->explored_ = true;
+    state_.setRootExploreArea(root);
+    rootExplored_ = true;
+    size_t childIdx{0};
+    for (const auto &frontier : snapshotData_.frontier_) {
+        if (childIdx + frontier.childrenCnt_ > snapshotData_.childAreas_.size()) {
+            return ErrorCode::kSnapshotError;
+        }
+        auto parent = ExploreArea::NewExploreArea(root, frontier.area_, frontier.exploreDepth_,
+                                                  frontier.leftTreasuriesCnt_);
+        parent->explored_ = true;
+        root->children_.push_back(parent);
+        for (uint32_t i = 0; i < frontier.childrenCnt_; i++) {
+            parent->addChild(ExploreArea::NewExploreArea(parent, snapshotData_.childAreas_[childIdx++],
+                                                         frontier.exploreDepth_ + 1, 0));
+        }
+        if (parent->getNonExploredChildrenCnt() == 1) {
+            auto child = parent->getLastNonExploredChild();
+            if (auto err = processExploredArea(child, parent->getLeftTreasuriesCnt()); err.hasError()) {
+                return err;
+            }
+        } else if (parent->getNonExploredChildrenCnt() > 1) {
+            state_.addExploreArea(parent);
+        }
+    }
+    return scheduleExplores();
+}
+
+void App::takeSnapshot() noexcept {
+    snapshotTakenAt_ = std::chrono::steady_clock::now();
+    Measure<std::chrono::microseconds> tm;
+    snapshotData_.clear();
+    snapshotData_.rootExplored_ = rootExplored_;
+    for (const auto &area : state_.getExploreAreas()) {
+        uint32_t childrenCnt{0};
+        for (const auto &child : area->children_) {
+            if (!child->explored_) {
+                snapshotData_.childAreas_.push_back(child->area_);
+                childrenCnt++;
+            }
+        }
+        snapshotData_.frontier_.push_back(SnapshotFrontierArea{area->area_, (uint32_t) area->getLeftTreasuriesCnt(),
+                                                               (uint32_t) area->exploreDepth_, childrenCnt});
+    }
+    snapshotData_.coins_.assign(state_.getCoins().begin(), state_.getCoins().end());
+    for (const auto &[id, depth] : pendingCash_) {
+        snapshotData_.cash_.push_back(SnapshotCash{id, depth});
+    }
+    cashPolicy_.forEachDeferred([this](const TreasureID &id, int8_t depth) {
+        snapshotData_.cash_.push_back(SnapshotCash{id, depth});
+    });
+    auto submitted = snapshot_.submit(snapshotData_);
+    stats_->recordSnapshotCapture(tm.getInt64(), submitted);
 }
 
 void App::run() noexcept {
+    if (auto err = placeAppThread(shard_.id_); err.hasError()) {
+        log_->warn() << "app thread of shard " << (int) shard_.id_ << " is not placed: " << err.error();
+    }
     if (auto err = fireInitRequests(); err.hasError()) {
         log_->error() << "fireInitRequests: error: " << err.error();
         return;
@@ -62,11 +257,17 @@ void App::run() noexcept {
             break;
         }
 
-        auto response = api_->getAvailableResponse();
+        auto response = api_->getAvailableResponse(shard_.id_);
 
         Measure<std::chrono::nanoseconds> tm;
         auto err = processResponse(response);
         stats_->addProcessResponseTime(tm.getInt64());
+        if (auto cpu = sched_getcpu(); cpu != appCpu_) {
+            if (appCpu_ >= 0) {
+                stats_->incAppThreadMigrations();
+            }
+            appCpu_ = cpu;
+        }
         if (err.hasError()) {
             if (err.error() != ErrorCode::kErrCurlTimeout) {
                 log_->error() << "error occurred: " << err.error();
@@ -80,60 +281,127 @@ void App::run() noexcept {
             }
         }
 
-        stats_->recordInUseLicenses(state_.getInUseLicensesCount());
-        stats_->recordCoinsAmount(state_.getCoinsAmount());
-    }
-
-}
+        if (timeBudget_.update(GameClock::now())) {
+            auto phase = timeBudget_.getPhase();
+            log_->info() << "Game phase: " << phase << " time left: "
+                         << timeBudget_.getTimeLeft(GameClock::now()).count() << " ms";
+            stats_->recordGamePhase((int) phase);
+            if (phase == GamePhase::CashOnly) {
+                if (auto errCash = scheduleDeferredCash(cashPolicy_.getDeferredCnt()); errCash.hasError()) {
+                    log_->error() << "error occurred: " << errCash.error();
+                    return;
+                }
+            }
+        }
 
-ExpectedVoid App::processResponse(Response &resp) noexcept {
-    switch (resp.getType()) {
-        case ApiEndpointType::Explore: {
-            if (resp.getExploreResponse().hasError()) {
-                return resp.getExploreResponse().error();
+        auto dueReplacements = 0;
+        auto dueRetries = 0;
+        if (timeBudget_.allows(GamePhase::NoLicenses)) {
+            dueReplacements = state_.getLicenseManager().fetchDueReplacements(LicenseClock::now());
+            dueRetries = state_.getLicenseManager().fetchDueRetries(LicenseClock::now());
+        }
+        for (auto i = 0; i < dueRetries; i++) {
+            if (auto errIssue = scheduleIssueLicense(); errIssue.hasError()) {
+                log_->error() << "error occurred: " << errIssue.error();
+                return;
             }
-            auto apiResp = resp.getExploreResponse().get();
-            Measure<std::chrono::nanoseconds> tm;
-            auto err = processExploreResponse(resp.getRequest(), apiResp);
-            stats_->addProcessExploreResponseTime(tm.getInt64());
-            return err;
         }
-        case ApiEndpointType::IssueFreeLicense: {
-            if (resp.getIssueLicenseResponse().hasError()) {
-                return resp.getIssueLicenseResponse().error();
+        for (auto i = 0; i < dueReplacements; i++) {
+            if (auto errIssue = scheduleIssueLicense(); errIssue.hasError()) {
+                log_->error() << "error occurred: " << errIssue.error();
+                return;
             }
-            auto apiResp = resp.getIssueLicenseResponse().get();
-            return processIssueLicenseResponse(resp.getRequest(), apiResp);
+            stats_->incEarlyLicenseIssues();
         }
-        case ApiEndpointType::Dig: {
-            if (resp.getDigResponse().hasError()) {
-                return resp.getDigResponse().error();
+
+        if (shard_.broker_ != nullptr) {
+            exchangeCoins();
+            if (auto errSlots = takeSpareLicenseSlots(); errSlots.hasError()) {
+                log_->error() << "error occurred: " << errSlots.error();
+                return;
             }
-            auto apiResp = resp.getDigResponse().get();
-            return processDigResponse(resp.getRequest(), apiResp);
         }
-        case ApiEndpointType::Cash: {
-            if (resp.getCashResponse().hasError()) {
-                return resp.getCashResponse().error();
+
+        api_->setCashLanePromoted(shouldPromoteCash(), shard_.id_);
+        if (shouldCashAll()) {
+            if (auto errCash = scheduleDeferredCash(kCashPolicyDrainBatch); errCash.hasError()) {
+                log_->error() << "error occurred: " << errCash.error();
+                return;
             }
-            auto apiResp = resp.getCashResponse().get();
-            return processCashResponse(resp.getRequest(), apiResp);
         }
-        case ApiEndpointType::IssuePaidLicense: {
-            if (resp.getIssueLicenseResponse().hasError()) {
-                return resp.getIssueLicenseResponse().error();
+
+        auto digCapacity = (double) licenseSlots_ * state_.getLicenseManager().getAvgDigAllowed();
+        if (exploreController_.update(std::chrono::steady_clock::now(), state_.getQueuedDigRequestsCount(),
+                                      digCapacity)) {
+            stats_->recordExploreController(exploreController_.getSetpoint(), exploreController_.getBacklog(),
+                                            exploreController_.getConcurrency());
+            if (auto errExplore = scheduleExplores(); errExplore.hasError()) {
+                log_->error() << "error occurred: " << errExplore.error();
+                return;
             }
-            auto apiResp = resp.getIssueLicenseResponse().get();
-            return processIssueLicenseResponse(resp.getRequest(), apiResp);
         }
-        default: {
-            log_->error() << "unknown response type: " << resp.getType();
-            break;
+
+        stats_->recordInUseLicenses(state_.getInUseLicensesCount());
+        stats_->recordCoinsAmount(state_.getCoinsAmount());
+
+        if (runtimeConfig().takeReloadRequest()) {
+            reloadConfig();
+        }
+        if (const auto &config = runtimeConfig().get(); config.version_ != configVersion_) {
+            applyConfig(config);
+        }
+
+        if (!densityMapPath_.empty() &&
+            std::chrono::steady_clock::now() - densityMapSavedAt_ >= std::chrono::milliseconds(kDensityMapSavePeriodMs)) {
+            saveDensityMap();
         }
+
+        if (snapshot_.isEnabled() &&
+            std::chrono::steady_clock::now() - snapshotTakenAt_ >= std::chrono::milliseconds(kSnapshotPeriodMs)) {
+            takeSnapshot();
+        }
+    }
+
+    if (!densityMapPath_.empty()) {
+        // the process may exit right after the game, so the last copy is waited for
+        densityMapWriter_.flush();
+        saveDensityMap();
+        densityMapWriter_.flush();
     }
+
+}
+
+void App::startGameClock() noexcept {
+    gameClockStarted_ = true;
+    // a restored game keeps the start of the crashed process
+    if (restored_) {
+        return;
+    }
+    timeBudget_.rebase(GameClock::now());
+    coinSpendOptimizer_.rebase(LicenseClock::now());
+    snapshot_.markGameStarted();
+    log_->info() << "Game clock started";
+}
+
+ExpectedVoid App::processResponse(Response &resp) noexcept {
+    if (!gameClockStarted_ && resp.getHttpCode() == 200) {
+        startGameClock();
+    }
+    return resp.dispatch(*this);
+}
+
+ExpectedVoid App::processResponse(Request &req, HttpResponse<HealthResponse> &) noexcept {
+    log_->error() << "unknown response type: " << req.type_;
     return ErrorCode::kUnknownRequestType;
 }
 
+ExpectedVoid App::processResponse(Request &req, HttpResponse<ExploreResponse> &resp) noexcept {
+    Measure<std::chrono::nanoseconds> tm;
+    auto err = processExploreResponse(req, resp);
+    stats_->addProcessExploreResponseTime(tm.getInt64());
+    return err;
+}
+
 ExpectedVoid
 App::processExploredArea(ExploreAreaPtr exploreArea, size_t actualTreasuriesCnt) noexcept {
 #ifdef _HLC_DEBUG
@@ -145,18 +413,24 @@ App::processExploredArea(ExploreAreaPtr exploreArea, size_t actualTreasuriesCnt)
         return NoErr;
     }
     stats_->incExploredArea(exploreArea->area_.getArea());
+    densityMap_.recordExploredArea(exploreArea->area_, actualTreasuriesCnt);
     exploreArea->actualTreasuriesCnt_ = actualTreasuriesCnt;
     exploreArea->explored_ = true;
-    state_.removeExploreAreaFromQueue(exploreArea->parent_);
-    exploreArea->parent_->updateChildExplored(exploreArea);
-    if (exploreArea->parent_->getLeftTreasuriesCnt() > 0) {
-        state_.addExploreArea(exploreArea->parent_);
+    auto parent = exploreArea->getParent();
+    state_.removeExploreAreaFromQueue(parent);
+    parent->updateChildExplored(exploreArea);
+    if (parent->getLeftTreasuriesCnt() > 0) {
+        state_.addExploreArea(parent);
     }
 #ifdef _HLC_DEBUG
     assert(exploreArea->area_.posX_ == xBefore && exploreArea->area_.posY_ == yBefore);
 #endif
 
     if (exploreArea->actualTreasuriesCnt_ > 0 && exploreArea->area_.getArea() == 1) {
+        // the frontier of a restored game is stale, its cells may be dug already
+        if (restored_ && state_.isCellKnown(exploreArea->area_.posX_, exploreArea->area_.posY_)) {
+            return NoErr;
+        }
         stats_->recordTreasuriesCnt((int) exploreArea->actualTreasuriesCnt_);
         state_.setLeftTreasuriesAmount(exploreArea->area_.posX_, exploreArea->area_.posY_,
                                        (int32_t) exploreArea->actualTreasuriesCnt_);
@@ -168,6 +442,13 @@ App::processExploredArea(ExploreAreaPtr exploreArea, size_t actualTreasuriesCnt)
     }
 
     if (exploreArea->area_.getArea() > 1 && exploreArea->actualTreasuriesCnt_ > 0) {
+        auto speculated = trySpeculativeDig(exploreArea);
+        if (speculated.hasError()) {
+            return speculated.error();
+        }
+        if (speculated.get()) {
+            return NoErr;
+        }
         if (auto err = createSubAreas(exploreArea); err.hasError()) {
             return err.error();
         }
@@ -176,45 +457,248 @@ App::processExploredArea(ExploreAreaPtr exploreArea, size_t actualTreasuriesCnt)
     return NoErr;
 }
 
+Expected<bool> App::trySpeculativeDig(const ExploreAreaPtr &exploreArea) noexcept {
+    // speculative digs only take spare license capacity
+    if (state_.hasQueuedDigRequests()) {
+        return false;
+    }
+    auto area = exploreArea->area_.getArea();
+    auto exploreCost = explorePlanner_.getExpectedCost(area, (double) exploreArea->actualTreasuriesCnt_);
+    auto digCost = (double) timeBudget_.getStageLatencyMcs(PipelineStage::Dig) +
+                   coinSpendOptimizer_.licenseCostPerDig(
+                           (double) timeBudget_.getStageLatencyMcs(PipelineStage::License));
+    if (!speculativeDigs_.shouldSpeculate(*exploreArea, exploreCost, digCost,
+                                          state_.getLicenseManager().getAvailableDigsCount())) {
+        return false;
+    }
+
+    speculativeDigs_.start(exploreArea);
+    stats_->incSpeculativeDigAreas();
+    stats_->recordTreasuriesCnt((int) exploreArea->actualTreasuriesCnt_);
+    const auto &a = exploreArea->area_;
+    for (auto x = a.posX_; x < a.posX_ + a.sizeX_; x++) {
+        for (auto y = a.posY_; y < a.posY_ + a.sizeY_; y++) {
+            state_.setLeftTreasuriesAmount(x, y, (int32_t) exploreArea->actualTreasuriesCnt_);
+            state_.markSpeculative(x, y);
+            if (auto err = scheduleDigRequest(x, y, 1); err.hasError()) {
+                return err.error();
+            }
+        }
+    }
+    return true;
+}
+
+ExpectedVoid App::processSpeculativeDig(const DigRequest &digRequest, size_t treasuriesCnt) noexcept {
+    auto exploreArea = speculativeDigs_.find(digRequest.posX_, digRequest.posY_);
+    exploreArea->exploredChildrenTreasuriesCnt_ += treasuriesCnt;
+    auto areaLeftCount = (int32_t) exploreArea->getLeftTreasuriesCnt();
+    if (areaLeftCount == 0) {
+        // every treasure of the area is found, queued and in flight digs of its cells stop here
+        const auto &a = exploreArea->area_;
+        for (auto x = a.posX_; x < a.posX_ + a.sizeX_; x++) {
+            for (auto y = a.posY_; y < a.posY_ + a.sizeY_; y++) {
+                state_.setLeftTreasuriesAmount(x, y, 0);
+            }
+        }
+        speculativeDigs_.finishArea(*exploreArea);
+        return NoErr;
+    }
+
+    auto leftCount = state_.getLeftTreasuriesAmount(digRequest.posX_, digRequest.posY_) - (int32_t) treasuriesCnt;
+    leftCount = std::min(leftCount, areaLeftCount);
+    if ((size_t) digRequest.depth_ >= kMaxDigDepth) {
+        leftCount = 0;
+        speculativeDigs_.finishCell(digRequest.posX_, digRequest.posY_);
+    }
+    if (leftCount < 0) {
+        return ErrorCode::kTreasuriesLeftInconsistency;
+    }
+    state_.setLeftTreasuriesAmount(digRequest.posX_, digRequest.posY_, leftCount);
+    if (leftCount > 0) {
+        return scheduleDigRequest(digRequest.posX_, digRequest.posY_, (int8_t) (digRequest.depth_ + 1));
+    }
+    return NoErr;
+}
+
 ExpectedVoid App::processExploreResponse(Request &req, HttpResponse<ExploreResponse> &resp) noexcept {
     if (resp.getHttpCode() != 200) {
-        return api_->scheduleExplore(req.getExploreRequest());
+        return api_->scheduleExplore(req.getExploreRequest(), shard_.id_);
     }
-    auto successResp = std::move(resp).getResponse();
+    exploreInFlight_--;
+    const auto &successResp = resp.getResponse();
     auto exploreArea = req.getExploreRequest();
+    explorePlanner_.recordExploreLatency(exploreArea->area_.getArea(), resp.getLatencyMcs().count());
+    timeBudget_.recordStageLatency(PipelineStage::Explore, resp.getLatencyMcs());
 
-    if (auto err = processExploredArea(exploreArea, successResp.amount_); err.hasError()) {
-        return err.error();
+    auto parent = exploreArea->getParent();
+    if (parent == nullptr) {
+        exploreArea->actualTreasuriesCnt_ = successResp.amount_;
+        exploreArea->explored_ = true;
+        rootExplored_ = true;
+        stats_->incExploredArea(exploreArea->area_.getArea());
+        if (exploreArea->actualTreasuriesCnt_ > 0) {
+            if (auto err = createSubAreas(exploreArea); err.hasError()) {
+                return err.error();
+            }
+        }
+        return scheduleExplores();
     }
 
-    if (exploreArea->parent_->getNonExploredChildrenCnt() == 1) {
-        auto child = exploreArea->parent_->getLastNonExploredChild();
-        if (auto err = processExploredArea(child, exploreArea->parent_->getLeftTreasuriesCnt()); err.hasError()) {
+    if (!exploreArea->unionMembers_.empty()) {
+        if (auto err = processSiblingUnionExplored(exploreArea, successResp.amount_); err.hasError()) {
             return err.error();
         }
+        return scheduleExplores();
+    }
+
+    if (auto err = processExploredArea(exploreArea, successResp.amount_); err.hasError()) {
+        return err.error();
+    }
+
+    if (auto err = inferExploredChildren(parent); err.hasError()) {
+        return err.error();
     }
 
 #ifdef _HLC_DEBUG
     assert(state_.hasMoreExploreAreas());
 #endif
 
-    return api_->scheduleExplore(state_.fetchNextExploreArea());
+    return scheduleExplores();
+}
+
+ExpectedVoid App::scheduleExplores() noexcept {
+    if (!timeBudget_.allows(GamePhase::NoExplore)) {
+        return NoErr;
+    }
+    while (exploreInFlight_ < exploreController_.getConcurrency()) {
+        auto exploreArea = state_.fetchNextExploreArea();
+        if (exploreArea == nullptr) {
+            break;
+        }
+        if (siblingUnion_) {
+            exploreArea = createSiblingUnion(exploreArea);
+        }
+        if (auto err = api_->scheduleExplore(std::move(exploreArea), shard_.id_); err.hasError()) {
+            return err;
+        }
+        exploreInFlight_++;
+    }
+    return NoErr;
+}
+
+ExploreAreaPtr App::createSiblingUnion(const ExploreAreaPtr &first) noexcept {
+    if (first == nullptr) {
+        return first;
+    }
+    auto parent = first->getParent();
+    auto density = parent->expectedChildTreasuriesCnt_;
+    // a union of two areas is empty with probability below e^-2, no chance to pay off
+    if (density * (double) first->area_.getArea() > 1.0) {
+        return first;
+    }
+
+    auto siblings = parent->getAdjacentChildrenForRequest(first, kExploreSiblingUnionMaxMembers);
+    auto membersCnt = explorePlanner_.planSiblingUnion(siblings, density);
+    if (membersCnt < 2) {
+        return first;
+    }
+    siblings.resize(membersCnt);
+    if (exploreInference_.query(parent, siblings).has_value()) {
+        return first;
+    }
+
+    auto x1 = first->area_.posX_;
+    auto y1 = first->area_.posY_;
+    const auto &last = siblings.back()->area_;
+    auto exploreUnion = ExploreArea::NewExploreArea(
+            parent,
+            Area(x1, y1, (int16_t) (last.posX_ + last.sizeX_ - x1), (int16_t) (last.posY_ + last.sizeY_ - y1)),
+            first->exploreDepth_,
+            0
+    );
+    for (const auto &member : siblings) {
+        member->requestInFlight_ = true;
+    }
+    exploreUnion->unionMembers_ = std::move(siblings);
+    stats_->recordSiblingUnionExplore(exploreUnion->unionMembers_.size());
+    return exploreUnion;
+}
+
+ExpectedVoid
+App::processSiblingUnionExplored(const ExploreAreaPtr &exploreUnion, size_t actualTreasuriesCnt) noexcept {
+    for (const auto &member : exploreUnion->unionMembers_) {
+        member->requestInFlight_ = false;
+    }
+    if (actualTreasuriesCnt == 0) {
+        stats_->incEmptySiblingUnionExplored();
+    }
+    auto parent = exploreUnion->getParent();
+    exploreInference_.addConstraint(parent, std::move(exploreUnion->unionMembers_), actualTreasuriesCnt);
+    exploreUnion->unionMembers_.clear();
+    return inferExploredChildren(parent);
+}
+
+ExpectedVoid App::inferExploredChildren(const ExploreAreaPtr &parent) noexcept {
+    std::vector<InferredArea> inferred;
+    exploreInference_.derive(parent, inferred);
+    // the last unexplored child is the parent minus its siblings and the children of a parent without
+    // treasures left were never requested either, both were known before the engine
+    auto savesRequests = parent->getNonExploredChildrenCnt() > 1 && parent->getLeftTreasuriesCnt() > 0;
+    for (const auto &[child, treasuriesCnt] : inferred) {
+        if (!child->requestInFlight_ && savesRequests) {
+            stats_->incInferredExplored();
+        }
+        if (auto err = processExploredArea(child, treasuriesCnt); err.hasError()) {
+            return err.error();
+        }
+    }
+    if (parent->getNonExploredChildrenCnt() == 0) {
+        exploreInference_.forget(parent);
+    }
+    return NoErr;
 }
 
-ExpectedVoid App::processIssueLicenseResponse([[maybe_unused]]Request &req, HttpResponse<License> &resp) noexcept {
-    if (resp.getHttpCode() >= 400 && resp.getHttpCode() < 500) {
-        auto errResp = std::move(resp).getErrResponse();
-        errorf("processIssueLicenseResponse: err code: %d err message: %s", errResp.errorCode_,
-               errResp.message_.c_str());
+ExpectedVoid App::processIssueLicenseResponse(Request &req, HttpResponse<License> &resp) noexcept {
+    state_.getLicenseManager().recordIssueLatency(resp.getLatencyMcs());
+    timeBudget_.recordStageLatency(PipelineStage::License, resp.getLatencyMcs());
+    auto isClientErr = resp.getHttpCode() >= 400 && resp.getHttpCode() < 500;
+    if (req.type_ == ApiEndpointType::IssuePaidLicense) {
+        state_.refundLicenseCoins(req.getIssueLicenseRequest(), resp.getHttpCode(),
+                                  isClientErr ? resp.getErrResponse().errorCode_ : 0);
+    }
+    if (isClientErr) {
+        const auto &errResp = resp.getErrResponse();
+        if (errResp.errorCode_ == kApiErrNoMoreActiveLicenses) {
+            // the license was requested before the server processed the last dig of the replaced one
+            state_.getLicenseManager().deferIssue(LicenseClock::now());
+            stats_->incDeferredLicenseIssues();
+            return NoErr;
+        }
+        if (restored_ && errResp.errorCode_ == kApiErrBogusCoin) {
+            // the crashed process spent the coins after its last snapshot
+            return scheduleIssueLicense();
+        }
+        log_->error() << "processIssueLicenseResponse: err code: " << errResp.errorCode_ << " err message: "
+                      << errResp.message_;
         return ErrorCode::kIssueLicenseError;
     }
     if (resp.getHttpCode() != 200) {
         return scheduleIssueLicense();
     }
 
-    auto license = std::move(resp).getResponse();
-    state_.addLicence(license);
+    const auto &license = resp.getResponse();
+    size_t coinsCnt{0};
+    if (req.type_ == ApiEndpointType::IssuePaidLicense) {
+        coinsCnt = req.getIssueLicenseRequest().coins.size();
+        stats_->recordPaidLicense((int64_t) coinsCnt, license.digAllowed_);
+    }
+    coinSpendOptimizer_.recordLicense(coinsCnt, license.digAllowed_);
+    auto idleTime = state_.addLicence(license);
+    if (idleTime.hasError()) {
+        return idleTime.error();
+    }
     stats_->incIssuedLicenses();
+    stats_->addLicenseSlotIdleTime(idleTime.get().count());
 
     for (; state_.hasQueuedDigRequests();) {
         if (!state_.hasAvailableLicense()) {
@@ -230,24 +714,39 @@ ExpectedVoid App::processIssueLicenseResponse([[maybe_unused]]Request &req, Http
 }
 
 ExpectedVoid App::scheduleIssueLicense() noexcept {
-    if (state_.hasCoins()) {
-        if (auto err = api_->scheduleIssuePaidLicense(state_.borrowCoin()); err.hasError()) {
+    if (!timeBudget_.allows(GamePhase::NoLicenses)) {
+        return NoErr;
+    }
+    auto coinsCnt = coinSpendOptimizer_.chooseCoinsCount(state_.getCoinsAmount(), state_.getQueuedDigRequestsCount(),
+                                                         LicenseClock::now());
+    if (coinsCnt > 0) {
+        if (auto err = api_->scheduleIssuePaidLicense(state_.borrowCoins(coinsCnt), shard_.id_); err.hasError()) {
             return err.error();
         }
     } else {
-        if (auto err = api_->scheduleIssueFreeLicense(); err.hasError()) {
+        if (auto err = api_->scheduleIssueFreeLicense(shard_.id_); err.hasError()) {
             return err.error();
         }
     }
     return NoErr;
 }
 
-ExpectedVoid App::processDigResponse(Request &req, HttpResponse<std::vector<TreasureID>> &resp) noexcept {
+ExpectedVoid App::processDigResponse(Request &req, HttpResponse<Treasuries> &resp) noexcept {
     auto digRequest = req.getDigRequest();
+    timeBudget_.recordStageLatency(PipelineStage::Dig, resp.getLatencyMcs());
     if (resp.getHttpCode() == 200 || resp.getHttpCode() == 404) {
-        auto &license = state_.getLicenseById(digRequest.licenseId_);
-        license.digConfirmed_++;
-        if (license.digAllowed_ == license.digConfirmed_) {
+        state_.finishDig(digRequest.posX_, digRequest.posY_, digRequest.depth_);
+        auto issuesCnt = state_.getLicenseManager().confirmDig(digRequest.licenseId_, LicenseClock::now());
+        if (issuesCnt.hasError()) {
+            return issuesCnt.error();
+        }
+        for (auto i = 0; i < issuesCnt.get(); i++) {
+            if (shouldReleaseLicenseSlot()) {
+                licenseSlots_--;
+                shard_.broker_->licenses_.release();
+                stats_->incLicenseSlotsMoved(true);
+                continue;
+            }
             if (auto err = scheduleIssueLicense(); err.hasError()) {
                 return err.error();
             }
@@ -255,14 +754,25 @@ ExpectedVoid App::processDigResponse(Request &req, HttpResponse<std::vector<Trea
     }
     switch (resp.getHttpCode()) {
         case 200: {
-            auto treasuries = std::move(resp).getResponse();
+            const auto &treasuries = resp.getResponse();
             stats_->recordTreasureDepth(digRequest.depth_, (int) treasuries.size());
+            state_.recordFoundTreasures(digRequest.depth_, treasuries.size());
             for (const auto &id : treasuries) {
-                if (digRequest.depth_ >= minDepthToCash) {
-                    if (auto err = api_->scheduleCash(id, digRequest.depth_); err.hasError()) {
-                        return err.error();
-                    }
+                auto decision = cashPolicy_.decide(id, digRequest.depth_, shouldCashAll());
+                stats_->recordCashDecision((size_t) decision);
+                if (decision == CashDecision::Drop) {
+                    stats_->incCashSkippedCnt();
                 }
+                if (decision != CashDecision::Cash) {
+                    continue;
+                }
+                if (auto err = scheduleCash(id, digRequest.depth_); err.hasError()) {
+                    return err.error();
+                }
+            }
+
+            if (speculativeDigs_.find(digRequest.posX_, digRequest.posY_) != nullptr) {
+                return processSpeculativeDig(digRequest, treasuries.size());
             }
 
             auto leftCount = state_.getLeftTreasuriesAmount(digRequest.posX_, digRequest.posY_);
@@ -278,11 +788,14 @@ ExpectedVoid App::processDigResponse(Request &req, HttpResponse<std::vector<Trea
             return NoErr;
         }
         case 404: {
+            if (speculativeDigs_.find(digRequest.posX_, digRequest.posY_) != nullptr) {
+                return processSpeculativeDig(digRequest, 0);
+            }
             return scheduleDigRequest(digRequest.posX_, digRequest.posY_, (int8_t) (digRequest.depth_ + 1));
         }
         default: {
             auto httpCode = resp.getHttpCode();
-            auto apiErr = std::move(resp).getErrResponse();
+            const auto &apiErr = resp.getErrResponse();
             log_->error() << "unexpected dig response: http code: " << httpCode << " api code: " << apiErr.errorCode_
                           << " message: " << apiErr.message_;
             return ErrorCode::kUnexpectedDigResponse;
@@ -293,28 +806,77 @@ ExpectedVoid App::processDigResponse(Request &req, HttpResponse<std::vector<Trea
 ExpectedVoid App::processCashResponse(Request &r, HttpResponse<Wallet> &resp) noexcept {
     auto httpCode = resp.getHttpCode();
     if (httpCode >= 500) {
-        return api_->scheduleCash(r.getCashRequest().treasureId_, r.getCashRequest().depth_);
+        return scheduleCash(r.getCashRequest().treasureId_, r.getCashRequest().depth_);
     }
+    pendingCash_.erase(r.getCashRequest().treasureId_);
     if (httpCode >= 400) {
-        auto apiErr = std::move(resp).getErrResponse();
+        const auto &apiErr = resp.getErrResponse();
+        if (restored_ && apiErr.errorCode_ == kApiErrTreasureNotDigged) {
+            // the crashed process cashed the treasure after its last snapshot
+            return NoErr;
+        }
         log_->error() << "unexpected cash response: http code: " << httpCode << " api code: " << apiErr.errorCode_
                       << " message: " << apiErr.message_;
         return ErrorCode::kUnexpectedCashResponse;
     }
-    auto successResp = std::move(resp).getResponse();
+    auto latency = resp.getLatencyMcs();
+    timeBudget_.recordStageLatency(PipelineStage::Cash, latency);
+    const auto &successResp = resp.getResponse();
+    cashPolicy_.recordCash(r.getCashRequest().depth_, successResp.coins.size(), latency.count());
     state_.addCoins(successResp);
     stats_->incCashedCoins((int64_t) successResp.coins.size());
     stats_->recordCoinsDepth(r.getCashRequest().depth_, (int) successResp.coins.size());
     return NoErr;
 }
 
+bool App::shouldCashAll() const noexcept {
+    return coinSpendOptimizer_.isCoinLimited() || !timeBudget_.allows(GamePhase::NoLicenses);
+}
+
+bool App::shouldPromoteCash() const noexcept {
+    return coinSpendOptimizer_.isCoinLimited() || !timeBudget_.allows(GamePhase::NoExplore);
+}
+
+ExpectedVoid App::scheduleDeferredCash(size_t maxCnt) noexcept {
+    for (size_t i = 0; i < maxCnt; i++) {
+        auto deferred = cashPolicy_.fetchDeferred();
+        if (!deferred.has_value()) {
+            break;
+        }
+        if (auto err = scheduleCash(deferred->first, deferred->second); err.hasError()) {
+            return err;
+        }
+    }
+    return NoErr;
+}
+
+ExpectedVoid App::scheduleCash(const TreasureID &id, int8_t depth) noexcept {
+    if (snapshot_.isEnabled()) {
+        pendingCash_[id] = depth;
+    }
+    return api_->scheduleCash(id, depth, shard_.id_);
+}
+
 ExpectedVoid App::scheduleDigRequest(int16_t x, int16_t y, int8_t depth) noexcept {
+    // the treasure would not be cashed before the deadline
+    if (!timeBudget_.allows(GamePhase::CashOnly)) {
+        return NoErr;
+    }
+    // the cell was emptied while the dig waited, e.g. by the last treasure of a speculatively dug area
+    if (state_.getLeftTreasuriesAmount(x, y) <= 0) {
+        return NoErr;
+    }
+    // the server has no depths below kMaxDigDepth, a cell still reported to hold treasures there is inconsistent
+    if ((size_t) depth > kMaxDigDepth) {
+        return ErrorCode::kTreasuriesLeftInconsistency;
+    }
     if (state_.hasAvailableLicense()) {
         auto licenseId = state_.reserveAvailableLicenseId();
         if (licenseId.hasError()) {
             return licenseId.error();
         }
-        return api_->scheduleDig({licenseId.get(), x, y, depth});
+        state_.startDig(x, y);
+        return api_->scheduleDig({licenseId.get(), x, y, depth}, shard_.id_);
     } else {
         state_.addDigRequest({x, y, depth});
         return NoErr;
@@ -322,12 +884,14 @@ ExpectedVoid App::scheduleDigRequest(int16_t x, int16_t y, int8_t depth) noexcep
 }
 
 ExpectedVoid App::createSubAreas(const ExploreAreaPtr &root) noexcept {
-    auto h = kExploreAreas[root->exploreDepth_].height;
-    auto w = kExploreAreas[root->exploreDepth_].width;
+    auto shift = explorePlanner_.plan(*root);
+    auto h = shift.height;
+    auto w = shift.width;
     auto x1 = root->area_.posX_;
     auto x2 = root->area_.posX_ + root->area_.sizeX_;
     auto y1 = root->area_.posY_;
     auto y2 = root->area_.posY_ + root->area_.sizeY_;
+    std::vector<ExploreAreaPtr> children;
     for (int i = x1; i < x2; i += h) {
         for (int j = y1; j < y2; j += w) {
             auto curH = h;
@@ -338,15 +902,33 @@ ExpectedVoid App::createSubAreas(const ExploreAreaPtr &root) noexcept {
             if (j + curW > y2) {
                 curW = (int16_t) (y2 - j);
             }
-            auto ea = ExploreArea::NewExploreArea(
+            children.push_back(ExploreArea::NewExploreArea(
                     root,
                     Area((int16_t) i, (int16_t) j, curH, curW),
                     root->exploreDepth_ + 1,
                     0
-            );
-            root->addChild(ea);
+            ));
         }
     }
+    if (densityMap_.hasPrior() && root->exploreDepth_ < kDensityPriorMaxDepth) {
+        // children are requested in order, so the densest ones according to the prior go first
+        std::vector<std::pair<double, ExploreAreaPtr>> ranked;
+        ranked.reserve(children.size());
+        for (auto &child : children) {
+            auto density = densityMap_.getPriorExpectedTreasuriesCnt(child->area_) / (double) child->area_.getArea();
+            ranked.emplace_back(density, std::move(child));
+        }
+        std::stable_sort(ranked.begin(), ranked.end(), [](const auto &l, const auto &r) {
+            return l.first > r.first;
+        });
+        for (size_t i = 0; i < ranked.size(); i++) {
+            children[i] = std::move(ranked[i].second);
+        }
+    }
+    for (auto &child : children) {
+        root->addChild(std::move(child));
+    }
+    stats_->recordExploreSplit(root->children_.size());
     if (root->getNonExploredChildrenCnt() == 1) {
         auto child = root->getLastNonExploredChild();
         if (auto err = processExploredArea(child, root->getLeftTreasuriesCnt()); err.hasError()) {
@@ -358,11 +940,157 @@ ExpectedVoid App::createSubAreas(const ExploreAreaPtr &root) noexcept {
     return NoErr;
 }
 
-std::shared_ptr<App> App::createApp() {
+void App::exchangeCoins() noexcept {
+    auto &exchange = shard_.broker_->coins_;
+    if (coinSpendOptimizer_.isCoinLimited()) {
+        Wallet taken;
+        CoinID coin{};
+        for (size_t i = 0; i < kCoinExchangeBatch && exchange.take(coin); i++) {
+            taken.coins.push_back(coin);
+        }
+        state_.addCoins(taken);
+        stats_->addExchangedCoins(false, (int64_t) taken.coins.size());
+        return;
+    }
+    int64_t offered{0};
+    while (state_.getCoinsAmount() > kCoinExchangeKeepCoins) {
+        auto coin = state_.borrowCoin();
+        if (!exchange.offer(coin)) {
+            state_.addCoins(Wallet{{coin}});
+            break;
+        }
+        offered++;
+    }
+    stats_->addExchangedCoins(true, offered);
+}
+
+bool App::shouldReleaseLicenseSlot() const noexcept {
+    // the last slot digs the cells found by explores still in flight
+    return shard_.broker_ != nullptr && licenseSlots_ > 1 && exploreInFlight_ == 0 &&
+           !state_.hasMoreExploreAreas() && !state_.hasQueuedDigRequests();
+}
+
+ExpectedVoid App::takeSpareLicenseSlots() noexcept {
+    if (!timeBudget_.allows(GamePhase::NoLicenses)) {
+        return NoErr;
+    }
+    while (state_.getQueuedDigRequestsCount() > kLicensePoolMinQueuedDigs && shard_.broker_->licenses_.tryTake()) {
+        licenseSlots_++;
+        stats_->incLicenseSlotsMoved(false);
+        if (auto err = scheduleIssueLicense(); err.hasError()) {
+            return err;
+        }
+    }
+    return NoErr;
+}
+
+void App::saveDensityMap() noexcept {
+    densityMapSavedAt_ = std::chrono::steady_clock::now();
+    // a copy is skipped while the writer saves the previous one, the next period takes a fresh copy
+    densityMapWriter_.submit(densityMap_);
+    if (densityMap_.hasPrior()) {
+        stats_->recordDensityPriorMismatch(densityMap_.getPriorMismatch());
+    }
+}
+
+void App::reloadConfig() noexcept {
+    std::string badLine;
+    auto config = loadRuntimeConfig(badLine);
+    if (config.hasError()) {
+        log_->warn() << "config is not reloaded, the previous one is kept: bad value: " << badLine;
+        return;
+    }
+    const auto &published = runtimeConfig().publish(config.get());
+    log_->info() << "Config reloaded: " << published;
+    if (published.apiThreadCount_ != config.value().apiThreadCount_ ||
+        published.maxLicensesCount_ != config.value().maxLicensesCount_) {
+        log_->warn() << "API_THREADS and MAX_LICENSES take effect after restart";
+    }
+}
+
+void App::applyConfig(const RuntimeConfig &config) noexcept {
+    configVersion_ = config.version_;
+    if (config.exploreConcurrentRequestsCnt_ != exploreConcurrency_) {
+        exploreConcurrency_ = config.exploreConcurrentRequestsCnt_;
+        exploreController_.setConcurrency(exploreConcurrency_);
+    }
+    stats_->recordExploreController(exploreController_.getSetpoint(), exploreController_.getBacklog(),
+                                    exploreController_.getConcurrency());
+}
+
+void App::loadConfig(const std::shared_ptr<Log> &log) {
+    std::string badLine;
+    auto config = loadRuntimeConfig(badLine);
+    if (config.hasError()) {
+        log->error() << "config is not loaded: bad value: " << badLine;
+        throw std::runtime_error("config load failed");
+    }
+    log->info() << "Config: " << runtimeConfig().publish(config.get());
+    installConfigReloadHandler();
+}
+
+void App::initMemory(const std::shared_ptr<Log> &log, size_t stateShardsCnt) {
+    MemoryArenasConfig config;
+    config.stateGridCap_ = Arena::getBlockSpan(sizeof(CellGrid)) * stateShardsCnt;
+    config.httpBuffersCap_ = (sizeof(JsonValueBuffer) + sizeof(JsonParseBuffer)) *
+                             runtimeConfig().get().apiThreadCount_;
+    config.mode_ = hugePagesFromEnv();
+    initMemoryArenas(config);
+    for (size_t i = 0; i < kMemoryArenasCnt; i++) {
+        auto &arena = memoryArena((MemoryArenaId) i);
+        log->info() << "Memory arena " << getMemoryArenaName((MemoryArenaId) i) << ": " << arena.getCapacity()
+                    << " bytes huge pages " << arena.getMode();
+    }
+}
+
+void App::initThreads(const std::shared_ptr<Log> &log, size_t appThreadsCnt, size_t processId,
+                      size_t processCnt) {
+    auto err = initThreadPlacement(appThreadsCnt, threadPlacementConfigFromEnv(), processId, processCnt);
+    if (err.hasError()) {
+        log->warn() << "io threads are not pinned: " << err.error();
+    }
+    log->info() << "Thread placement: " << threadPlacement();
+}
+
+std::vector<std::shared_ptr<App>> App::createApps() {
     auto log = std::make_shared<Log>();
+    loadConfig(log);
+    auto processShard = processShardFromEnv();
+    if (processShard.hasError()) {
+        log->error() << "PROCESS_SHARDS or PROCESS_SHARD_ID is invalid: " << processShard.error();
+        throw std::runtime_error("invalid process shard");
+    }
+    auto [processId, processCnt] = processShard.get();
+    std::shared_ptr<Broker> broker{nullptr};
+    if (processCnt > 1) {
+        auto shmName = brokerShmNameFromEnv();
+        auto attached = attachSharedBroker(shmName, gameDurationFromEnv());
+        if (attached.hasError()) {
+            log->error() << "broker " << shmName << " is not attached: " << attached.error();
+            throw std::runtime_error("broker attach failed");
+        }
+        broker = attached.get();
+        log->info() << "Process shard " << processId << "/" << processCnt << " attached broker " << shmName;
+    }
+    auto shards = ShardConfig::split(stateShardsCntFromEnv(), processId, processCnt, broker);
+    initMemory(log, shards.size());
+    initThreads(log, shards.size(), processId, processCnt);
     auto stats = std::make_shared<Stats>(log);
-    auto api = std::make_shared<Api>(stats, log);
-    auto app = std::make_shared<App>(api, stats, log);
+    auto api = std::make_shared<Api>(stats, log, shards.size(), shards.front().broker_);
+    std::vector<std::shared_ptr<App>> apps;
+    for (auto &shard : shards) {
+        apps.push_back(std::make_shared<App>(api, stats, log, std::move(shard)));
+    }
+    return apps;
+}
 
-    return app;
+void App::runShards(const std::vector<std::shared_ptr<App>> &apps) {
+    std::vector<std::thread> threads;
+    for (size_t i = 1; i < apps.size(); i++) {
+        threads.emplace_back(&App::run, apps[i].get());
+    }
+    apps.front()->run();
+    for (auto &t : threads) {
+        t.join();
+    }
 }
@@ -8,6 +8,22 @@
 #include <utility>
 #include "state.h"
 #include "rate_limiter.h"
+#include "explore_planner.h"
+#include "explore_inference.h"
+#include "density_map.h"
+#include "coin_spend_optimizer.h"
+#include "cash_policy.h"
+#include "explore_controller.h"
+#include "time_budget.h"
+#include "speculative_dig.h"
+#include "shard.h"
+#include "snapshot.h"
+#include "config.h"
+#include "memory.h"
+#include "thread_placement.h"
+#include <chrono>
+#include <string>
+#include <unordered_map>
 #include <vector>
 #include <memory>
 
@@ -18,19 +34,87 @@ private:
     std::shared_ptr<Log> log_;
     std::shared_ptr<Api> api_;
     std::shared_ptr<Stats> stats_;
-    State state_;
+    ShardConfig shard_;
+    // declared before state_, whose cell grid lives in the snapshot file mapping
+    Snapshot snapshot_;
+    State state_{openSnapshot()};
+    SnapshotData snapshotData_;
+    std::chrono::steady_clock::time_point snapshotTakenAt_{std::chrono::steady_clock::now()};
+    // cash requests in flight, kept only for snapshots
+    std::unordered_map<TreasureID, int8_t> pendingCash_;
+    // the amount of treasures of the shard region is known
+    bool rootExplored_{false};
+    // the game was resumed from a snapshot of a crashed process
+    bool restored_{false};
+    // the deadline counts from the first response the server answered with 200
+    bool gameClockStarted_{false};
+    ExplorePlanner explorePlanner_;
+    bool siblingUnion_{siblingUnionFromEnv()};
+    ExploreInference exploreInference_;
+    DensityMap densityMap_;
+    DensityMapWriter densityMapWriter_;
+    std::string densityMapPath_;
+    std::chrono::steady_clock::time_point densityMapSavedAt_{std::chrono::steady_clock::now()};
+    TimeBudget timeBudget_{GameClock::now(), gameDurationFromEnv(), endGameModeFromEnv()};
+    CoinSpendOptimizer coinSpendOptimizer_{LicenseClock::now(), timeBudget_.getGameDuration()};
+    CashPolicy cashPolicy_;
+    ExploreController exploreController_{runtimeConfig().get().exploreConcurrentRequestsCnt_};
+    uint64_t configVersion_{runtimeConfig().get().version_};
+    // EXPLORE_CONCURRENCY of the last applied config, the controller keeps what it learned until it changes
+    size_t exploreConcurrency_{runtimeConfig().get().exploreConcurrentRequestsCnt_};
+    // the CPU the app thread was seen on last, a change is a migration
+    int appCpu_{-1};
+    SpeculativeDigs speculativeDigs_{speculativeDigFromEnv()};
+    size_t exploreInFlight_{0};
+    size_t licenseSlots_{shard_.licensesQuota_};
 //    RateLimiter rateLimiter_;
 
 
     [[nodiscard]] ExpectedVoid fireInitRequests() noexcept;
 
+    // Explores the shard region from its root.
+    [[nodiscard]] ExpectedVoid startExplore() noexcept;
+
+    // Opens SNAPSHOT_PATH and returns its cell grid, nullptr if snapshots are disabled or the file fails.
+    [[nodiscard]] CellGrid *openSnapshot() noexcept;
+
+    // Resumes the game of a crashed process: licenses in use, coins, cells left to dig, the explore
+    // frontier and treasures waiting for cash. Requests in flight at the crash are lost.
+    [[nodiscard]] ExpectedVoid restoreSnapshot() noexcept;
+
+    // Copies the frontier, coins and pending cash and hands them over to the snapshot writer thread.
+    void takeSnapshot() noexcept;
+
+    // The server starts the game when it starts itself, which may be well after the process, so the
+    // deadline and the coin spend horizon count from its first successful response.
+    void startGameClock() noexcept;
+
     [[nodiscard]] ExpectedVoid processResponse(Response &r) noexcept;
 
+    // Response::dispatch binds every result type to one of the overloads below at compile time.
+    friend class Response;
+
+    [[nodiscard]] ExpectedVoid processResponse(Request &req, HttpResponse<HealthResponse> &resp) noexcept;
+
+    [[nodiscard]] ExpectedVoid processResponse(Request &req, HttpResponse<ExploreResponse> &resp) noexcept;
+
+    [[nodiscard]] ExpectedVoid processResponse(Request &req, HttpResponse<License> &resp) noexcept {
+        return processIssueLicenseResponse(req, resp);
+    }
+
+    [[nodiscard]] ExpectedVoid processResponse(Request &req, HttpResponse<Treasuries> &resp) noexcept {
+        return processDigResponse(req, resp);
+    }
+
+    [[nodiscard]] ExpectedVoid processResponse(Request &req, HttpResponse<Wallet> &resp) noexcept {
+        return processCashResponse(req, resp);
+    }
+
     [[nodiscard]]ExpectedVoid processExploreResponse(Request &req, HttpResponse<ExploreResponse> &resp) noexcept;
 
     [[nodiscard]]ExpectedVoid processIssueLicenseResponse(Request &req, HttpResponse<License> &resp) noexcept;
 
-    [[nodiscard]]ExpectedVoid processDigResponse(Request &req, HttpResponse<std::vector<TreasureID>> &resp) noexcept;
+    [[nodiscard]]ExpectedVoid processDigResponse(Request &req, HttpResponse<Treasuries> &resp) noexcept;
 
     [[nodiscard]]ExpectedVoid processCashResponse(Request &r, HttpResponse<Wallet> &resp) noexcept;
 
@@ -43,8 +127,50 @@ private:
 
     [[nodiscard]] ExpectedVoid createSubAreas(const ExploreAreaPtr &root) noexcept;
 
+    // Digs the cells of the area instead of exploring it down to 1x1 if the wasted digs cost less.
+    [[nodiscard]] Expected<bool> trySpeculativeDig(const ExploreAreaPtr &exploreArea) noexcept;
+
+    [[nodiscard]] ExpectedVoid processSpeculativeDig(const DigRequest &digRequest, size_t treasuriesCnt) noexcept;
+
+    [[nodiscard]] ExpectedVoid inferExploredChildren(const ExploreAreaPtr &parent) noexcept;
+
+    // Tops explore requests in flight up to the explore controller concurrency.
+    [[nodiscard]] ExpectedVoid scheduleExplores() noexcept;
+
+    // Coins limit the licenses or no license is going to be issued till the end of the game.
+    [[nodiscard]] bool shouldCashAll() const noexcept;
+
+    // Cash requests are taken before explore and dig when the next license waits for coins or the game ends.
+    [[nodiscard]] bool shouldPromoteCash() const noexcept;
+
+    [[nodiscard]] ExpectedVoid scheduleDeferredCash(size_t maxCnt) noexcept;
+
+    [[nodiscard]] ExpectedVoid scheduleCash(const TreasureID &id, int8_t depth) noexcept;
+
+    // Takes coins from other shards while licenses wait for coins and offers the surplus above
+    // kCoinExchangeKeepCoins otherwise.
+    void exchangeCoins() noexcept;
+
+    // A shard without queued digs and areas to explore gives a drained license slot up to the broker.
+    [[nodiscard]] bool shouldReleaseLicenseSlot() const noexcept;
+
+    // Takes a spare license slot while the queued digs exceed kLicensePoolMinQueuedDigs.
+    [[nodiscard]] ExpectedVoid takeSpareLicenseSlots() noexcept;
+
+    void saveDensityMap() noexcept;
+
+    // Reloads the runtime config of the process on SIGHUP, the first shard to notice the request takes it.
+    void reloadConfig() noexcept;
+
+    // Applies a new runtime config version to the state of this shard.
+    void applyConfig(const RuntimeConfig &config) noexcept;
+
+    [[nodiscard]] ExploreAreaPtr createSiblingUnion(const ExploreAreaPtr &first) noexcept;
+
+    [[nodiscard]] ExpectedVoid processSiblingUnionExplored(const ExploreAreaPtr &exploreUnion, size_t actualTreasuriesCnt) noexcept;
+
 public:
-    App(std::shared_ptr<Api> api, std::shared_ptr<Stats> stats, std::shared_ptr<Log> log);
+    App(std::shared_ptr<Api> api, std::shared_ptr<Stats> stats, std::shared_ptr<Log> log, ShardConfig shard = {});
 
     ~App();
 
@@ -66,7 +192,22 @@ public:
 
     void run() noexcept;
 
-    static std::shared_ptr<App> createApp();
+    // Loads the startup runtime config and installs the SIGHUP reload handler.
+    static void loadConfig(const std::shared_ptr<Log> &log);
+
+    // Reserves the memory arenas for the state shards of the process and the api workers.
+    static void initMemory(const std::shared_ptr<Log> &log, size_t stateShardsCnt);
+
+    // Plans the thread placement for the app threads of the process and pins the calling thread, and with
+    // it the threads started later, to the io CPUs.
+    static void initThreads(const std::shared_ptr<Log> &log, size_t appThreadsCnt, size_t processId,
+                            size_t processCnt);
+
+    // Creates an App per state shard, all of them share one Api.
+    static std::vector<std::shared_ptr<App>> createApps();
+
+    // Runs the first shard on the calling thread and the rest on their own threads.
+    static void runShards(const std::vector<std::shared_ptr<App>> &apps);
 };
 
 #endif //HIGHLOADCUP2021_APP_H
@@ -0,0 +1,130 @@
+#include "broker.h"
+#include <algorithm>
+#include <cstdlib>
+#include <fcntl.h>
+#include <new>
+#include <sys/file.h>
+#include <sys/mman.h>
+#include <thread>
+#include <unistd.h>
+
+bool LicensePool::tryTake() noexcept {
+    auto slots = spareSlots_.load();
+    while (slots > 0) {
+        if (spareSlots_.compare_exchange_weak(slots, slots - 1)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+std::chrono::milliseconds RateBudget::tryAcquire(int32_t cost, BrokerClock::time_point now) noexcept {
+    auto nowMs = std::chrono::duration_cast<std::chrono::milliseconds>(now.time_since_epoch()).count();
+    auto windowStart = windowStartMs_.load();
+    if (nowMs - windowStart >= 1000 && windowStartMs_.compare_exchange_strong(windowStart, nowMs)) {
+        // costs taken concurrently with the reset may leak into the new window, the budget is approximate
+        used_ = 0;
+        windowStart = nowMs;
+    }
+    if (used_.fetch_add(cost) + cost <= maxRps_) {
+        return std::chrono::milliseconds(0);
+    }
+    used_.fetch_sub(cost);
+    return std::chrono::milliseconds(std::max<int64_t>(1, windowStart + 1000 - nowMs));
+}
+
+void RateBudget::acquire(int32_t cost) noexcept {
+    for (;;) {
+        auto wait = tryAcquire(cost, BrokerClock::now());
+        if (wait.count() == 0) {
+            return;
+        }
+        std::this_thread::sleep_for(wait);
+    }
+}
+
+Expected<std::pair<size_t, size_t>> processShardFromEnv() noexcept {
+    auto shardsEnv = std::getenv("PROCESS_SHARDS");
+    auto idEnv = std::getenv("PROCESS_SHARD_ID");
+    if (shardsEnv == nullptr || idEnv == nullptr) {
+        return std::pair<size_t, size_t>{0, 1};
+    }
+    auto cnt = std::strtoll(shardsEnv, nullptr, 10);
+    auto id = std::strtoll(idEnv, nullptr, 10);
+    // a clamped count would place the regions of the higher ids outside the field
+    if (cnt < 1 || cnt > (long long) kProcessMaxShardsCnt || id < 0 || id >= cnt) {
+        return ErrorCode::kConfigError;
+    }
+    return std::pair<size_t, size_t>{(size_t) id, (size_t) cnt};
+}
+
+std::string brokerShmNameFromEnv() {
+    if (auto nameEnv = std::getenv("BROKER_SHM"); nameEnv != nullptr) {
+        return nameEnv;
+    }
+    return "/highloadcup2021";
+}
+
+namespace {
+
+// Attach and detach hold an exclusive flock on the segment, the counters are only touched under it.
+struct BrokerSegment {
+    int64_t attachedCnt_;
+    int64_t createdAtMs_;
+    Broker broker_;
+};
+
+int64_t nowMs() noexcept {
+    return std::chrono::duration_cast<std::chrono::milliseconds>(BrokerClock::now().time_since_epoch()).count();
+}
+
+void detachSharedBroker(BrokerSegment *segment, int fd, const std::string &name) noexcept {
+    flock(fd, LOCK_EX);
+    segment->attachedCnt_--;
+    if (segment->attachedCnt_ == 0) {
+        shm_unlink(name.c_str());
+    }
+    flock(fd, LOCK_UN);
+    munmap(segment, sizeof(BrokerSegment));
+    close(fd);
+}
+
+}
+
+Expected<std::shared_ptr<Broker>>
+attachSharedBroker(const std::string &name, std::chrono::milliseconds gameDuration) noexcept {
+    auto fd = shm_open(name.c_str(), O_CREAT | O_RDWR, 0600);
+    if (fd < 0) {
+        return ErrorCode::kBrokerAttachError;
+    }
+    if (flock(fd, LOCK_EX) != 0) {
+        close(fd);
+        return ErrorCode::kBrokerAttachError;
+    }
+    // a fresh segment is zero filled, a smaller one is left from another build and is reinitialized
+    auto size = lseek(fd, 0, SEEK_END);
+    if (size < (off_t) sizeof(BrokerSegment) && ftruncate(fd, (off_t) sizeof(BrokerSegment)) != 0) {
+        flock(fd, LOCK_UN);
+        close(fd);
+        return ErrorCode::kBrokerAttachError;
+    }
+    auto addr = mmap(nullptr, sizeof(BrokerSegment), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (addr == MAP_FAILED) {
+        flock(fd, LOCK_UN);
+        close(fd);
+        return ErrorCode::kBrokerAttachError;
+    }
+    auto segment = static_cast<BrokerSegment *>(addr);
+    if (size < (off_t) sizeof(BrokerSegment) || segment->attachedCnt_ <= 0 ||
+        nowMs() - segment->createdAtMs_ > gameDuration.count()) {
+        new(&segment->broker_) Broker();
+        segment->attachedCnt_ = 0;
+        segment->createdAtMs_ = nowMs();
+    }
+    segment->attachedCnt_++;
+    flock(fd, LOCK_UN);
+
+    return std::shared_ptr<Broker>(&segment->broker_, [segment, fd, name](Broker *) {
+        detachSharedBroker(segment, fd, name);
+    });
+}
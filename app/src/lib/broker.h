@@ -0,0 +1,69 @@
+#ifndef HIGHLOADCUP2021_BROKER_H
+#define HIGHLOADCUP2021_BROKER_H
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <utility>
+#include "coin_exchange.h"
+#include "const.h"
+#include "error.h"
+
+using BrokerClock = std::chrono::steady_clock;
+
+// License slots given up by shards that have nothing left to dig. The server limits active licenses
+// for the whole game, so a slot released by one shard is only reused by taking it from here.
+class LicensePool {
+    std::atomic<int32_t> spareSlots_{0};
+
+public:
+    void release() noexcept {
+        spareSlots_++;
+    }
+
+    [[nodiscard]] bool tryTake() noexcept;
+
+    [[nodiscard]] int32_t getSpareSlots() const noexcept {
+        return spareSlots_.load();
+    }
+};
+
+// Requests per second shared by all shards, counted in fixed one second windows of the monotonic clock.
+class RateBudget {
+    const int64_t maxRps_;
+    std::atomic<int64_t> windowStartMs_{0};
+    std::atomic<int64_t> used_{0};
+
+public:
+    explicit RateBudget(int64_t maxRps) noexcept: maxRps_{maxRps} {}
+
+    // Returns how long to wait before the cost fits into the budget, zero if the cost is taken.
+    [[nodiscard]] std::chrono::milliseconds tryAcquire(int32_t cost, BrokerClock::time_point now) noexcept;
+
+    void acquire(int32_t cost) noexcept;
+};
+
+// Everything shards of one game share. In-process shards keep it on the heap, process shards map it
+// from a shared memory segment, so it holds only lock-free atomics and no pointers.
+struct Broker {
+    CoinExchange coins_;
+    LicensePool licenses_;
+    RateBudget rate_{kMaxRPS};
+};
+
+// Reads PROCESS_SHARDS and PROCESS_SHARD_ID as {id, count}, {0, 1} if either is missing.
+// Returns kConfigError if the count is out of [1, kProcessMaxShardsCnt] or the id is out of [0, count).
+Expected<std::pair<size_t, size_t>> processShardFromEnv() noexcept;
+
+// Reads BROKER_SHM and falls back to /highloadcup2021.
+std::string brokerShmNameFromEnv();
+
+// Maps the broker segment with the given name, creating it for the first process of the game.
+// A segment left by a crashed game older than gameDuration is reinitialized. The last detached
+// process removes the segment.
+[[nodiscard]] Expected<std::shared_ptr<Broker>>
+attachSharedBroker(const std::string &name, std::chrono::milliseconds gameDuration) noexcept;
+
+#endif //HIGHLOADCUP2021_BROKER_H
@@ -0,0 +1,87 @@
+#include "cash_policy.h"
+#include "config.h"
+#include <algorithm>
+
+namespace {
+
+// the server digs 1..kMaxDigDepth, a restored or corrupted depth must not index past the per depth arrays
+size_t depthIdx(int8_t depth) noexcept {
+    return (size_t) std::clamp((int) depth, 1, (int) kMaxDigDepth);
+}
+
+}
+
+std::ostream &operator<<(std::ostream &os, const CashDecision &decision) {
+    switch (decision) {
+        case CashDecision::Cash:
+            os << "cash";
+            break;
+        case CashDecision::Defer:
+            os << "defer";
+            break;
+        case CashDecision::Drop:
+            os << "drop";
+            break;
+    }
+    return os;
+}
+
+std::optional<double> CashPolicy::coinsPerLatency(size_t depth) const noexcept {
+    if (cashedCnt_[depth] < kCashPolicyMinSamples) {
+        return std::nullopt;
+    }
+    return (double) coinsSum_[depth] / (double) std::max(latencySum_[depth], (int64_t) 1);
+}
+
+CashDecision CashPolicy::decide(const TreasureID &id, int8_t depth, bool coinsLimited) {
+    auto d = depthIdx(depth);
+    auto ratio = coinsPerLatency(d);
+    if (coinsLimited || !ratio.has_value()) {
+        return CashDecision::Cash;
+    }
+    double bestRatio{0.0};
+    for (size_t i = 1; i <= kMaxDigDepth; i++) {
+        if (auto r = coinsPerLatency(i); r.has_value()) {
+            bestRatio = std::max(bestRatio, r.value());
+        }
+    }
+    if (ratio.value() >= runtimeConfig().get().cashPolicyCashRatio_ * bestRatio) {
+        return CashDecision::Cash;
+    }
+    if (deferredCnt_ >= kCashPolicyMaxDeferred) {
+        return CashDecision::Drop;
+    }
+    deferred_[d].push_back(id);
+    deferredCnt_++;
+    return CashDecision::Defer;
+}
+
+void CashPolicy::recordCash(int8_t depth, size_t coinsCnt, int64_t latencyMcs) noexcept {
+    auto d = depthIdx(depth);
+    coinsSum_[d] += (int64_t) coinsCnt;
+    cashedCnt_[d]++;
+    latencySum_[d] += latencyMcs;
+}
+
+std::optional<DeferredCash> CashPolicy::fetchDeferred() noexcept {
+    std::optional<size_t> best;
+    double bestRatio{-1.0};
+    for (size_t i = 1; i <= kMaxDigDepth; i++) {
+        if (deferred_[i].empty()) {
+            continue;
+        }
+        auto ratio = coinsPerLatency(i).value_or(0.0);
+        if (ratio > bestRatio) {
+            bestRatio = ratio;
+            best = i;
+        }
+    }
+    if (!best.has_value()) {
+        return std::nullopt;
+    }
+    auto &queue = deferred_[best.value()];
+    DeferredCash ret{std::move(queue.back()), (int8_t) best.value()};
+    queue.pop_back();
+    deferredCnt_--;
+    return ret;
+}
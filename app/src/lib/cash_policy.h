@@ -0,0 +1,60 @@
+#ifndef HIGHLOADCUP2021_CASH_POLICY_H
+#define HIGHLOADCUP2021_CASH_POLICY_H
+
+#include <array>
+#include <cstdint>
+#include <optional>
+#include <ostream>
+#include <utility>
+#include <vector>
+#include "api_entities.h"
+#include "const.h"
+
+enum class CashDecision : int {
+    Cash = 0,
+    Defer = 1,
+    Drop = 2,
+};
+
+std::ostream &operator<<(std::ostream &os, const CashDecision &decision);
+
+using DeferredCash = std::pair<TreasureID, int8_t>;
+
+// Decides whether a dug treasure is cashed at once, deferred or dropped.
+// Coins per treasure and cash latency are measured per depth, a depth without kCashPolicyMinSamples
+// is always cashed so that it gets measured. While coins limit the licenses everything is cashed,
+// otherwise treasures whose coins per latency fall below CASH_RATIO (see RuntimeConfig) of the best depth
+// are deferred and cashed later, the best depth first. A treasure is dropped when the deferred
+// queue is full.
+class CashPolicy {
+    std::array<int64_t, kMaxDigDepth + 1> coinsSum_{};
+    std::array<int64_t, kMaxDigDepth + 1> cashedCnt_{};
+    std::array<int64_t, kMaxDigDepth + 1> latencySum_{};
+    std::array<std::vector<TreasureID>, kMaxDigDepth + 1> deferred_{};
+    size_t deferredCnt_{0};
+
+    [[nodiscard]] std::optional<double> coinsPerLatency(size_t depth) const noexcept;
+
+public:
+    [[nodiscard]] CashDecision decide(const TreasureID &id, int8_t depth, bool coinsLimited);
+
+    void recordCash(int8_t depth, size_t coinsCnt, int64_t latencyMcs) noexcept;
+
+    // Returns the deferred treasure with the best coins per latency.
+    [[nodiscard]] std::optional<DeferredCash> fetchDeferred() noexcept;
+
+    [[nodiscard]] size_t getDeferredCnt() const noexcept {
+        return deferredCnt_;
+    }
+
+    template<class F>
+    void forEachDeferred(F f) const {
+        for (size_t depth = 0; depth < deferred_.size(); depth++) {
+            for (const auto &id : deferred_[depth]) {
+                f(id, (int8_t) depth);
+            }
+        }
+    }
+};
+
+#endif //HIGHLOADCUP2021_CASH_POLICY_H
@@ -0,0 +1,47 @@
+#include "coin_exchange.h"
+
+CoinExchange::CoinExchange() {
+    for (size_t i = 0; i < kCoinExchangeCap; i++) {
+        cells_[i].sequence_.store(i, std::memory_order_relaxed);
+    }
+}
+
+bool CoinExchange::offer(CoinID coin) noexcept {
+    auto pos = enqueuePos_.load(std::memory_order_relaxed);
+    for (;;) {
+        auto &cell = cells_[pos & kMask];
+        auto seq = cell.sequence_.load(std::memory_order_acquire);
+        auto diff = (intptr_t) seq - (intptr_t) pos;
+        if (diff == 0) {
+            if (enqueuePos_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                cell.coin_ = coin;
+                cell.sequence_.store(pos + 1, std::memory_order_release);
+                return true;
+            }
+        } else if (diff < 0) {
+            return false;
+        } else {
+            pos = enqueuePos_.load(std::memory_order_relaxed);
+        }
+    }
+}
+
+bool CoinExchange::take(CoinID &coin) noexcept {
+    auto pos = dequeuePos_.load(std::memory_order_relaxed);
+    for (;;) {
+        auto &cell = cells_[pos & kMask];
+        auto seq = cell.sequence_.load(std::memory_order_acquire);
+        auto diff = (intptr_t) seq - (intptr_t) (pos + 1);
+        if (diff == 0) {
+            if (dequeuePos_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                coin = cell.coin_;
+                cell.sequence_.store(pos + kCoinExchangeCap, std::memory_order_release);
+                return true;
+            }
+        } else if (diff < 0) {
+            return false;
+        } else {
+            pos = dequeuePos_.load(std::memory_order_relaxed);
+        }
+    }
+}
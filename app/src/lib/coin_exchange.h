@@ -0,0 +1,37 @@
+#ifndef HIGHLOADCUP2021_COIN_EXCHANGE_H
+#define HIGHLOADCUP2021_COIN_EXCHANGE_H
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include "api_entities.h"
+#include "const.h"
+
+// Hands coins over between state shards without locks: a shard with spare coins offers them and a
+// shard whose licenses wait for coins takes them. It is a bounded multi producer multi consumer ring
+// where every cell carries a sequence number telling whether it is ready to be written or read.
+// The ring is stored inline and only uses lock-free atomics, so it works in shared memory as well.
+class CoinExchange {
+    struct Cell {
+        std::atomic<size_t> sequence_;
+        CoinID coin_;
+    };
+
+    static constexpr size_t kMask = kCoinExchangeCap - 1;
+    static_assert((kCoinExchangeCap & kMask) == 0, "kCoinExchangeCap must be a power of two");
+
+    std::array<Cell, kCoinExchangeCap> cells_;
+    alignas(64) std::atomic<size_t> enqueuePos_{0};
+    alignas(64) std::atomic<size_t> dequeuePos_{0};
+
+public:
+    CoinExchange();
+
+    // Returns false if the exchange is full.
+    bool offer(CoinID coin) noexcept;
+
+    // Returns false if the exchange is empty.
+    bool take(CoinID &coin) noexcept;
+};
+
+#endif //HIGHLOADCUP2021_COIN_EXCHANGE_H
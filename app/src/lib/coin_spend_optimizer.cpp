@@ -0,0 +1,117 @@
+#include "coin_spend_optimizer.h"
+#include "config.h"
+#include <algorithm>
+#include <cmath>
+
+size_t CoinSpendOptimizer::candidateIdx(size_t coinsCnt) noexcept {
+    size_t idx = 0;
+    while (idx + 1 < kCoinSpendCandidates.size() && (size_t) kCoinSpendCandidates[idx + 1] <= coinsCnt) {
+        idx++;
+    }
+    return idx;
+}
+
+void CoinSpendOptimizer::recordLicense(size_t coinsCnt, uint32_t digAllowed) noexcept {
+    issuedCnt_++;
+    if (coinsCnt == 0) {
+        freeDigsSum_ += digAllowed;
+        freeDigsCnt_++;
+        return;
+    }
+    // licenses bought by hand with a count between the candidates are accounted to the lower one
+    auto idx = candidateIdx(coinsCnt);
+    digsSum_[idx] += digAllowed;
+    digsCnt_[idx]++;
+}
+
+double CoinSpendOptimizer::estimateDigs(size_t candidate) const noexcept {
+    if (digsCnt_[candidate] > 0) {
+        return (double) digsSum_[candidate] / (double) digsCnt_[candidate];
+    }
+    auto coins = (double) kCoinSpendCandidates[candidate];
+    auto lower = candidate;
+    while (lower > 0 && digsCnt_[lower - 1] == 0) {
+        lower--;
+    }
+    auto upper = candidate;
+    while (upper + 1 < kCoinSpendCandidates.size() && digsCnt_[upper + 1] == 0) {
+        upper++;
+    }
+    auto hasLower = lower > 0;
+    auto hasUpper = upper + 1 < kCoinSpendCandidates.size();
+    if (hasLower && hasUpper) {
+        auto lowerCoins = (double) kCoinSpendCandidates[lower - 1];
+        auto upperCoins = (double) kCoinSpendCandidates[upper + 1];
+        auto lowerDigs = estimateDigs(lower - 1);
+        auto upperDigs = estimateDigs(upper + 1);
+        return lowerDigs + (upperDigs - lowerDigs) * (coins - lowerCoins) / (upperCoins - lowerCoins);
+    }
+    if (hasLower) {
+        return estimateDigs(lower - 1) * coins / (double) kCoinSpendCandidates[lower - 1];
+    }
+    if (hasUpper) {
+        return estimateDigs(upper + 1) * coins / (double) kCoinSpendCandidates[upper + 1];
+    }
+    return coins * kCoinSpendPriorDigsPerCoin;
+}
+
+double CoinSpendOptimizer::licenseCostPerDig(double licenseLatencyMcs) const noexcept {
+    auto digs = freeDigsSum_;
+    for (auto sum : digsSum_) {
+        digs += sum;
+    }
+    auto digsPerLicense = digs > 0 ? (double) digs / (double) issuedCnt_ : estimateDigs(0);
+    return licenseLatencyMcs / std::max(digsPerLicense, 1.0);
+}
+
+size_t
+CoinSpendOptimizer::chooseCoinsCount(size_t balance, size_t queuedDigsCnt, LicenseClock::time_point now) noexcept {
+    auto demand = std::max(1.0, std::ceil((double) queuedDigsCnt /
+                                           (double) runtimeConfig().get().maxLicensesCount_));
+    auto freeCovers = freeDigsCnt_ > 0 && (double) freeDigsSum_ / (double) freeDigsCnt_ >= demand;
+    if (balance == 0) {
+        allowance_ = 0.0;
+        coinLimited_ = !freeCovers;
+        return 0;
+    }
+    auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(now - startedAt_);
+    auto timeLeft = gameDuration_ - elapsed;
+    if (timeLeft.count() < kCoinSpendMinTimeLeftMs) {
+        coinLimited_ = false;
+        return 0;
+    }
+
+    // the license rate observed so far tells how many licenses are still going to be issued
+    auto licensesLeft = 1.0;
+    if (issuedCnt_ > 0 && elapsed.count() > 0) {
+        licensesLeft = std::max(licensesLeft,
+                                (double) issuedCnt_ * (double) timeLeft.count() / (double) elapsed.count());
+    }
+    allowance_ = std::min(allowance_ + (double) balance / licensesLeft, (double) balance);
+
+    if (freeCovers) {
+        coinLimited_ = false;
+        return 0;
+    }
+
+    size_t best{0};
+    double bestDigs{0.0};
+    for (size_t i = 0; i < kCoinSpendCandidates.size(); i++) {
+        auto coins = (size_t) kCoinSpendCandidates[i];
+        if ((double) coins > allowance_) {
+            break;
+        }
+        auto digs = estimateDigs(i);
+        // more coins for the same digs are never worth it
+        if (digs > bestDigs) {
+            best = coins;
+            bestDigs = digs;
+        }
+        if (digs >= demand) {
+            break;
+        }
+    }
+    allowance_ -= (double) best;
+    coinLimited_ = bestDigs < demand;
+    return best;
+}
@@ -0,0 +1,56 @@
+#ifndef HIGHLOADCUP2021_COIN_SPEND_OPTIMIZER_H
+#define HIGHLOADCUP2021_COIN_SPEND_OPTIMIZER_H
+
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include "const.h"
+#include "license_manager.h"
+
+// Chooses how many coins to pay for the next license.
+// The digs a license gives for k coins are learned from /licenses responses, candidates that were
+// never bought are interpolated from the observed ones (kCoinSpendPriorDigsPerCoin without observations).
+// Coins are released as an allowance that spreads the balance over the licenses expected till the end
+// of the game, and the cheapest candidate that covers the per slot dig backlog is bought from it.
+// The free license is used when it covers the backlog alone or when the game is too close to the end
+// for the bought digs to pay back.
+class CoinSpendOptimizer {
+    std::array<int64_t, kCoinSpendCandidates.size()> digsSum_{};
+    std::array<int64_t, kCoinSpendCandidates.size()> digsCnt_{};
+    int64_t freeDigsSum_{0};
+    int64_t freeDigsCnt_{0};
+    int64_t issuedCnt_{0};
+    double allowance_{0.0};
+    bool coinLimited_{false};
+    LicenseClock::time_point startedAt_;
+    std::chrono::milliseconds gameDuration_;
+
+    [[nodiscard]] static size_t candidateIdx(size_t coinsCnt) noexcept;
+
+public:
+    explicit CoinSpendOptimizer(LicenseClock::time_point startedAt,
+                                std::chrono::milliseconds gameDuration = std::chrono::milliseconds(kGameDurationMs))
+            noexcept: startedAt_{startedAt}, gameDuration_{gameDuration} {}
+
+    void rebase(LicenseClock::time_point startedAt) noexcept {
+        startedAt_ = startedAt;
+    }
+
+    // Records digAllowed of an issued license, coinsCnt is 0 for the free one.
+    void recordLicense(size_t coinsCnt, uint32_t digAllowed) noexcept;
+
+    [[nodiscard]] double estimateDigs(size_t candidate) const noexcept;
+
+    // Share of the license round trip one dig takes, by the digs the issued licenses gave so far.
+    [[nodiscard]] double licenseCostPerDig(double licenseLatencyMcs) const noexcept;
+
+    [[nodiscard]] size_t
+    chooseCoinsCount(size_t balance, size_t queuedDigsCnt, LicenseClock::time_point now) noexcept;
+
+    // The last chosen license did not cover the dig backlog because of the coins balance.
+    [[nodiscard]] bool isCoinLimited() const noexcept {
+        return coinLimited_;
+    }
+};
+
+#endif //HIGHLOADCUP2021_COIN_SPEND_OPTIMIZER_H
@@ -0,0 +1,188 @@
+#include "config.h"
+#include <algorithm>
+#include <charconv>
+#include <csignal>
+#include <cstdlib>
+#include <fstream>
+#include <sstream>
+
+namespace {
+
+constexpr std::array<std::string_view, 6> kConfigKeys{"API_THREADS", "MAX_LICENSES", "EXPLORE_CONCURRENCY",
+                                                      "CASH_RATIO", "REQUEST_TIMEOUT_MS", "EXPLORE_AREAS"};
+
+std::string_view trim(std::string_view s) noexcept {
+    while (!s.empty() && (s.front() == ' ' || s.front() == '\t' || s.front() == '\r')) {
+        s.remove_prefix(1);
+    }
+    while (!s.empty() && (s.back() == ' ' || s.back() == '\t' || s.back() == '\r')) {
+        s.remove_suffix(1);
+    }
+    return s;
+}
+
+template<class T>
+bool parseInt(std::string_view s, T minVal, T maxVal, T &out) noexcept {
+    T val{};
+    auto [ptr, ec] = std::from_chars(s.data(), s.data() + s.size(), val);
+    if (ec != std::errc() || ptr != s.data() + s.size() || val < minVal || val > maxVal) {
+        return false;
+    }
+    out = val;
+    return true;
+}
+
+bool parseDouble(std::string_view s, double minVal, double maxVal, double &out) {
+    std::string str{s};
+    char *end{nullptr};
+    auto val = std::strtod(str.c_str(), &end);
+    if (str.empty() || end != str.c_str() + str.size() || !(val >= minVal && val <= maxVal)) {
+        return false;
+    }
+    out = val;
+    return true;
+}
+
+// HEIGHTxWIDTH pairs separated by commas.
+bool parseExploreAreas(std::string_view s, RuntimeConfig &config) noexcept {
+    std::array<ExploreAreaShift, kConfigMaxExploreAreas> areas{};
+    size_t cnt{0};
+    while (!s.empty()) {
+        auto comma = s.find(',');
+        auto item = trim(s.substr(0, comma));
+        s = comma == std::string_view::npos ? std::string_view{} : s.substr(comma + 1);
+        auto x = item.find('x');
+        if (cnt == areas.size() || x == std::string_view::npos ||
+            !parseInt<int16_t>(item.substr(0, x), 1, (int16_t) kFieldMaxX, areas[cnt].height) ||
+            !parseInt<int16_t>(item.substr(x + 1), 1, (int16_t) kFieldMaxY, areas[cnt].width)) {
+            return false;
+        }
+        cnt++;
+    }
+    if (cnt == 0) {
+        return false;
+    }
+    config.exploreAreas_ = areas;
+    config.exploreAreasCnt_ = cnt;
+    return true;
+}
+
+void onSighup(int) {
+    runtimeConfig().requestReload();
+}
+
+}
+
+RuntimeConfig::RuntimeConfig() noexcept {
+    std::copy(kExploreAreas.begin(), kExploreAreas.end(), exploreAreas_.begin());
+    exploreAreasCnt_ = kExploreAreas.size();
+}
+
+std::ostream &operator<<(std::ostream &os, const RuntimeConfig &config) {
+    os << "version " << config.version_ << " api threads " << config.apiThreadCount_ << " licenses "
+       << config.maxLicensesCount_ << " explore concurrency " << config.exploreConcurrentRequestsCnt_
+       << " cash ratio " << config.cashPolicyCashRatio_ << " request timeout " << config.requestTimeoutMs_
+       << " ms explore areas ";
+    for (size_t i = 0; i < config.exploreAreasCnt_; i++) {
+        os << (i > 0 ? "," : "") << config.exploreAreas_[i].height << "x" << config.exploreAreas_[i].width;
+    }
+    return os;
+}
+
+ExpectedVoid applyConfigValue(RuntimeConfig &config, std::string_view key, std::string_view value) noexcept {
+    value = trim(value);
+    bool ok{false};
+    if (key == "API_THREADS") {
+        ok = parseInt<size_t>(value, 1, kConfigMaxApiThreadCount, config.apiThreadCount_);
+    } else if (key == "MAX_LICENSES") {
+        // the server keeps kMaxLicensesCount licenses at most, the license records are sized for it
+        ok = parseInt<size_t>(value, 1, kMaxLicensesCount, config.maxLicensesCount_);
+    } else if (key == "EXPLORE_CONCURRENCY") {
+        ok = parseInt<size_t>(value, kExploreControllerMinConcurrency, kExploreControllerMaxConcurrency,
+                              config.exploreConcurrentRequestsCnt_);
+    } else if (key == "CASH_RATIO") {
+        ok = parseDouble(value, 0.0, 1.0, config.cashPolicyCashRatio_);
+    } else if (key == "REQUEST_TIMEOUT_MS") {
+        ok = parseInt<long>(value, 1, kRequestTimeout, config.requestTimeoutMs_);
+    } else if (key == "EXPLORE_AREAS") {
+        ok = parseExploreAreas(value, config);
+    }
+    if (!ok) {
+        return ErrorCode::kConfigError;
+    }
+    return NoErr;
+}
+
+ExpectedVoid applyConfigText(RuntimeConfig &config, std::string_view text, std::string &badLine) noexcept {
+    while (!text.empty()) {
+        auto eol = text.find('\n');
+        auto line = trim(text.substr(0, eol));
+        text = eol == std::string_view::npos ? std::string_view{} : text.substr(eol + 1);
+        if (line.empty() || line.front() == '#') {
+            continue;
+        }
+        auto eq = line.find('=');
+        if (eq == std::string_view::npos ||
+            applyConfigValue(config, trim(line.substr(0, eq)), line.substr(eq + 1)).hasError()) {
+            badLine = line;
+            return ErrorCode::kConfigError;
+        }
+    }
+    return NoErr;
+}
+
+Expected<RuntimeConfig> loadRuntimeConfig(std::string &badLine) noexcept {
+    RuntimeConfig config;
+    for (auto key : kConfigKeys) {
+        auto valueEnv = std::getenv(std::string(key).c_str());
+        if (valueEnv != nullptr && applyConfigValue(config, key, valueEnv).hasError()) {
+            badLine = std::string(key) + "=" + valueEnv;
+            return ErrorCode::kConfigError;
+        }
+    }
+    auto pathEnv = std::getenv("CONFIG_PATH");
+    if (pathEnv == nullptr) {
+        return config;
+    }
+    std::ifstream in(pathEnv);
+    if (!in) {
+        badLine = pathEnv;
+        return ErrorCode::kConfigError;
+    }
+    std::stringstream text;
+    text << in.rdbuf();
+    if (auto err = applyConfigText(config, text.str(), badLine); err.hasError()) {
+        return err.error();
+    }
+    return config;
+}
+
+RuntimeConfigStore::RuntimeConfigStore() {
+    versions_.push_back(std::make_unique<RuntimeConfig>());
+    current_ = versions_.back().get();
+}
+
+const RuntimeConfig &RuntimeConfigStore::publish(RuntimeConfig config) noexcept {
+    std::lock_guard<std::mutex> lock(mu_);
+    if (versions_.size() > 1) {
+        const auto &startup = *versions_[1];
+        config.apiThreadCount_ = startup.apiThreadCount_;
+        config.maxLicensesCount_ = startup.maxLicensesCount_;
+        reloadsCnt_++;
+    }
+    config.version_ = versions_.size();
+    versions_.push_back(std::make_unique<RuntimeConfig>(config));
+    current_.store(versions_.back().get(), std::memory_order_release);
+    return *versions_.back();
+}
+
+RuntimeConfigStore &runtimeConfig() noexcept {
+    static RuntimeConfigStore store;
+    return store;
+}
+
+void installConfigReloadHandler() noexcept {
+    // the store is created before the handler may touch it
+    runtimeConfig();
+    std::signal(SIGHUP, onSighup);
+}
@@ -0,0 +1,104 @@
+#ifndef HIGHLOADCUP2021_CONFIG_H
+#define HIGHLOADCUP2021_CONFIG_H
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "const.h"
+#include "error.h"
+
+// Tuning knobs that change without a rebuild. Defaults come from const.h, the environment overrides
+// them and the file of CONFIG_PATH overrides the environment, so that a reload on SIGHUP can change
+// every key. The keys are the environment variable names:
+//   API_THREADS, MAX_LICENSES, EXPLORE_CONCURRENCY, CASH_RATIO, REQUEST_TIMEOUT_MS and
+//   EXPLORE_AREAS, e.g. EXPLORE_AREAS=3500x1,875x1,219x1.
+// API_THREADS sizes the worker pool and MAX_LICENSES splits the license slots between shards,
+// both are only taken at startup.
+struct RuntimeConfig {
+    uint64_t version_{0};
+    size_t apiThreadCount_{kApiThreadCount};
+    size_t maxLicensesCount_{kMaxLicensesCount};
+    size_t exploreConcurrentRequestsCnt_{kExploreConcurrentRequestsCnt};
+    double cashPolicyCashRatio_{kCashPolicyCashRatio};
+    long requestTimeoutMs_{kRequestTimeout};
+    std::array<ExploreAreaShift, kConfigMaxExploreAreas> exploreAreas_{};
+    size_t exploreAreasCnt_{0};
+
+    RuntimeConfig() noexcept;
+
+    // The static explore split of the given depth, the last one repeats.
+    [[nodiscard]] ExploreAreaShift getExploreAreaShift(size_t depth) const noexcept {
+        return exploreAreas_[std::min(depth, exploreAreasCnt_ - 1)];
+    }
+};
+
+std::ostream &operator<<(std::ostream &os, const RuntimeConfig &config);
+
+// Returns kConfigError for an unknown key or a value out of its range, the config is left as is then.
+[[nodiscard]] ExpectedVoid applyConfigValue(RuntimeConfig &config, std::string_view key, std::string_view value) noexcept;
+
+// Applies KEY=VALUE lines, empty lines and lines starting with # are skipped.
+// The first bad line is stored to badLine.
+[[nodiscard]] ExpectedVoid applyConfigText(RuntimeConfig &config, std::string_view text, std::string &badLine) noexcept;
+
+// Reads the environment and CONFIG_PATH over the defaults.
+[[nodiscard]] Expected<RuntimeConfig> loadRuntimeConfig(std::string &badLine) noexcept;
+
+// Publishes immutable versions of RuntimeConfig, readers on the hot path take the current one with
+// a single acquire load and never lock. Versions are never freed, so a reader may keep a reference
+// as long as it wants: a reload costs one small allocation and happens a few times per game.
+class RuntimeConfigStore {
+    std::mutex mu_;
+    std::vector<std::unique_ptr<RuntimeConfig>> versions_;
+    std::atomic<const RuntimeConfig *> current_;
+    std::atomic<bool> reloadRequested_{false};
+    std::atomic<int64_t> reloadsCnt_{0};
+
+public:
+    RuntimeConfigStore();
+
+    RuntimeConfigStore(const RuntimeConfigStore &o) = delete;
+
+    RuntimeConfigStore(RuntimeConfigStore &&o) = delete;
+
+    RuntimeConfigStore &operator=(const RuntimeConfigStore &o) = delete;
+
+    RuntimeConfigStore &operator=(RuntimeConfigStore &&o) = delete;
+
+    [[nodiscard]] const RuntimeConfig &get() const noexcept {
+        return *current_.load(std::memory_order_acquire);
+    }
+
+    // The first published config is the startup one, later ones keep its startup only knobs.
+    // Returns the published version.
+    const RuntimeConfig &publish(RuntimeConfig config) noexcept;
+
+    // Async signal safe.
+    void requestReload() noexcept {
+        reloadRequested_.store(true, std::memory_order_relaxed);
+    }
+
+    // Returns true once per requested reload, whichever thread asks first takes it.
+    [[nodiscard]] bool takeReloadRequest() noexcept {
+        return reloadRequested_.load(std::memory_order_relaxed) && reloadRequested_.exchange(false);
+    }
+
+    [[nodiscard]] int64_t getReloadsCnt() const noexcept {
+        return reloadsCnt_.load();
+    }
+};
+
+// The config of the process.
+RuntimeConfigStore &runtimeConfig() noexcept;
+
+// SIGHUP requests a reload of runtimeConfig(), event loops take it with takeReloadRequest.
+void installConfigReloadHandler() noexcept;
+
+#endif //HIGHLOADCUP2021_CONFIG_H
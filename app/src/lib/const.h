@@ -1,6 +1,7 @@
 #ifndef HIGHLOADCUP2021_CONST_H
 #define HIGHLOADCUP2021_CONST_H
 
+#include <cstdint>
 #include <cstdlib>
 #include <array>
 
@@ -15,6 +16,18 @@ constexpr size_t kJsonParseBufferSize = kJsonParseBufferCap * kJsonBufferTypeSiz
 constexpr size_t kMaxApiRequestsQueueSize = 10'000'000;
 
 constexpr size_t kApiThreadCount = 50;
+constexpr size_t kConfigMaxApiThreadCount = 256;
+constexpr size_t kStateShardsCnt = 1;
+// every shard keeps its own field sized cell maps
+constexpr size_t kStateMaxShardsCnt = 8;
+constexpr size_t kCoinExchangeCap = 1 << 16;
+// coins a shard keeps for itself before offering the rest to other shards
+constexpr size_t kCoinExchangeKeepCoins = 64;
+constexpr size_t kCoinExchangeBatch = 16;
+// every process shard needs at least one license slot
+constexpr size_t kProcessMaxShardsCnt = 10;
+// a shard takes spare license slots given up by other shards while it has more queued digs than this
+constexpr size_t kLicensePoolMinQueuedDigs = 100;
 constexpr int64_t kMaxRPS = 1'000'000;
 
 constexpr size_t kFieldMaxX = 3'500;
@@ -37,15 +50,116 @@ constexpr std::array<ExploreAreaShift, 9> kExploreAreas = {
                 {1, 1}
         }
 };
+// EXPLORE_AREAS takes up to this many splits
+constexpr size_t kConfigMaxExploreAreas = 16;
+
+enum class ExploreSplitMode : int {
+    Static = 0,
+    Adaptive = 1,
+};
+
+enum class ExplorePartitionScheme : int {
+    Strips = 0,
+    Grid = 1,
+    Quadtree = 2,
+};
+
+constexpr ExploreSplitMode kExploreSplitMode{ExploreSplitMode::Static};
+constexpr ExplorePartitionScheme kExplorePartitionScheme{ExplorePartitionScheme::Strips};
+constexpr size_t kExplorePlannerMaxFanoutLog = 12;
+constexpr int64_t kExplorePlannerRebuildPeriod = 1'000;
+constexpr int64_t kExplorePlannerMinLatencySamples = 50;
+// SIBLING_UNION=off turns it off
+constexpr bool kExploreSiblingUnion{true};
+constexpr size_t kExploreSiblingUnionMaxMembers = 8;
 
 constexpr size_t kTreasuriesCount = 490'000;
 
+constexpr size_t kDensityTileSize = 175;
+constexpr size_t kDensityTilesX = (kFieldMaxX + kDensityTileSize - 1) / kDensityTileSize;
+constexpr size_t kDensityTilesY = (kFieldMaxY + kDensityTileSize - 1) / kDensityTileSize;
+constexpr size_t kDensityPriorMaxDepth = 2;
+constexpr int64_t kDensityMapSavePeriodMs = 10'000;
+
+constexpr int64_t kSnapshotPeriodMs = 1'000;
+// room for the explore frontier, coins and treasures waiting for cash in one snapshot slot
+constexpr size_t kSnapshotSlotCap = 32 << 20;
+
+enum class HugePagesMode : int {
+    Off = 0,
+    // madvise(MADV_HUGEPAGE), the kernel backs an arena with transparent huge pages as it can
+    Transparent = 1,
+    // MAP_HUGETLB from the vm.nr_hugepages pool, an arena falls back to Transparent if the pool is short
+    Explicit = 2,
+};
+
+constexpr HugePagesMode kHugePages{HugePagesMode::Transparent};
+constexpr size_t kHugePageSize = 2 << 20;
+// freed arena blocks up to this size are pooled by size class, larger ones are reused by exact size
+constexpr size_t kArenaMaxPooledSize = 256;
+// one cell grid of 49 MB per state shard
+constexpr size_t kStateGridArenaCap = 50 << 20;
+// two json buffers per http client
+constexpr size_t kHttpBuffersArenaCap = 4 << 20;
+// explore nodes and explore queue entries, only the touched pages count against the memory limit
+constexpr size_t kExploreTreeArenaCap = 256 << 20;
+
+enum class ThreadPlacementMode : int {
+    Off = 0,
+    // app threads on dedicated physical cores, the other threads on the remaining cores
+    Pinned = 1,
+};
+
+constexpr ThreadPlacementMode kThreadPlacement{ThreadPlacementMode::Pinned};
+// 0 keeps the app threads under SCHED_OTHER, 1..99 runs them under SCHED_FIFO with this priority
+constexpr int kAppThreadFifoPriority = 0;
+constexpr int kAppThreadNice = 0;
+
 constexpr long kRequestTimeout = 1'000'000;
 
 constexpr size_t kMaxLicensesCount = 10;
+constexpr int64_t kLicenseEarlyIssueMinSamples = 20;
+constexpr double kLicenseEarlyIssueLeadFactor = 0.5;
+// a license rejected with no exhausted license left to wait for is requested again after a doubling delay
+constexpr int64_t kLicenseRetryBackoffMinMs = 1;
+constexpr int64_t kLicenseRetryBackoffMaxMs = 64;
+constexpr int32_t kApiErrNoMoreActiveLicenses = 1002;
+constexpr int32_t kApiErrTreasureNotDigged = 1003;
+constexpr int32_t kApiErrBogusCoin = 402;
+constexpr int64_t kGameDurationMs = 600'000;
+constexpr bool kEndGameMode{true};
+constexpr int64_t kGameDeadlineMarginMs = 1'000;
+constexpr int64_t kStageLatencyPriorMs = 100;
+constexpr int64_t kEndGameDigChainLength = 3;
+constexpr std::array<int32_t, 7> kCoinSpendCandidates{1, 2, 4, 8, 16, 32, 64};
+constexpr double kCoinSpendPriorDigsPerCoin = 1.0;
+constexpr int64_t kCoinSpendMinTimeLeftMs = 20'000;
 
 constexpr size_t kExploreConcurrentRequestsCnt{10};
+constexpr bool kSpeculativeDig{false};
+constexpr size_t kSpeculativeDigMaxArea = 4;
+constexpr int64_t kExploreControllerPeriodMs = 100;
+// the undug cells backlog is kept around this many digs of all license slots
+constexpr double kExploreControllerBacklogFactor = 2.0;
+// relative error around the setpoint that does not move the output
+constexpr double kExploreControllerBand = 0.25;
+constexpr double kExploreControllerKp = 4.0;
+constexpr double kExploreControllerKi = 1.0;
+constexpr size_t kExploreControllerMinConcurrency = 1;
+constexpr size_t kExploreControllerMaxConcurrency = 40;
 
-constexpr int minDepthToCash{2};
+constexpr size_t kMaxDigDepth = 10;
+// treasure ids are uuids in the stub server, the rest keeps room for longer ids
+constexpr size_t kTreasureIdCap = 63;
+constexpr size_t kDigTreasuresInlineCap = 4;
+constexpr size_t kWalletInlineCoins = 32;
+constexpr size_t kDigSchedulerLeftBuckets = 8;
+constexpr int64_t kCashPolicyMinSamples = 20;
+// a treasure is cashed at once if its coins per cash latency reach this share of the best depth
+constexpr double kCashPolicyCashRatio = 0.5;
+constexpr size_t kCashPolicyMaxDeferred = 1 << 16;
+constexpr size_t kCashPolicyDrainBatch = 4;
+// share of API_THREADS a background cash request never takes, it is kept for explore and dig
+constexpr double kCashLaneReservedShare = 0.25;
 
 #endif //HIGHLOADCUP2021_CONST_H
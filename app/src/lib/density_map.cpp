@@ -0,0 +1,188 @@
+#include "density_map.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <fstream>
+#include "util.h"
+
+template<class F>
+void forEachOverlappedTile(const Area &area, F f) {
+    auto x1 = (size_t) area.posX_;
+    auto x2 = (size_t) area.posX_ + (size_t) area.sizeX_;
+    auto y1 = (size_t) area.posY_;
+    auto y2 = (size_t) area.posY_ + (size_t) area.sizeY_;
+    for (auto tx = x1 / kDensityTileSize; tx < kDensityTilesX && tx * kDensityTileSize < x2; tx++) {
+        auto overlapX = std::min(x2, (tx + 1) * kDensityTileSize) - std::max(x1, tx * kDensityTileSize);
+        for (auto ty = y1 / kDensityTileSize; ty < kDensityTilesY && ty * kDensityTileSize < y2; ty++) {
+            auto overlapY = std::min(y2, (ty + 1) * kDensityTileSize) - std::max(y1, ty * kDensityTileSize);
+            f(tx, ty, overlapX * overlapY);
+        }
+    }
+}
+
+ExpectedVoid DensityMap::load(const std::string &path) noexcept {
+    std::ifstream in(path);
+    if (!in) {
+        return ErrorCode::kDensityMapReadError;
+    }
+    size_t tilesX{0}, tilesY{0}, tileSize{0};
+    in >> tilesX >> tilesY >> tileSize;
+    if (!in || tilesX != kDensityTilesX || tilesY != kDensityTilesY || tileSize != kDensityTileSize) {
+        return ErrorCode::kDensityMapReadError;
+    }
+
+    int64_t totalTreasuries{0}, totalResolvedCells{0};
+    for (size_t x = 0; x < kDensityTilesX; x++) {
+        for (size_t y = 0; y < kDensityTilesY; y++) {
+            in >> priorTreasuries_[x][y] >> priorResolvedCells_[x][y];
+            totalTreasuries += priorTreasuries_[x][y];
+            totalResolvedCells += priorResolvedCells_[x][y];
+        }
+    }
+    if (!in) {
+        priorTreasuries_ = {};
+        priorResolvedCells_ = {};
+        return ErrorCode::kDensityMapReadError;
+    }
+    if (totalResolvedCells > 0) {
+        priorMeanDensity_ = (double) totalTreasuries / (double) totalResolvedCells;
+    }
+    hasPrior_ = true;
+    return NoErr;
+}
+
+ExpectedVoid DensityMap::save(const std::string &path) const noexcept {
+    auto tmpPath = path + ".tmp";
+    {
+        std::ofstream out(tmpPath, std::ios::trunc);
+        if (!out) {
+            return ErrorCode::kDensityMapWriteError;
+        }
+        out << kDensityTilesX << ' ' << kDensityTilesY << ' ' << kDensityTileSize << '\n';
+        for (size_t x = 0; x < kDensityTilesX; x++) {
+            for (size_t y = 0; y < kDensityTilesY; y++) {
+                out << priorTreasuries_[x][y] + treasuries_[x][y] << ' '
+                    << priorResolvedCells_[x][y] + resolvedCells_[x][y] << ' ';
+            }
+            out << '\n';
+        }
+        if (!out) {
+            return ErrorCode::kDensityMapWriteError;
+        }
+    }
+    if (std::rename(tmpPath.c_str(), path.c_str()) != 0) {
+        return ErrorCode::kDensityMapWriteError;
+    }
+    return NoErr;
+}
+
+void DensityMap::recordExploredArea(const Area &area, size_t treasuriesCnt) noexcept {
+    if (treasuriesCnt > 0 && area.getArea() > 1) {
+        // the treasures position is unknown yet, the cells are recorded once the area is split down
+        return;
+    }
+    forEachOverlappedTile(area, [this, treasuriesCnt](size_t x, size_t y, size_t cells) {
+        resolvedCells_[x][y] += (int64_t) cells;
+        treasuries_[x][y] += (int64_t) treasuriesCnt;
+    });
+}
+
+double DensityMap::getPriorTileDensity(size_t x, size_t y) const noexcept {
+    if (priorResolvedCells_[x][y] == 0) {
+        return priorMeanDensity_;
+    }
+    return (double) priorTreasuries_[x][y] / (double) priorResolvedCells_[x][y];
+}
+
+double DensityMap::getPriorExpectedTreasuriesCnt(const Area &area) const noexcept {
+    double ret{0.0};
+    forEachOverlappedTile(area, [this, &ret](size_t x, size_t y, size_t cells) {
+        ret += getPriorTileDensity(x, y) * (double) cells;
+    });
+    return ret;
+}
+
+double DensityMap::getPriorMismatch() const noexcept {
+    double priorSum{0.0}, observedSum{0.0};
+    for (size_t x = 0; x < kDensityTilesX; x++) {
+        for (size_t y = 0; y < kDensityTilesY; y++) {
+            if (resolvedCells_[x][y] > 0 && priorResolvedCells_[x][y] > 0) {
+                priorSum += getPriorTileDensity(x, y);
+                observedSum += (double) treasuries_[x][y] / (double) resolvedCells_[x][y];
+            }
+        }
+    }
+    if (priorSum <= 0.0 || observedSum <= 0.0) {
+        return 0.0;
+    }
+
+    double distance{0.0};
+    for (size_t x = 0; x < kDensityTilesX; x++) {
+        for (size_t y = 0; y < kDensityTilesY; y++) {
+            if (resolvedCells_[x][y] > 0 && priorResolvedCells_[x][y] > 0) {
+                auto observed = (double) treasuries_[x][y] / (double) resolvedCells_[x][y];
+                distance += std::fabs(getPriorTileDensity(x, y) / priorSum - observed / observedSum);
+            }
+        }
+    }
+    return distance / 2.0;
+}
+
+DensityMapWriter::~DensityMapWriter() {
+    if (!writer_.joinable()) {
+        return;
+    }
+    {
+        std::lock_guard<std::mutex> lock(mu_);
+        stopped_ = true;
+    }
+    cv_.notify_all();
+    writer_.join();
+}
+
+void DensityMapWriter::start(std::string path, OnSaved onSaved) {
+    path_ = std::move(path);
+    onSaved_ = std::move(onSaved);
+    writer_ = std::thread(&DensityMapWriter::writerLoop, this);
+}
+
+bool DensityMapWriter::submit(const DensityMap &map) noexcept {
+    if (!writer_.joinable()) {
+        return false;
+    }
+    {
+        std::lock_guard<std::mutex> lock(mu_);
+        if (hasPending_) {
+            return false;
+        }
+        pending_ = map;
+        hasPending_ = true;
+    }
+    cv_.notify_all();
+    return true;
+}
+
+void DensityMapWriter::flush() noexcept {
+    std::unique_lock<std::mutex> lock(mu_);
+    cv_.wait(lock, [this] { return !hasPending_ || stopped_; });
+}
+
+void DensityMapWriter::writerLoop() noexcept {
+    std::unique_lock<std::mutex> lock(mu_);
+    for (;;) {
+        cv_.wait(lock, [this] { return hasPending_ || stopped_; });
+        if (stopped_) {
+            return;
+        }
+        // the app thread only copies the map under the lock, the save runs without it
+        lock.unlock();
+        Measure<std::chrono::microseconds> tm;
+        auto err = pending_.save(path_);
+        if (onSaved_) {
+            onSaved_(tm.getInt64(), err.hasError() ? err.error() : ErrorCode::kNoErr);
+        }
+        lock.lock();
+        hasPending_ = false;
+        cv_.notify_all();
+    }
+}
@@ -0,0 +1,93 @@
+#ifndef HIGHLOADCUP2021_DENSITY_MAP_H
+#define HIGHLOADCUP2021_DENSITY_MAP_H
+
+#include <array>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include "api_entities.h"
+#include "const.h"
+#include "error.h"
+
+// Per tile treasures heatmap of the field.
+// Observations come from areas with a known count that are not split any further: cells with
+// treasures and empty areas. A map saved by a previous run is loaded as a prior and ranks
+// the initial subdivisions; the saved map accumulates the prior and the current observations.
+class DensityMap {
+    using Tiles = std::array<std::array<int64_t, kDensityTilesY>, kDensityTilesX>;
+
+    Tiles treasuries_{};
+    Tiles resolvedCells_{};
+    Tiles priorTreasuries_{};
+    Tiles priorResolvedCells_{};
+    bool hasPrior_{false};
+    double priorMeanDensity_{(double) kTreasuriesCount / (double) (kFieldMaxX * kFieldMaxY)};
+
+    [[nodiscard]] double getPriorTileDensity(size_t x, size_t y) const noexcept;
+
+public:
+    [[nodiscard]] ExpectedVoid load(const std::string &path) noexcept;
+
+    [[nodiscard]] ExpectedVoid save(const std::string &path) const noexcept;
+
+    [[nodiscard]] bool hasPrior() const noexcept {
+        return hasPrior_;
+    }
+
+    void recordExploredArea(const Area &area, size_t treasuriesCnt) noexcept;
+
+    [[nodiscard]] double getPriorExpectedTreasuriesCnt(const Area &area) const noexcept;
+
+    // Total variation distance between prior and observed densities over tiles known to both,
+    // 0 means the prior matches this run, 1 means it is disjoint from it.
+    [[nodiscard]] double getPriorMismatch() const noexcept;
+};
+
+// Saves copies of a DensityMap on its own thread, so the file I/O stays off the app event loop.
+class DensityMapWriter {
+public:
+    // Called on the writer thread after every save.
+    using OnSaved = std::function<void(int64_t saveMcs, ErrorCode err)>;
+
+private:
+    std::string path_;
+    OnSaved onSaved_;
+    std::mutex mu_;
+    std::condition_variable cv_;
+    DensityMap pending_;
+    bool hasPending_{false};
+    bool stopped_{false};
+    std::thread writer_;
+
+    void writerLoop() noexcept;
+
+public:
+    DensityMapWriter() = default;
+
+    ~DensityMapWriter();
+
+    DensityMapWriter(const DensityMapWriter &o) = delete;
+
+    DensityMapWriter(DensityMapWriter &&o) = delete;
+
+    DensityMapWriter &operator=(const DensityMapWriter &o) = delete;
+
+    DensityMapWriter &operator=(DensityMapWriter &&o) = delete;
+
+    void start(std::string path, OnSaved onSaved);
+
+    [[nodiscard]] bool isStarted() const noexcept {
+        return writer_.joinable();
+    }
+
+    // Copies the map for the writer thread. Returns false while it is busy with the previous copy.
+    bool submit(const DensityMap &map) noexcept;
+
+    // Waits for the submitted copy to be saved.
+    void flush() noexcept;
+};
+
+#endif //HIGHLOADCUP2021_DENSITY_MAP_H
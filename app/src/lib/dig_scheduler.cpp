@@ -0,0 +1,76 @@
+#include "dig_scheduler.h"
+#include <algorithm>
+
+size_t DigScheduler::bucketIdx(int8_t depth, int32_t leftTreasuriesCnt) noexcept {
+    auto left = (size_t) std::clamp(leftTreasuriesCnt, 1, (int32_t) kDigSchedulerLeftBuckets);
+    return (depthIdx(depth) - 1) * kDigSchedulerLeftBuckets + left - 1;
+}
+
+double DigScheduler::depthShare(size_t depth) const noexcept {
+    // add-one smoothing gives the uniform split over the remaining depths before anything is found
+    int64_t deeper{0};
+    for (auto d = depth; d <= kMaxDigDepth; d++) {
+        deeper += foundAtDepth_[d] + 1;
+    }
+    return (double) (foundAtDepth_[depth] + 1) / (double) deeper;
+}
+
+void DigScheduler::push(DelayedDigRequest r, int32_t leftTreasuriesCnt) noexcept {
+    int32_t idx;
+    if (freeHead_ != kNil) {
+        idx = freeHead_;
+        freeHead_ = nodes_[(size_t) idx].next_;
+        nodes_[(size_t) idx] = {r, kNil};
+    } else {
+        idx = (int32_t) nodes_.size();
+        nodes_.push_back({r, kNil});
+    }
+
+    auto b = bucketIdx(r.depth_, leftTreasuriesCnt);
+    auto &bucket = buckets_[b];
+    if (bucket.tail_ == kNil) {
+        bucket.head_ = idx;
+        nonEmptyMask_[b / 64] |= (uint64_t) 1 << (b % 64);
+    } else {
+        nodes_[(size_t) bucket.tail_].next_ = idx;
+    }
+    bucket.tail_ = idx;
+    size_++;
+}
+
+DelayedDigRequest DigScheduler::pop() noexcept {
+    std::array<double, kMaxDigDepth + 1> shares{};
+    int64_t deeper{0};
+    for (auto d = kMaxDigDepth; d >= 1; d--) {
+        deeper += foundAtDepth_[d] + 1;
+        shares[d] = (double) (foundAtDepth_[d] + 1) / (double) deeper;
+    }
+
+    size_t best{0};
+    double bestYield{-1.0};
+    for (size_t w = 0; w < std::size(nonEmptyMask_); w++) {
+        for (auto mask = nonEmptyMask_[w]; mask != 0; mask &= mask - 1) {
+            auto b = w * 64 + (size_t) __builtin_ctzll(mask);
+            auto depth = b / kDigSchedulerLeftBuckets + 1;
+            auto left = b % kDigSchedulerLeftBuckets + 1;
+            auto yield = (double) left * shares[depth];
+            if (yield > bestYield) {
+                bestYield = yield;
+                best = b;
+            }
+        }
+    }
+
+    auto &bucket = buckets_[best];
+    auto idx = bucket.head_;
+    auto &node = nodes_[(size_t) idx];
+    bucket.head_ = node.next_;
+    if (bucket.head_ == kNil) {
+        bucket.tail_ = kNil;
+        nonEmptyMask_[best / 64] &= ~((uint64_t) 1 << (best % 64));
+    }
+    node.next_ = freeHead_;
+    freeHead_ = idx;
+    size_--;
+    return node.request_;
+}
@@ -0,0 +1,75 @@
+#ifndef HIGHLOADCUP2021_DIG_SCHEDULER_H
+#define HIGHLOADCUP2021_DIG_SCHEDULER_H
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <vector>
+#include "const.h"
+
+struct DelayedDigRequest {
+    int16_t x_, y_;
+    int8_t depth_;
+
+    DelayedDigRequest(int16_t x, int16_t y, int8_t depth) :
+            x_{x}, y_{y}, depth_{depth} {}
+};
+
+// Queues digs waiting for a license in buckets by depth and treasures left in the cell
+// (kDigSchedulerLeftBuckets, the last one holds the rest). The next dig is taken from the bucket
+// with the most expected treasures per dig: treasures left times the share of the treasures found
+// at the depth among the ones found at it and deeper. Queued digs live in a node pool that is reused,
+// so push and pop do not allocate once the pool has grown to the backlog size.
+class DigScheduler {
+    static constexpr size_t kBucketsCnt = kMaxDigDepth * kDigSchedulerLeftBuckets;
+    static constexpr int32_t kNil = -1;
+
+    struct Node {
+        DelayedDigRequest request_;
+        int32_t next_;
+    };
+
+    struct Bucket {
+        int32_t head_{kNil};
+        int32_t tail_{kNil};
+    };
+
+    std::vector<Node> nodes_;
+    int32_t freeHead_{kNil};
+    std::array<Bucket, kBucketsCnt> buckets_{};
+    uint64_t nonEmptyMask_[(kBucketsCnt + 63) / 64]{};
+    std::array<int64_t, kMaxDigDepth + 1> foundAtDepth_{};
+    size_t size_{0};
+
+    // the server digs 1..kMaxDigDepth, a depth out of it must not index past the per depth arrays
+    [[nodiscard]] static size_t depthIdx(int8_t depth) noexcept {
+        return (size_t) std::clamp((int) depth, 1, (int) kMaxDigDepth);
+    }
+
+    [[nodiscard]] static size_t bucketIdx(int8_t depth, int32_t leftTreasuriesCnt) noexcept;
+
+    [[nodiscard]] double depthShare(size_t depth) const noexcept;
+
+public:
+    void push(DelayedDigRequest r, int32_t leftTreasuriesCnt) noexcept;
+
+    [[nodiscard]] DelayedDigRequest pop() noexcept;
+
+    void recordFoundTreasures(int8_t depth, size_t cnt) noexcept {
+        foundAtDepth_[depthIdx(depth)] += (int64_t) cnt;
+    }
+
+    [[nodiscard]] double getExpectedTreasuresPerDig(int8_t depth, int32_t leftTreasuriesCnt) const noexcept {
+        return (double) leftTreasuriesCnt * depthShare(depthIdx(depth));
+    }
+
+    [[nodiscard]] bool empty() const noexcept {
+        return size_ == 0;
+    }
+
+    [[nodiscard]] size_t size() const noexcept {
+        return size_;
+    }
+};
+
+#endif //HIGHLOADCUP2021_DIG_SCHEDULER_H
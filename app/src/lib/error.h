@@ -15,6 +15,14 @@ enum class ErrorCode : int {
     kTreasuriesLeftInconsistency = 7,
     kUnexpectedCashResponse = 8,
     kErrCurlTimeout = 9,
+    kDensityMapReadError = 10,
+    kDensityMapWriteError = 11,
+    kLicenseNotFound = 12,
+    kNoFreeLicenseRecord = 13,
+    kBrokerAttachError = 14,
+    kSnapshotError = 15,
+    kConfigError = 16,
+    kThreadPlacementError = 17,
 };
 
 std::ostream &operator<<(std::ostream &os, const ErrorCode &ec);
@@ -43,6 +51,11 @@ public:
     T get() &&{
         return std::move(std::get<T>(val_));
     }
+
+    // Unlike get() does not copy the value, hasError() is checked by the caller.
+    [[nodiscard]] T &value() & noexcept {
+        return *std::get_if<T>(&val_);
+    }
 };
 
 
@@ -0,0 +1,25 @@
+#include "explore_controller.h"
+#include <algorithm>
+#include <cmath>
+
+bool ExploreController::update(std::chrono::steady_clock::time_point now, size_t backlog, double digCapacity) noexcept {
+    if (now - updatedAt_ < std::chrono::milliseconds(kExploreControllerPeriodMs)) {
+        return false;
+    }
+    updatedAt_ = now;
+    backlog_ = backlog;
+    if (digCapacity <= 0.0) {
+        return false;
+    }
+    setpoint_ = kExploreControllerBacklogFactor * digCapacity;
+
+    auto error = std::clamp((setpoint_ - (double) backlog) / setpoint_, -1.0, 1.0);
+    if (std::abs(error) < kExploreControllerBand) {
+        error = 0.0;
+    }
+    concurrency_ += kExploreControllerKp * (error - prevError_) + kExploreControllerKi * error;
+    concurrency_ = std::clamp(concurrency_, (double) kExploreControllerMinConcurrency,
+                              (double) kExploreControllerMaxConcurrency);
+    prevError_ = error;
+    return true;
+}
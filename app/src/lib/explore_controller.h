@@ -0,0 +1,46 @@
+#ifndef HIGHLOADCUP2021_EXPLORE_CONTROLLER_H
+#define HIGHLOADCUP2021_EXPLORE_CONTROLLER_H
+
+#include <chrono>
+#include <cstdint>
+#include "const.h"
+
+// Adjusts the number of explore requests in flight so that the backlog of known undug cells
+// stays around kExploreControllerBacklogFactor times the digs license slots hold at once.
+// It is an incremental PI controller over the relative backlog error, updated every
+// kExploreControllerPeriodMs; errors inside kExploreControllerBand are ignored, so explores
+// are neither added while digs have targets nor removed while the backlog is draining.
+class ExploreController {
+    double concurrency_;
+    double prevError_{0.0};
+    double setpoint_{0.0};
+    size_t backlog_{0};
+    std::chrono::steady_clock::time_point updatedAt_{};
+
+public:
+    explicit ExploreController(size_t concurrency = kExploreConcurrentRequestsCnt) noexcept:
+            concurrency_{(double) concurrency} {}
+
+    // Restarts the controller from the given output, e.g. after EXPLORE_CONCURRENCY is reloaded.
+    void setConcurrency(size_t concurrency) noexcept {
+        concurrency_ = (double) concurrency;
+        prevError_ = 0.0;
+    }
+
+    // Returns true if the controller output was recalculated.
+    bool update(std::chrono::steady_clock::time_point now, size_t backlog, double digCapacity) noexcept;
+
+    [[nodiscard]] size_t getConcurrency() const noexcept {
+        return (size_t) concurrency_;
+    }
+
+    [[nodiscard]] double getSetpoint() const noexcept {
+        return setpoint_;
+    }
+
+    [[nodiscard]] size_t getBacklog() const noexcept {
+        return backlog_;
+    }
+};
+
+#endif //HIGHLOADCUP2021_EXPLORE_CONTROLLER_H
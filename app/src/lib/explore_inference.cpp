@@ -0,0 +1,176 @@
+#include "explore_inference.h"
+#include <algorithm>
+
+constexpr size_t kMaxReducedConstraintsCnt = 64;
+
+void ExploreInference::addConstraint(const ExploreAreaPtr &parent, std::vector<ExploreAreaPtr> areas,
+                                     size_t treasuriesCnt) {
+    constraints_[parent->id_].emplace_back(std::move(areas), treasuriesCnt);
+}
+
+std::vector<ExploreInference::ReducedConstraint> ExploreInference::reduce(const ExploreArea &parent) const {
+    std::vector<ReducedConstraint> ret;
+
+    ReducedConstraint parentConstraint{{}, parent.getLeftTreasuriesCnt()};
+    for (const auto &child : parent.children_) {
+        if (!child->explored_) {
+            parentConstraint.ids_.push_back(child->id_);
+        }
+    }
+    std::sort(parentConstraint.ids_.begin(), parentConstraint.ids_.end());
+    ret.push_back(std::move(parentConstraint));
+
+    auto it = constraints_.find(parent.id_);
+    if (it == constraints_.end()) {
+        return ret;
+    }
+    for (const auto &c : it->second) {
+        ReducedConstraint reduced{{}, c.treasuriesCnt_};
+        for (const auto &area : c.areas_) {
+            if (area->explored_) {
+                reduced.treasuriesCnt_ -= std::min(reduced.treasuriesCnt_, area->actualTreasuriesCnt_);
+            } else {
+                reduced.ids_.push_back(area->id_);
+            }
+        }
+        if (!reduced.ids_.empty()) {
+            std::sort(reduced.ids_.begin(), reduced.ids_.end());
+            ret.push_back(std::move(reduced));
+        }
+    }
+    return ret;
+}
+
+void ExploreInference::solve(std::vector<ReducedConstraint> &constraints, std::unordered_map<int32_t, size_t> &known) {
+    for (bool changed = true; changed;) {
+        changed = false;
+
+        for (auto &c : constraints) {
+            auto removeIt = std::remove_if(c.ids_.begin(), c.ids_.end(), [&c, &known](int32_t id) {
+                auto knownIt = known.find(id);
+                if (knownIt == known.end()) {
+                    return false;
+                }
+                c.treasuriesCnt_ -= std::min(c.treasuriesCnt_, knownIt->second);
+                return true;
+            });
+            c.ids_.erase(removeIt, c.ids_.end());
+        }
+
+        for (const auto &c : constraints) {
+            if (c.ids_.size() == 1 && known.find(c.ids_[0]) == known.end()) {
+                known[c.ids_[0]] = c.treasuriesCnt_;
+                changed = true;
+            } else if (c.treasuriesCnt_ == 0) {
+                // counts are non negative, so every area under a zero constraint is empty
+                for (auto id : c.ids_) {
+                    if (known.find(id) == known.end()) {
+                        known[id] = 0;
+                        changed = true;
+                    }
+                }
+            }
+        }
+        if (changed) {
+            continue;
+        }
+
+        auto size = constraints.size();
+        for (size_t i = 0; i < size && constraints.size() < kMaxReducedConstraintsCnt; i++) {
+            for (size_t j = 0; j < size && constraints.size() < kMaxReducedConstraintsCnt; j++) {
+                const auto &sub = constraints[i];
+                const auto &super = constraints[j];
+                if (i == j || sub.ids_.empty() || sub.ids_.size() >= super.ids_.size() ||
+                    sub.treasuriesCnt_ > super.treasuriesCnt_ ||
+                    !std::includes(super.ids_.begin(), super.ids_.end(), sub.ids_.begin(), sub.ids_.end())) {
+                    continue;
+                }
+                ReducedConstraint diff{{}, super.treasuriesCnt_ - sub.treasuriesCnt_};
+                std::set_difference(super.ids_.begin(), super.ids_.end(), sub.ids_.begin(), sub.ids_.end(),
+                                    std::back_inserter(diff.ids_));
+                auto exists = std::any_of(constraints.begin(), constraints.end(), [&diff](const ReducedConstraint &c) {
+                    return c.ids_ == diff.ids_;
+                });
+                if (!exists) {
+                    constraints.push_back(std::move(diff));
+                    changed = true;
+                }
+            }
+        }
+    }
+}
+
+void ExploreInference::derive(const ExploreAreaPtr &parent, std::vector<InferredArea> &out) {
+    if (constraints_.find(parent->id_) == constraints_.end()) {
+        if (parent->getNonExploredChildrenCnt() == 1) {
+            out.emplace_back(parent->getLastNonExploredChild(), parent->getLeftTreasuriesCnt());
+        } else if (parent->getLeftTreasuriesCnt() == 0) {
+            for (const auto &child : parent->children_) {
+                if (!child->explored_) {
+                    out.emplace_back(child, 0);
+                }
+            }
+        }
+        return;
+    }
+    if (parent->getNonExploredChildrenCnt() == 0) {
+        forget(parent);
+        return;
+    }
+
+    auto constraints = reduce(*parent);
+    std::unordered_map<int32_t, size_t> known;
+    solve(constraints, known);
+    if (known.empty()) {
+        return;
+    }
+    for (const auto &child : parent->children_) {
+        if (child->explored_) {
+            continue;
+        }
+        auto it = known.find(child->id_);
+        if (it != known.end()) {
+            out.emplace_back(child, it->second);
+        }
+    }
+}
+
+std::optional<size_t>
+ExploreInference::query(const ExploreAreaPtr &parent, const std::vector<ExploreAreaPtr> &areas) const noexcept {
+    size_t sum{0};
+    std::vector<int32_t> unknownIds;
+    for (const auto &area : areas) {
+        if (area->explored_) {
+            sum += area->actualTreasuriesCnt_;
+        } else {
+            unknownIds.push_back(area->id_);
+        }
+    }
+    if (unknownIds.empty()) {
+        return sum;
+    }
+    std::sort(unknownIds.begin(), unknownIds.end());
+
+    auto constraints = reduce(*parent);
+    std::unordered_map<int32_t, size_t> known;
+    solve(constraints, known);
+
+    auto removeIt = std::remove_if(unknownIds.begin(), unknownIds.end(), [&sum, &known](int32_t id) {
+        auto it = known.find(id);
+        if (it == known.end()) {
+            return false;
+        }
+        sum += it->second;
+        return true;
+    });
+    unknownIds.erase(removeIt, unknownIds.end());
+    if (unknownIds.empty()) {
+        return sum;
+    }
+    for (const auto &c : constraints) {
+        if (c.ids_ == unknownIds) {
+            return sum + c.treasuriesCnt_;
+        }
+    }
+    return std::nullopt;
+}
@@ -0,0 +1,67 @@
+#ifndef HIGHLOADCUP2021_EXPLORE_INFERENCE_H
+#define HIGHLOADCUP2021_EXPLORE_INFERENCE_H
+
+#include <cstdint>
+#include <optional>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+#include "api_entities.h"
+
+// Known treasures count over a set of sibling areas.
+struct ExploreConstraint {
+    std::vector<ExploreAreaPtr> areas_;
+    size_t treasuriesCnt_;
+
+    ExploreConstraint(std::vector<ExploreAreaPtr> areas, size_t treasuriesCnt) :
+            areas_{std::move(areas)},
+            treasuriesCnt_{treasuriesCnt} {}
+};
+
+using InferredArea = std::pair<ExploreAreaPtr, size_t>;
+
+// Keeps known counts over unions of sibling areas as linear constraints next to the implicit
+// "children sum up to the parent" one and derives counts of children that become determined:
+// a constraint with a single unknown area, a constraint whose remaining sum is zero and the
+// difference of two constraints where one covers a subset of the other.
+// Ordinary explore results take part through the implicit constraint: once the explored children
+// hold all treasures of the parent, the rest of them is empty without a request.
+// Constraints are kept per parent only. An area is split once its count is known, so a level never
+// learns anything from the levels below it, and an empty area is never split at all.
+class ExploreInference {
+    // constraint over unknown areas identified by ExploreArea::id_, kept sorted
+    struct ReducedConstraint {
+        std::vector<int32_t> ids_;
+        size_t treasuriesCnt_;
+    };
+
+    std::unordered_map<int32_t, std::vector<ExploreConstraint>> constraints_;
+
+    [[nodiscard]] std::vector<ReducedConstraint> reduce(const ExploreArea &parent) const;
+
+    static void solve(std::vector<ReducedConstraint> &constraints, std::unordered_map<int32_t, size_t> &known);
+
+public:
+    void addConstraint(const ExploreAreaPtr &parent, std::vector<ExploreAreaPtr> areas, size_t treasuriesCnt);
+
+    // Appends children of parent with a determined count that are not explored yet.
+    void derive(const ExploreAreaPtr &parent, std::vector<InferredArea> &out);
+
+    // Returns the sum over areas if the known constraints determine it.
+    [[nodiscard]] std::optional<size_t>
+    query(const ExploreAreaPtr &parent, const std::vector<ExploreAreaPtr> &areas) const noexcept;
+
+    void forget(const ExploreAreaPtr &parent) noexcept {
+        constraints_.erase(parent->id_);
+    }
+
+    [[nodiscard]] size_t getConstraintsCnt() const noexcept {
+        size_t cnt{0};
+        for (const auto &[id, v]: constraints_) {
+            cnt += v.size();
+        }
+        return cnt;
+    }
+};
+
+#endif //HIGHLOADCUP2021_EXPLORE_INFERENCE_H
@@ -0,0 +1,280 @@
+#include "explore_planner.h"
+#include "config.h"
+#include "stats.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <limits>
+
+constexpr size_t kTreasuriesLinearBuckets = 16;
+constexpr double kTreasuriesBucketRatio = 1.25;
+
+std::ostream &operator<<(std::ostream &os, const ExploreSplitMode &mode) {
+    switch (mode) {
+        case ExploreSplitMode::Static:
+            os << "static";
+            break;
+        case ExploreSplitMode::Adaptive:
+            os << "adaptive";
+            break;
+    }
+    return os;
+}
+
+std::ostream &operator<<(std::ostream &os, const ExplorePartitionScheme &scheme) {
+    switch (scheme) {
+        case ExplorePartitionScheme::Strips:
+            os << "strips";
+            break;
+        case ExplorePartitionScheme::Grid:
+            os << "grid";
+            break;
+        case ExplorePartitionScheme::Quadtree:
+            os << "quadtree";
+            break;
+    }
+    return os;
+}
+
+ExploreSplitMode exploreSplitModeFromEnv() noexcept {
+    auto modeEnv = std::getenv("EXPLORE_SPLIT_MODE");
+    if (modeEnv == nullptr) {
+        return kExploreSplitMode;
+    }
+    if (std::strcmp(modeEnv, "adaptive") == 0) {
+        return ExploreSplitMode::Adaptive;
+    }
+    if (std::strcmp(modeEnv, "static") == 0) {
+        return ExploreSplitMode::Static;
+    }
+    return kExploreSplitMode;
+}
+
+ExplorePartitionScheme explorePartitionSchemeFromEnv() noexcept {
+    auto schemeEnv = std::getenv("EXPLORE_PARTITION");
+    if (schemeEnv == nullptr) {
+        return kExplorePartitionScheme;
+    }
+    if (std::strcmp(schemeEnv, "strips") == 0) {
+        return ExplorePartitionScheme::Strips;
+    }
+    if (std::strcmp(schemeEnv, "grid") == 0) {
+        return ExplorePartitionScheme::Grid;
+    }
+    if (std::strcmp(schemeEnv, "quadtree") == 0) {
+        return ExplorePartitionScheme::Quadtree;
+    }
+    return kExplorePartitionScheme;
+}
+
+bool siblingUnionFromEnv() noexcept {
+    auto modeEnv = std::getenv("SIBLING_UNION");
+    if (modeEnv == nullptr) {
+        return kExploreSiblingUnion;
+    }
+    if (std::strcmp(modeEnv, "on") == 0) {
+        return true;
+    }
+    if (std::strcmp(modeEnv, "off") == 0) {
+        return false;
+    }
+    return kExploreSiblingUnion;
+}
+
+ExplorePlanner::ExplorePlanner(ExploreSplitMode mode, ExplorePartitionScheme scheme) : mode_{mode}, scheme_{scheme} {
+    rebuild();
+}
+
+size_t ExplorePlanner::areaBucket(size_t area) noexcept {
+    size_t bucket = 0;
+    while (area > 1 && bucket + 1 < kAreaBuckets) {
+        area >>= 1;
+        bucket++;
+    }
+    return bucket;
+}
+
+size_t ExplorePlanner::treasuriesBucket(double treasuriesCnt) noexcept {
+    if (treasuriesCnt <= 0.0) {
+        return 0;
+    }
+    if (treasuriesCnt <= (double) kTreasuriesLinearBuckets) {
+        return (size_t) std::lround(treasuriesCnt);
+    }
+    auto bucket = kTreasuriesLinearBuckets + (size_t) std::lround(
+            std::log(treasuriesCnt / (double) kTreasuriesLinearBuckets) / std::log(kTreasuriesBucketRatio));
+    return std::min(bucket, kTreasuriesBuckets - 1);
+}
+
+double ExplorePlanner::treasuriesBucketValue(size_t bucket) noexcept {
+    if (bucket <= kTreasuriesLinearBuckets) {
+        return (double) bucket;
+    }
+    return (double) kTreasuriesLinearBuckets *
+           std::pow(kTreasuriesBucketRatio, (double) (bucket - kTreasuriesLinearBuckets));
+}
+
+double ExplorePlanner::splitCost(size_t areaBucket, size_t fanoutLog, double treasuriesCnt) const noexcept {
+    auto fanout = (double) ((size_t) 1 << fanoutLog);
+    auto childBucket = areaBucket - fanoutLog;
+    // probability that a child holds at least one treasure and the expected count if it does
+    auto nonEmptyProb = 1.0 - std::pow(1.0 - 1.0 / fanout, treasuriesCnt);
+    if (nonEmptyProb <= 0.0) {
+        return (fanout - 1.0) * requestWeight_[childBucket];
+    }
+    auto childTreasuriesCnt = treasuriesCnt / (fanout * nonEmptyProb);
+    // the last non explored child is inferred from the parent, so only fanout - 1 requests are made
+    return (fanout - 1.0) * requestWeight_[childBucket] +
+           fanout * nonEmptyProb * expectedCost_[childBucket][treasuriesBucket(childTreasuriesCnt)];
+}
+
+void ExplorePlanner::rebuild() noexcept {
+    int64_t measuredLatency{0};
+    int64_t measuredCost{0};
+    for (size_t i = 0; i < kAreaBuckets; i++) {
+        if (latencyCnt_[i] >= kExplorePlannerMinLatencySamples) {
+            measuredLatency += latencySum_[i];
+            measuredCost += Stats::calculateExploreCost((int64_t) 1 << i) * latencyCnt_[i];
+        }
+    }
+    double latencyPerCost = 1.0;
+    if (measuredCost > 0) {
+        latencyPerCost = (double) measuredLatency / (double) measuredCost;
+    }
+
+    for (size_t i = 0; i < kAreaBuckets; i++) {
+        if (latencyCnt_[i] >= kExplorePlannerMinLatencySamples) {
+            requestWeight_[i] = (double) latencySum_[i] / (double) latencyCnt_[i];
+        } else {
+            requestWeight_[i] = (double) Stats::calculateExploreCost((int64_t) 1 << i) * latencyPerCost;
+        }
+    }
+
+    for (size_t i = 0; i < kAreaBuckets; i++) {
+        for (size_t b = 0; b < kTreasuriesBuckets; b++) {
+            if (i == 0 || b == 0) {
+                expectedCost_[i][b] = 0.0;
+                continue;
+            }
+            auto best = std::numeric_limits<double>::max();
+            auto treasuriesCnt = treasuriesBucketValue(b);
+            for (size_t j = 1; j <= std::min(i, kExplorePlannerMaxFanoutLog); j++) {
+                best = std::min(best, splitCost(i, j, treasuriesCnt));
+            }
+            expectedCost_[i][b] = best;
+        }
+    }
+}
+
+ExploreAreaShift ExplorePlanner::plan(const ExploreArea &parent) const noexcept {
+    const auto &area = parent.area_;
+    auto staticShift = runtimeConfig().get().getExploreAreaShift(parent.exploreDepth_);
+    if (area.getArea() <= 1) {
+        return staticShift;
+    }
+    if (scheme_ == ExplorePartitionScheme::Quadtree) {
+        return {(int16_t) ((area.sizeX_ + 1) / 2), (int16_t) ((area.sizeY_ + 1) / 2)};
+    }
+
+    size_t fanout;
+    if (mode_ == ExploreSplitMode::Static) {
+        if (scheme_ == ExplorePartitionScheme::Strips) {
+            return staticShift;
+        }
+        fanout = area.getArea() / ((size_t) staticShift.height * (size_t) staticShift.width);
+    } else {
+        fanout = (size_t) 1 << chooseFanoutLog(parent);
+    }
+    fanout = std::max(fanout, (size_t) 2);
+
+    if (scheme_ == ExplorePartitionScheme::Grid) {
+        return tileShift(area, fanout);
+    }
+    return stripShift(area, fanout);
+}
+
+size_t ExplorePlanner::chooseFanoutLog(const ExploreArea &parent) const noexcept {
+    const auto &area = parent.area_;
+    auto bucket = areaBucket(area.getArea());
+    auto maxFanoutLog = std::min(bucket, kExplorePlannerMaxFanoutLog);
+    if (scheme_ == ExplorePartitionScheme::Strips) {
+        maxFanoutLog = std::min(maxFanoutLog, areaBucket((size_t) std::max(area.sizeX_, area.sizeY_)));
+    }
+    auto treasuriesCnt = (double) parent.getLeftTreasuriesCnt();
+
+    size_t bestFanoutLog{1};
+    auto bestCost = std::numeric_limits<double>::max();
+    for (size_t j = 1; j <= maxFanoutLog; j++) {
+        auto cost = splitCost(bucket, j, treasuriesCnt);
+        if (cost < bestCost) {
+            bestCost = cost;
+            bestFanoutLog = j;
+        }
+    }
+    return bestFanoutLog;
+}
+
+ExploreAreaShift ExplorePlanner::stripShift(const Area &area, size_t fanout) noexcept {
+    auto longestSide = (size_t) std::max(area.sizeX_, area.sizeY_);
+    auto piece = (int16_t) ((longestSide + fanout - 1) / fanout);
+    if (area.sizeX_ >= area.sizeY_) {
+        return {piece, area.sizeY_};
+    }
+    return {area.sizeX_, piece};
+}
+
+ExploreAreaShift ExplorePlanner::tileShift(const Area &area, size_t fanout) noexcept {
+    auto tileArea = std::max((double) area.getArea() / (double) fanout, 1.0);
+    auto tileX = std::clamp((int16_t) std::ceil(std::sqrt(tileArea)), (int16_t) 1, area.sizeX_);
+    auto tileY = std::clamp((int16_t) std::ceil(tileArea / (double) tileX), (int16_t) 1, area.sizeY_);
+    if (tileX == area.sizeX_ && tileY == area.sizeY_) {
+        if (area.sizeX_ >= area.sizeY_) {
+            tileX = (int16_t) ((area.sizeX_ + 1) / 2);
+        } else {
+            tileY = (int16_t) ((area.sizeY_ + 1) / 2);
+        }
+    }
+    return {tileX, tileY};
+}
+
+void ExplorePlanner::recordExploreLatency(size_t area, int64_t latencyMcs) noexcept {
+    auto bucket = areaBucket(area);
+    latencySum_[bucket] += latencyMcs;
+    latencyCnt_[bucket]++;
+    samplesSinceRebuild_++;
+    if (mode_ == ExploreSplitMode::Adaptive && samplesSinceRebuild_ >= kExplorePlannerRebuildPeriod) {
+        rebuild();
+        samplesSinceRebuild_ = 0;
+    }
+}
+
+double ExplorePlanner::getExpectedCost(size_t area, double treasuriesCnt) const noexcept {
+    return expectedCost_[areaBucket(area)][treasuriesBucket(treasuriesCnt)];
+}
+
+size_t ExplorePlanner::planSiblingUnion(const std::vector<ExploreAreaPtr> &siblings,
+                                        double expectedTreasuriesPerCell) const noexcept {
+    size_t bestMembersCnt{1};
+    double bestSaving{0.0};
+    size_t unionArea{0};
+    double separateCost{0.0};
+    for (size_t m = 1; m <= siblings.size(); m++) {
+        auto memberArea = siblings[m - 1]->area_.getArea();
+        unionArea += memberArea;
+        separateCost += getRequestWeight(memberArea);
+        if (m == 1) {
+            continue;
+        }
+        // if the union is not empty its members are explored one by one and the last one is inferred
+        auto emptyProb = std::exp(-expectedTreasuriesPerCell * (double) unionArea);
+        auto unionCost = getRequestWeight(unionArea) +
+                         (1.0 - emptyProb) * separateCost * (double) (m - 1) / (double) m;
+        auto saving = separateCost - unionCost;
+        if (saving > bestSaving) {
+            bestSaving = saving;
+            bestMembersCnt = m;
+        }
+    }
+    return bestMembersCnt;
+}
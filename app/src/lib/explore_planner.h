@@ -0,0 +1,87 @@
+#ifndef HIGHLOADCUP2021_EXPLORE_PLANNER_H
+#define HIGHLOADCUP2021_EXPLORE_PLANNER_H
+
+#include <array>
+#include <cstdint>
+#include <ostream>
+#include "api_entities.h"
+#include "const.h"
+
+std::ostream &operator<<(std::ostream &os, const ExploreSplitMode &mode);
+
+std::ostream &operator<<(std::ostream &os, const ExplorePartitionScheme &scheme);
+
+// Reads EXPLORE_SPLIT_MODE (static|adaptive) and falls back to kExploreSplitMode.
+ExploreSplitMode exploreSplitModeFromEnv() noexcept;
+
+// Reads EXPLORE_PARTITION (strips|grid|quadtree) and falls back to kExplorePartitionScheme.
+ExplorePartitionScheme explorePartitionSchemeFromEnv() noexcept;
+
+// Reads SIBLING_UNION (on|off) and falls back to kExploreSiblingUnion.
+bool siblingUnionFromEnv() noexcept;
+
+// Chooses the shape of sub areas for an explored area.
+// Static mode replays EXPLORE_AREAS of the runtime config. Adaptive mode keeps a table of expected explore cost
+// to resolve an area of 2^i cells holding t treasures and picks the fanout that minimizes it.
+// The per request weight is the measured explore latency per area bucket, the
+// Stats::calculateExploreCost curve is used for buckets without enough samples.
+// The partition scheme turns the chosen fanout into a tile shape: strips cut the longest side,
+// grid cuts both sides into near square tiles and quadtree always halves both sides.
+class ExplorePlanner {
+public:
+    static constexpr size_t kAreaBuckets = 25;
+    static constexpr size_t kTreasuriesBuckets = 64;
+
+private:
+    ExploreSplitMode mode_;
+    ExplorePartitionScheme scheme_;
+    std::array<int64_t, kAreaBuckets> latencySum_{};
+    std::array<int64_t, kAreaBuckets> latencyCnt_{};
+    std::array<double, kAreaBuckets> requestWeight_{};
+    std::array<std::array<double, kTreasuriesBuckets>, kAreaBuckets> expectedCost_{};
+    int64_t samplesSinceRebuild_{0};
+
+    void rebuild() noexcept;
+
+    [[nodiscard]] double splitCost(size_t areaBucket, size_t fanoutLog, double treasuriesCnt) const noexcept;
+
+    [[nodiscard]] size_t chooseFanoutLog(const ExploreArea &parent) const noexcept;
+
+    [[nodiscard]] static ExploreAreaShift stripShift(const Area &area, size_t fanout) noexcept;
+
+    [[nodiscard]] static ExploreAreaShift tileShift(const Area &area, size_t fanout) noexcept;
+
+public:
+    ExplorePlanner(ExploreSplitMode mode, ExplorePartitionScheme scheme);
+
+    [[nodiscard]] ExploreSplitMode getMode() const noexcept {
+        return mode_;
+    }
+
+    [[nodiscard]] ExplorePartitionScheme getScheme() const noexcept {
+        return scheme_;
+    }
+
+    [[nodiscard]] ExploreAreaShift plan(const ExploreArea &parent) const noexcept;
+
+    void recordExploreLatency(size_t area, int64_t latencyMcs) noexcept;
+
+    [[nodiscard]] double getExpectedCost(size_t area, double treasuriesCnt) const noexcept;
+
+    [[nodiscard]] double getRequestWeight(size_t area) const noexcept {
+        return requestWeight_[areaBucket(area)];
+    }
+
+    // Returns how many leading areas (adjacent siblings, the first one already chosen for a request)
+    // should be explored as one rectangle, 1 means exploring the first area alone is cheaper.
+    [[nodiscard]] size_t
+    planSiblingUnion(const std::vector<ExploreAreaPtr> &siblings, double expectedTreasuriesPerCell) const noexcept;
+
+    static size_t areaBucket(size_t area) noexcept;
+
+    static size_t treasuriesBucket(double treasuriesCnt) noexcept;
+
+    static double treasuriesBucketValue(size_t bucket) noexcept;
+};
+
+#endif //HIGHLOADCUP2021_EXPLORE_PLANNER_H
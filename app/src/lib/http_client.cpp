@@ -1,4 +1,5 @@
 #include "http_client.h"
+#include "config.h"
 #include "log.h"
 #include <stdexcept>
 #include <curl/curl.h>
@@ -34,8 +35,10 @@ HttpClient::HttpClient(std::shared_ptr<Stats> stats, const std::string &address,
 ) :
         stats_{std::move(stats)},
         errbuf_{0,},
-        valueBuffer_{0,},
-        parseBuffer_{0,},
+        valueBufferMem_{makeArenaUnique<JsonValueBuffer, MemoryArenaId::HttpBuffers>()},
+        parseBufferMem_{makeArenaUnique<JsonParseBuffer, MemoryArenaId::HttpBuffers>()},
+        valueBuffer_{valueBufferMem_->data()},
+        parseBuffer_{parseBufferMem_->data()},
         baseURL_{schema + "://" + address + ":" + port},
         checkHealthURL_{baseURL_ + "/health-check"},
         exploreURL_{baseURL_ + "/explore"},
@@ -69,10 +72,6 @@ HttpClient::HttpClient(std::shared_ptr<Stats> stats, const std::string &address,
         throw std::runtime_error("failed to set CURLOPT_HTTPHEADER");
     }
 
-    if (curl_easy_setopt(session_, CURLOPT_TIMEOUT_MS, kRequestTimeout) != CURLE_OK) {
-        throw std::runtime_error("failed to set CURLOPT_TIMEOUT_MS");
-    }
-
 //    curl_easy_setopt(session_, CURLOPT_VERBOSE, 1L);
 }
 
@@ -132,8 +131,8 @@ Expected<HttpResponse<Wallet>> HttpClient::cash(const TreasureID &treasureId) no
     });
 }
 
-Expected<HttpResponse<std::vector<TreasureID>>> HttpClient::dig(DigRequest request) noexcept {
-    marshalDig(request.licenseId_, request.posX_, request.posY_, request.depth_, postDataBuffer_);
+Expected<HttpResponse<Treasuries>> HttpClient::dig(DigRequest request) noexcept {
+    marshalDig(request, postDataBuffer_);
     Measure<std::chrono::microseconds> tm;
     auto ret = makeRequest(digURL_, postDataBuffer_.c_str());
     if (ret.hasError()) {
@@ -142,13 +141,13 @@ Expected<HttpResponse<std::vector<TreasureID>>> HttpClient::dig(DigRequest reque
     auto latency = tm.getDuration();
 
     stats_->recordEndpointStats("dig", ret.get(), latency.count());
-    return prepareResponse<std::vector<TreasureID>>(ret, resp_.data, latency, valueBuffer_, parseBuffer_,
-                                                    [this](std::string &data) {
-                                                        std::vector<TreasureID> buf;
-                                                        unmarshalTreasuriesList(data, this->valueBuffer_,
-                                                                                this->parseBuffer_, buf);
-                                                        return buf;
-                                                    });
+    return prepareResponse<Treasuries>(ret, resp_.data, latency, valueBuffer_, parseBuffer_,
+                                      [this](std::string &data) {
+                                          Treasuries buf;
+                                          unmarshalTreasuriesList(data, this->valueBuffer_,
+                                                                  this->parseBuffer_, buf);
+                                          return buf;
+                                      });
 }
 
 Expected<HttpResponse<License>> HttpClient::issueFreeLicense() noexcept {
@@ -166,8 +165,8 @@ Expected<HttpResponse<License>> HttpClient::issueFreeLicense() noexcept {
     });
 }
 
-Expected<HttpResponse<License>> HttpClient::issueLicense(CoinID coinId) noexcept {
-    marshalIssueLicenseRequest(coinId, postDataBuffer_);
+Expected<HttpResponse<License>> HttpClient::issueLicense(const Wallet &coins) noexcept {
+    marshalIssueLicenseRequest(coins, postDataBuffer_);
     Measure<std::chrono::microseconds> tm;
     auto ret = makeRequest(issueLicenseURL_, postDataBuffer_.c_str());
     if (ret.hasError()) {
@@ -189,6 +188,16 @@ HttpClient::makeRequest(const std::string &url, const char *data) noexcept {
     }
     this->resp_.data.clear();
 
+    // REQUEST_TIMEOUT_MS takes effect with the next request after a reload
+    const auto &config = runtimeConfig().get();
+    if (config.version_ != configVersion_) {
+        if (curl_easy_setopt(session_, CURLOPT_TIMEOUT_MS, config.requestTimeoutMs_) != CURLE_OK) {
+            stats_->incCurlErrCnt();
+            return ErrorCode::kErrCurl;
+        }
+        configVersion_ = config.version_;
+    }
+
     if (data != nullptr) {
         if (curl_easy_setopt(session_, CURLOPT_POSTFIELDS, data) != CURLE_OK) {
             stats_->incCurlErrCnt();
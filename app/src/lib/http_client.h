@@ -1,6 +1,7 @@
 #ifndef HIGHLOADCUP2021_HTTP_CLIENT_H
 #define HIGHLOADCUP2021_HTTP_CLIENT_H
 
+#include <array>
 #include <string>
 #include <curl/curl.h>
 #include "api_entities.h"
@@ -9,6 +10,7 @@
 #include "const.h"
 #include <chrono>
 #include "stats.h"
+#include "memory.h"
 
 template<class T>
 class HttpResponse {
@@ -39,6 +41,15 @@ public:
         return std::move(std::get<T>(resp_));
     }
 
+    // The handlers read the payload in place, hasError() or the http code is checked first.
+    [[nodiscard]] const ApiError &getErrResponse() const &noexcept {
+        return *std::get_if<ApiError>(&resp_);
+    }
+
+    [[nodiscard]] T &getResponse() &noexcept {
+        return *std::get_if<T>(&resp_);
+    }
+
     [[nodiscard]] int32_t getHttpCode() const noexcept {
         return httpCode_;
     }
@@ -49,6 +60,9 @@ public:
 
 };
 
+using JsonValueBuffer = std::array<JsonBufferType, kJsonValueBufferCap>;
+using JsonParseBuffer = std::array<JsonBufferType, kJsonParseBufferCap>;
+
 struct respHolder {
     std::string data;
 };
@@ -59,8 +73,11 @@ class HttpClient {
     CURL *session_;
 
     char errbuf_[CURL_ERROR_SIZE];
-    JsonBufferType valueBuffer_[kJsonValueBufferCap];
-    JsonBufferType parseBuffer_[kJsonParseBufferCap];
+    // the json buffers of all clients are kept together in the http buffers arena, not on the worker stacks
+    ArenaUniquePtr<JsonValueBuffer, MemoryArenaId::HttpBuffers> valueBufferMem_;
+    ArenaUniquePtr<JsonParseBuffer, MemoryArenaId::HttpBuffers> parseBufferMem_;
+    JsonBufferType *valueBuffer_;
+    JsonBufferType *parseBuffer_;
     respHolder resp_;
     std::string postDataBuffer_;
 
@@ -71,6 +88,8 @@ class HttpClient {
     const std::string digURL_;
     const std::string issueLicenseURL_;
     curl_slist *headers_;
+    // version of the runtime config whose request timeout is set to the session
+    uint64_t configVersion_{UINT64_MAX};
 
     [[nodiscard]]Expected<int32_t> makeRequest(const std::string &url, const char *data) noexcept;
 
@@ -94,9 +113,9 @@ public:
 
     [[nodiscard]] Expected<HttpResponse<Wallet>> cash(const TreasureID &treasureId) noexcept;
 
-    [[nodiscard]] Expected<HttpResponse<std::vector<TreasureID>>> dig(DigRequest request) noexcept;
+    [[nodiscard]] Expected<HttpResponse<Treasuries>> dig(DigRequest request) noexcept;
 
-    [[nodiscard]] Expected<HttpResponse<License>> issueLicense(CoinID coinId) noexcept;
+    [[nodiscard]] Expected<HttpResponse<License>> issueLicense(const Wallet &coins) noexcept;
 
     [[nodiscard]] Expected<HttpResponse<License>> issueFreeLicense() noexcept;
 };
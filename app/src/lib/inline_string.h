@@ -0,0 +1,76 @@
+#ifndef HIGHLOADCUP2021_INLINE_STRING_H
+#define HIGHLOADCUP2021_INLINE_STRING_H
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <ostream>
+#include <string_view>
+
+// String of at most N chars stored inline, it is trivially copyable and never touches the heap.
+template<size_t N>
+class InlineString {
+    static_assert(N < 256, "the size is kept in one byte");
+
+    std::array<char, N> data_{};
+    uint8_t size_{0};
+
+public:
+    InlineString() noexcept = default;
+
+    // Longer strings are truncated, decoders use assign to reject them instead.
+    InlineString(std::string_view s) noexcept: size_{(uint8_t) std::min(s.size(), N)} { // NOLINT(google-explicit-constructor)
+        std::memcpy(data_.data(), s.data(), size_);
+    }
+
+    InlineString(const char *s) noexcept: InlineString(std::string_view(s)) {} // NOLINT(google-explicit-constructor)
+
+    [[nodiscard]] bool assign(std::string_view s) noexcept {
+        if (s.size() > N) {
+            return false;
+        }
+        std::memcpy(data_.data(), s.data(), s.size());
+        size_ = (uint8_t) s.size();
+        return true;
+    }
+
+    [[nodiscard]] const char *data() const noexcept {
+        return data_.data();
+    }
+
+    [[nodiscard]] size_t size() const noexcept {
+        return size_;
+    }
+
+    [[nodiscard]] bool empty() const noexcept {
+        return size_ == 0;
+    }
+
+    [[nodiscard]] std::string_view view() const noexcept {
+        return {data_.data(), size_};
+    }
+
+    // strings and literals convert implicitly, so this is the only comparison
+    friend bool operator==(const InlineString &l, const InlineString &r) noexcept {
+        return l.view() == r.view();
+    }
+
+    friend std::ostream &operator<<(std::ostream &os, const InlineString &s) {
+        return os << s.view();
+    }
+};
+
+namespace std {
+
+template<size_t N>
+struct hash<InlineString<N>> {
+    size_t operator()(const InlineString<N> &s) const noexcept {
+        return hash<string_view>{}(s.view());
+    }
+};
+
+}
+
+#endif //HIGHLOADCUP2021_INLINE_STRING_H
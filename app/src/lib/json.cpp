@@ -1,4 +1,5 @@
 #include "json.h"
+#include "json_schema.h"
 #include "log.h"
 #include <rapidjson/document.h>
 #include "util.h"
@@ -25,12 +26,20 @@ Area unmarshalArea(
 }
 
 License unmarshalLicense(std::string &data, JsonBufferType *valueBuffer, JsonBufferType *parseBuffer) noexcept {
+    License license;
+    if (decodeJson(data, license)) {
+        return license;
+    }
     auto d = parse(data, valueBuffer, parseBuffer);
 
     return License(d["id"].GetInt(), (uint32_t) d["digAllowed"].GetInt(), (uint32_t) d["digUsed"].GetInt());
 }
 
 ApiError unmarshalApiError(std::string &data, JsonBufferType *valueBuffer, JsonBufferType *parseBuffer) noexcept {
+    ApiError apiError(ApiErrorCodeUnknown, "");
+    if (decodeJson(data, apiError)) {
+        return apiError;
+    }
     auto d = parse(data, valueBuffer, parseBuffer);
     if (d.IsObject() && d.HasMember("code") && d.HasMember("message")) {
         return ApiError(d["code"].GetInt(), d["message"].GetString());
@@ -41,6 +50,10 @@ ApiError unmarshalApiError(std::string &data, JsonBufferType *valueBuffer, JsonB
 
 ExploreResponse
 unmarshalExploreResponse(std::string &data, JsonBufferType *valueBuffer, JsonBufferType *parseBuffer) noexcept {
+    ExploreResponse exploreResponse(Area(), 0);
+    if (decodeJson(data, exploreResponse)) {
+        return exploreResponse;
+    }
     auto d = parse(data, valueBuffer, parseBuffer);
     auto area = unmarshalArea(d["area"].GetObject());
     auto amount = d["amount"].GetInt();
@@ -49,6 +62,9 @@ unmarshalExploreResponse(std::string &data, JsonBufferType *valueBuffer, JsonBuf
 
 void
 unmarshallWallet(std::string &data, JsonBufferType *valueBuffer, JsonBufferType *parseBuffer, Wallet &buf) noexcept {
+    if (decodeJson(data, buf)) {
+        return;
+    }
     buf.coins.clear();
 
     auto d = parse(data, valueBuffer, parseBuffer);
@@ -58,70 +74,38 @@ unmarshallWallet(std::string &data, JsonBufferType *valueBuffer, JsonBufferType
 }
 
 void marshalFreeIssueLicenseRequest(std::string &buffer) noexcept {
-    buffer.clear();
-
-    buffer += "[";
-    buffer += "]";
+    encodeJson(Wallet{}, buffer);
 }
 
-void marshalIssueLicenseRequest(CoinID coinId, std::string &buffer) noexcept {
-    buffer.clear();
-
-    buffer += "[";
-    writeIntToString(coinId, buffer);
-    buffer += "]";
+void marshalIssueLicenseRequest(const Wallet &coins, std::string &buffer) noexcept {
+    encodeJson(coins, buffer);
 }
 
 void unmarshalTreasuriesList(std::string &data, JsonBufferType *valueBuffer, JsonBufferType *parseBuffer,
-                             std::vector<TreasureID> &buf) noexcept {
+                             Treasuries &buf) noexcept {
+    if (decodeJson(data, buf)) {
+        return;
+    }
     buf.clear();
 
     auto d = parse(data, valueBuffer, parseBuffer);
     for (auto &val: d.GetArray()) {
-        buf.emplace_back(val.GetString());
+        // ids that do not fit TreasureID could not be cashed anyway
+        TreasureID id;
+        if (id.assign(std::string_view(val.GetString(), val.GetStringLength()))) {
+            buf.push_back(id);
+        }
     }
 }
 
 void marshalTreasureId(const TreasureID &treasureId, std::string &buffer) noexcept {
-    buffer.clear();
-
-    buffer += '"';
-    buffer += treasureId;
-    buffer += '"';
+    encodeJson(treasureId, buffer);
 }
 
-void marshalDig(LicenseID licenseId, int16_t posX, int16_t posY, int8_t depth, std::string &buffer) noexcept {
-    buffer.clear();
-
-    buffer += "{";
-    buffer += "\"licenseID\":";
-    writeIntToString(licenseId, buffer);
-    buffer += ",";
-    buffer += "\"posX\":";
-    writeIntToString(posX, buffer);
-    buffer += ",";
-    buffer += "\"posY\":";
-    writeIntToString(posY, buffer);
-    buffer += ",";
-    buffer += "\"depth\":";
-    writeIntToString(depth, buffer);
-    buffer += "}";
+void marshalDig(const DigRequest &request, std::string &buffer) noexcept {
+    encodeJson(request, buffer);
 }
 
 void marshalArea(const Area &area, std::string &buffer) noexcept {
-    buffer.clear();
-
-    buffer += "{";
-    buffer += "\"posX\":";
-    writeIntToString(area.posX_, buffer);
-    buffer += ',';
-    buffer += "\"posY\":";
-    writeIntToString(area.posY_, buffer);
-    buffer += ',';
-    buffer += "\"sizeX\":";
-    writeIntToString(area.sizeX_, buffer);
-    buffer += ",";
-    buffer += "\"sizeY\":";
-    writeIntToString(area.sizeY_, buffer);
-    buffer += "}";
-}
\ No newline at end of file
+    encodeJson(area, buffer);
+}
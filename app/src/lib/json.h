@@ -15,14 +15,14 @@ void marshalArea(const Area &area, std::string &buffer) noexcept;
 void
 unmarshallWallet(std::string &data, JsonBufferType *valueBuffer, JsonBufferType *parseBuffer, Wallet &buf) noexcept;
 
-void marshalTreasureId(const std::string &treasureId, std::string &buffer) noexcept;
+void marshalTreasureId(const TreasureID &treasureId, std::string &buffer) noexcept;
 
-void marshalDig(LicenseID licenseId, int16_t posX, int16_t posY, int8_t depth, std::string &buffer) noexcept;
+void marshalDig(const DigRequest &request, std::string &buffer) noexcept;
 
 void unmarshalTreasuriesList(std::string &data, JsonBufferType *valueBuffer, JsonBufferType *parseBuffer,
-                             std::vector<TreasureID> &buf) noexcept;
+                             Treasuries &buf) noexcept;
 
-void marshalIssueLicenseRequest(CoinID coinId, std::string &buffer) noexcept;
+void marshalIssueLicenseRequest(const Wallet &coins, std::string &buffer) noexcept;
 
 void marshalFreeIssueLicenseRequest(std::string &buffer) noexcept;
 
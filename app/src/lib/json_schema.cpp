@@ -0,0 +1,44 @@
+#include "json_schema.h"
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+const char *skipJsonDigits(const char *p, const char *end) noexcept {
+#if defined(__SSE2__)
+    const auto zero = _mm_set1_epi8('0');
+    const auto nine = _mm_set1_epi8(9);
+    while (end - p >= 16) {
+        auto v = _mm_sub_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i *>(p)), zero);
+        auto digits = (unsigned) _mm_movemask_epi8(_mm_cmpeq_epi8(_mm_min_epu8(v, nine), v));
+        if (digits != 0xFFFFu) {
+            return p + __builtin_ctz(~digits);
+        }
+        p += 16;
+    }
+#endif
+    while (p < end && *p >= '0' && *p <= '9') {
+        p++;
+    }
+    return p;
+}
+
+const char *findJsonQuoteOrEscape(const char *p, const char *end) noexcept {
+#if defined(__SSE2__)
+    const auto quote = _mm_set1_epi8('"');
+    const auto escape = _mm_set1_epi8('\\');
+    while (end - p >= 16) {
+        auto v = _mm_loadu_si128(reinterpret_cast<const __m128i *>(p));
+        auto found = (unsigned) _mm_movemask_epi8(_mm_or_si128(_mm_cmpeq_epi8(v, quote),
+                                                               _mm_cmpeq_epi8(v, escape)));
+        if (found != 0) {
+            return p + __builtin_ctz(found);
+        }
+        p += 16;
+    }
+#endif
+    while (p < end && *p != '"' && *p != '\\') {
+        p++;
+    }
+    return p;
+}
@@ -0,0 +1,326 @@
+#ifndef HIGHLOADCUP2021_JSON_SCHEMA_H
+#define HIGHLOADCUP2021_JSON_SCHEMA_H
+
+#include <cstdint>
+#include <limits>
+#include <string>
+#include <string_view>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+#include "api_entities.h"
+#include "util.h"
+
+// Every API entity lists its JSON fields once in a JsonSchema specialization, encodeJson and decodeJson
+// are generated from it at compile time. Integers, strings, vectors and entities with a schema nest freely.
+// A schema with a single unnamed field is encoded as that field, e.g. a wallet is a plain array of coins.
+//
+// The decoder scans the body in place for delimiters and digits (16 bytes at a time with SSE2) without
+// building a DOM. Anything unexpected, e.g. an unknown or missing field, an escaped string or an out of
+// range number, makes it return false, so callers can fall back to a general purpose parser.
+
+template<class T, class M>
+struct JsonField {
+    std::string_view name_;
+    M T::*member_;
+};
+
+template<class T, class M>
+constexpr JsonField<T, M> jsonField(std::string_view name, M T::*member) noexcept {
+    return {name, member};
+}
+
+template<class T>
+struct JsonSchema;
+
+template<>
+struct JsonSchema<Area> {
+    static constexpr auto kFields = std::make_tuple(
+            jsonField("posX", &Area::posX_),
+            jsonField("posY", &Area::posY_),
+            jsonField("sizeX", &Area::sizeX_),
+            jsonField("sizeY", &Area::sizeY_));
+};
+
+template<>
+struct JsonSchema<ExploreResponse> {
+    static constexpr auto kFields = std::make_tuple(
+            jsonField("area", &ExploreResponse::area_),
+            jsonField("amount", &ExploreResponse::amount_));
+};
+
+template<>
+struct JsonSchema<License> {
+    static constexpr auto kFields = std::make_tuple(
+            jsonField("id", &License::id_),
+            jsonField("digAllowed", &License::digAllowed_),
+            jsonField("digUsed", &License::digUsed_));
+};
+
+template<>
+struct JsonSchema<DigRequest> {
+    static constexpr auto kFields = std::make_tuple(
+            jsonField("licenseID", &DigRequest::licenseId_),
+            jsonField("posX", &DigRequest::posX_),
+            jsonField("posY", &DigRequest::posY_),
+            jsonField("depth", &DigRequest::depth_));
+};
+
+template<>
+struct JsonSchema<Wallet> {
+    static constexpr auto kFields = std::make_tuple(jsonField("", &Wallet::coins));
+};
+
+template<>
+struct JsonSchema<ApiError> {
+    static constexpr auto kFields = std::make_tuple(
+            jsonField("code", &ApiError::errorCode_),
+            jsonField("message", &ApiError::message_));
+};
+
+// Returns the first byte at or after p that is not a decimal digit.
+const char *skipJsonDigits(const char *p, const char *end) noexcept;
+
+// Returns the first quote or backslash at or after p, end if there is none.
+const char *findJsonQuoteOrEscape(const char *p, const char *end) noexcept;
+
+class JsonScanner {
+    const char *p_;
+    const char *end_;
+
+    void skipSpaces() noexcept {
+        while (p_ < end_ && (*p_ == ' ' || *p_ == '\n' || *p_ == '\r' || *p_ == '\t')) {
+            p_++;
+        }
+    }
+
+public:
+    explicit JsonScanner(std::string_view data) noexcept: p_{data.data()}, end_{data.data() + data.size()} {}
+
+    bool consume(char c) noexcept {
+        skipSpaces();
+        if (p_ < end_ && *p_ == c) {
+            p_++;
+            return true;
+        }
+        return false;
+    }
+
+    bool atEnd() noexcept {
+        skipSpaces();
+        return p_ == end_;
+    }
+
+    // Reads a string without escapes.
+    bool readString(std::string_view &s) noexcept {
+        if (!consume('"')) {
+            return false;
+        }
+        auto close = findJsonQuoteOrEscape(p_, end_);
+        if (close == end_ || *close != '"') {
+            return false;
+        }
+        s = std::string_view(p_, (size_t) (close - p_));
+        p_ = close + 1;
+        return true;
+    }
+
+    bool readKey(std::string_view &key) noexcept {
+        return readString(key) && consume(':');
+    }
+
+    template<class T>
+    bool readInt(T &val) noexcept {
+        skipSpaces();
+        auto negative = p_ < end_ && *p_ == '-';
+        auto begin = negative ? p_ + 1 : p_;
+        auto digitsEnd = skipJsonDigits(begin, end_);
+        // 18 digits always fit int64_t
+        if (digitsEnd == begin || digitsEnd - begin > 18) {
+            return false;
+        }
+        int64_t v{0};
+        for (auto d = begin; d < digitsEnd; d++) {
+            v = v * 10 + (*d - '0');
+        }
+        if (negative) {
+            v = -v;
+        }
+        if (v < (int64_t) std::numeric_limits<T>::min() || v > (int64_t) std::numeric_limits<T>::max()) {
+            return false;
+        }
+        val = (T) v;
+        p_ = digitsEnd;
+        return true;
+    }
+
+    // Calls onField for every key of an object, onField reads the value and returns false to reject it.
+    template<class F>
+    bool readObject(F onField) noexcept {
+        if (!consume('{')) {
+            return false;
+        }
+        if (consume('}')) {
+            return true;
+        }
+        do {
+            std::string_view key;
+            if (!readKey(key) || !onField(key)) {
+                return false;
+            }
+        } while (consume(','));
+        return consume('}');
+    }
+
+    template<class F>
+    bool readArray(F onItem) noexcept {
+        if (!consume('[')) {
+            return false;
+        }
+        if (consume(']')) {
+            return true;
+        }
+        do {
+            if (!onItem()) {
+                return false;
+            }
+        } while (consume(','));
+        return consume(']');
+    }
+};
+
+template<class T>
+struct IsJsonArray : std::false_type {
+};
+
+template<class T, class A>
+struct IsJsonArray<std::vector<T, A>> : std::true_type {
+};
+
+template<class T, size_t N>
+struct IsJsonArray<SmallVector<T, N>> : std::true_type {
+};
+
+template<class T>
+struct IsJsonInlineString : std::false_type {
+};
+
+template<size_t N>
+struct IsJsonInlineString<InlineString<N>> : std::true_type {
+};
+
+template<class T>
+constexpr bool isJsonTransparent() noexcept {
+    constexpr auto &fields = JsonSchema<T>::kFields;
+    if constexpr (std::tuple_size_v<std::decay_t<decltype(fields)>> == 1) {
+        return std::get<0>(fields).name_.empty();
+    }
+    return false;
+}
+
+template<class T>
+void encodeJsonValue(const T &val, std::string &buffer) noexcept;
+
+template<class T>
+bool decodeJsonValue(JsonScanner &s, T &val) noexcept;
+
+template<class T, size_t... I>
+void encodeJsonFields(const T &val, std::string &buffer, std::index_sequence<I...>) noexcept {
+    constexpr auto &fields = JsonSchema<T>::kFields;
+    buffer += '{';
+    ((buffer += I == 0 ? "\"" : ",\"",
+            buffer.append(std::get<I>(fields).name_.data(), std::get<I>(fields).name_.size()),
+            buffer += "\":",
+            encodeJsonValue(val.*std::get<I>(fields).member_, buffer)), ...);
+    buffer += '}';
+}
+
+// Keys are compared by their static length first, so a mismatch mostly costs one integer compare.
+template<class T, size_t... I>
+bool decodeJsonField(JsonScanner &s, T &val, std::string_view key, uint32_t &found,
+                     std::index_sequence<I...>) noexcept {
+    constexpr auto &fields = JsonSchema<T>::kFields;
+    auto decoded = false;
+    auto matched = ((key.size() == std::get<I>(fields).name_.size() && key == std::get<I>(fields).name_ &&
+                     (found |= 1u << I, decoded = decodeJsonValue(s, val.*std::get<I>(fields).member_), true)) || ...);
+    return matched && decoded;
+}
+
+template<class T>
+void encodeJsonValue(const T &val, std::string &buffer) noexcept {
+    if constexpr (std::is_integral_v<T>) {
+        writeIntToString((int64_t) val, buffer);
+    } else if constexpr (std::is_same_v<T, std::string>) {
+        buffer += '"';
+        buffer += val;
+        buffer += '"';
+    } else if constexpr (IsJsonInlineString<T>::value) {
+        buffer += '"';
+        buffer.append(val.data(), val.size());
+        buffer += '"';
+    } else if constexpr (IsJsonArray<T>::value) {
+        buffer += '[';
+        for (size_t i = 0; i < val.size(); i++) {
+            if (i > 0) {
+                buffer += ',';
+            }
+            encodeJsonValue(val[i], buffer);
+        }
+        buffer += ']';
+    } else if constexpr (isJsonTransparent<T>()) {
+        encodeJsonValue(val.*std::get<0>(JsonSchema<T>::kFields).member_, buffer);
+    } else {
+        constexpr auto fieldsCnt = std::tuple_size_v<std::decay_t<decltype(JsonSchema<T>::kFields)>>;
+        encodeJsonFields(val, buffer, std::make_index_sequence<fieldsCnt>{});
+    }
+}
+
+template<class T>
+bool decodeJsonValue(JsonScanner &s, T &val) noexcept {
+    if constexpr (std::is_integral_v<T>) {
+        return s.readInt(val);
+    } else if constexpr (std::is_same_v<T, std::string>) {
+        std::string_view str;
+        if (!s.readString(str)) {
+            return false;
+        }
+        val.assign(str.data(), str.size());
+        return true;
+    } else if constexpr (IsJsonInlineString<T>::value) {
+        std::string_view str;
+        return s.readString(str) && val.assign(str);
+    } else if constexpr (IsJsonArray<T>::value) {
+        val.clear();
+        return s.readArray([&s, &val] {
+            val.emplace_back();
+            return decodeJsonValue(s, val.back());
+        });
+    } else if constexpr (isJsonTransparent<T>()) {
+        return decodeJsonValue(s, val.*std::get<0>(JsonSchema<T>::kFields).member_);
+    } else {
+        constexpr auto fieldsCnt = std::tuple_size_v<std::decay_t<decltype(JsonSchema<T>::kFields)>>;
+        static_assert(fieldsCnt < 32, "too many fields for the found mask");
+        uint32_t found{0};
+        auto ok = s.readObject([&s, &val, &found](std::string_view key) {
+            return decodeJsonField(s, val, key, found, std::make_index_sequence<fieldsCnt>{});
+        });
+        // every field of the schema is required
+        return ok && found == (1u << fieldsCnt) - 1;
+    }
+}
+
+template<class T>
+void encodeJson(const T &val, std::string &buffer) noexcept {
+    buffer.clear();
+    encodeJsonValue(val, buffer);
+}
+
+// Decodes the whole body, trailing garbage is an error.
+template<class T>
+[[nodiscard]] bool decodeJson(std::string_view data, T &val) noexcept {
+    JsonScanner s(data);
+    return decodeJsonValue(s, val) && s.atEnd();
+}
+
+#endif //HIGHLOADCUP2021_JSON_SCHEMA_H
@@ -0,0 +1,210 @@
+#include "license_manager.h"
+#include <algorithm>
+
+constexpr int64_t kLicenseLatencySmoothing = 8;
+
+static void updateAverage(int64_t &avg, int64_t &samples, int64_t value) noexcept {
+    if (samples == 0) {
+        avg = value;
+    } else {
+        avg += (value - avg) / kLicenseLatencySmoothing;
+    }
+    samples++;
+}
+
+LicenseManager::LicenseManager() noexcept {
+    for (size_t i = 0; i < kRecordsCap; i++) {
+        freeRecords_[i] = (int16_t) (kRecordsCap - 1 - i);
+    }
+    freeRecordsCnt_ = kRecordsCap;
+    index_.fill(kEmptyIndex);
+}
+
+int16_t LicenseManager::findRecord(LicenseID id) const noexcept {
+    for (auto bucket = indexBucket(id);; bucket = (bucket + 1) % kIndexCap) {
+        auto idx = index_[bucket];
+        if (idx == kEmptyIndex || records_[(size_t) idx].license_.id_ == id) {
+            return idx;
+        }
+    }
+}
+
+void LicenseManager::insertIndex(int16_t recordIdx) noexcept {
+    auto bucket = indexBucket(records_[(size_t) recordIdx].license_.id_);
+    while (index_[bucket] != kEmptyIndex) {
+        bucket = (bucket + 1) % kIndexCap;
+    }
+    index_[bucket] = recordIdx;
+}
+
+void LicenseManager::eraseIndex(LicenseID id) noexcept {
+    auto hole = indexBucket(id);
+    while (index_[hole] != kEmptyIndex && records_[(size_t) index_[hole]].license_.id_ != id) {
+        hole = (hole + 1) % kIndexCap;
+    }
+    if (index_[hole] == kEmptyIndex) {
+        return;
+    }
+    index_[hole] = kEmptyIndex;
+    // shift back the following entries of the probe sequence so that lookups do not stop at the hole
+    for (auto bucket = (hole + 1) % kIndexCap; index_[bucket] != kEmptyIndex; bucket = (bucket + 1) % kIndexCap) {
+        auto home = indexBucket(records_[(size_t) index_[bucket]].license_.id_);
+        auto homeToBucket = (bucket + kIndexCap - home) % kIndexCap;
+        auto holeToBucket = (bucket + kIndexCap - hole) % kIndexCap;
+        if (homeToBucket >= holeToBucket) {
+            index_[hole] = index_[bucket];
+            index_[bucket] = kEmptyIndex;
+            hole = bucket;
+        }
+    }
+}
+
+Expected<std::chrono::microseconds> LicenseManager::addLicense(License l, LicenseClock::time_point now) noexcept {
+    if (freeRecordsCnt_ == 0) {
+        return ErrorCode::kNoFreeLicenseRecord;
+    }
+    auto idx = freeRecords_[--freeRecordsCnt_];
+    auto &record = records_[(size_t) idx];
+    record.license_ = l;
+    record.generation_++;
+    record.inUse_ = true;
+    record.replacementIssued_ = false;
+    insertIndex(idx);
+    inUseCnt_++;
+    digAllowedSum_ += l.digAllowed_;
+    addedCnt_++;
+    if (l.digAllowed_ > l.digUsed_) {
+        available_[availableCnt_++] = idx;
+        availableDigsCnt_ += l.digAllowed_ - l.digUsed_;
+    }
+    updateMirror(idx);
+    retryBackoff_ = std::chrono::milliseconds(kLicenseRetryBackoffMinMs);
+
+    std::chrono::microseconds idle{0};
+    if (releasesCnt_ > 0) {
+        idle = std::chrono::duration_cast<std::chrono::microseconds>(now - releases_[releasesHead_]);
+        releasesHead_ = (releasesHead_ + 1) % kRecordsCap;
+        releasesCnt_--;
+    }
+    return idle;
+}
+
+Expected<LicenseID> LicenseManager::reserveAvailableLicenseId(LicenseClock::time_point now) noexcept {
+    if (availableCnt_ == 0) {
+        return ErrorCode::kNoAvailableLicense;
+    }
+    auto idx = available_[availableCnt_ - 1];
+    auto &record = records_[(size_t) idx];
+    record.license_.digUsed_++;
+    availableDigsCnt_--;
+    updateMirror(idx);
+    if (record.license_.digUsed_ >= record.license_.digAllowed_) {
+        availableCnt_--;
+        record.exhaustedAt_ = now;
+        pushExhausted(idx);
+    }
+    return record.license_.id_;
+}
+
+Expected<int> LicenseManager::confirmDig(LicenseID id, LicenseClock::time_point now) noexcept {
+    auto idx = findRecord(id);
+    if (idx == kEmptyIndex) {
+        return ErrorCode::kLicenseNotFound;
+    }
+    auto &record = records_[(size_t) idx];
+    record.license_.digConfirmed_++;
+    if (record.license_.digConfirmed_ < record.license_.digAllowed_) {
+        updateMirror(idx);
+        return 0;
+    }
+
+    updateAverage(drainLagMcs_, drainLagSamples_,
+                  std::chrono::duration_cast<std::chrono::microseconds>(now - record.exhaustedAt_).count());
+    eraseIndex(id);
+    record.inUse_ = false;
+    updateMirror(idx);
+    freeRecords_[freeRecordsCnt_++] = idx;
+    inUseCnt_--;
+    // the slot stays idle from here until a license takes it
+    if (releasesCnt_ == kRecordsCap) {
+        releasesHead_ = (releasesHead_ + 1) % kRecordsCap;
+        releasesCnt_--;
+    }
+    releases_[(releasesHead_ + releasesCnt_) % kRecordsCap] = now;
+    releasesCnt_++;
+
+    int issuesCnt = record.replacementIssued_ ? 0 : 1;
+    if (deferredIssuesCnt_ > 0) {
+        deferredIssuesCnt_--;
+        issuesCnt++;
+    }
+    return issuesCnt;
+}
+
+int LicenseManager::fetchDueReplacements(LicenseClock::time_point now) noexcept {
+    if (drainLagSamples_ < kLicenseEarlyIssueMinSamples || issueLatencySamples_ < kLicenseEarlyIssueMinSamples) {
+        return 0;
+    }
+    auto lead = std::chrono::microseconds((int64_t) ((double) issueLatencyMcs_ * kLicenseEarlyIssueLeadFactor));
+    auto drainLag = std::chrono::microseconds(drainLagMcs_);
+    int cnt{0};
+    for (; exhaustedCnt_ > 0; exhaustedHead_ = (exhaustedHead_ + 1) % kExhaustedCap, exhaustedCnt_--) {
+        const auto &front = exhausted_[exhaustedHead_];
+        if (!isExhaustedInUse(front)) {
+            continue;
+        }
+        auto &record = records_[(size_t) front.idx_];
+        // the queue is ordered by exhaustion time, so the records behind are not due either
+        if (now + lead < record.exhaustedAt_ + drainLag) {
+            break;
+        }
+        record.replacementIssued_ = true;
+        cnt++;
+    }
+    return cnt;
+}
+
+void LicenseManager::pushExhausted(int16_t recordIdx) noexcept {
+    if (exhaustedCnt_ == kExhaustedCap) {
+        // drop the entries of released records, at most kRecordsCap records are in use
+        size_t kept{0};
+        for (size_t i = 0; i < exhaustedCnt_; i++) {
+            const auto &e = exhausted_[(exhaustedHead_ + i) % kExhaustedCap];
+            if (isExhaustedInUse(e)) {
+                exhausted_[(exhaustedHead_ + kept++) % kExhaustedCap] = e;
+            }
+        }
+        exhaustedCnt_ = kept;
+    }
+    exhausted_[(exhaustedHead_ + exhaustedCnt_) % kExhaustedCap] = {recordIdx,
+                                                                    records_[(size_t) recordIdx].generation_};
+    exhaustedCnt_++;
+}
+
+bool LicenseManager::deferIssue(LicenseClock::time_point now) noexcept {
+    int exhaustedInUseCnt{0};
+    for (const auto &record : records_) {
+        if (record.inUse_ && record.license_.digUsed_ >= record.license_.digAllowed_) {
+            exhaustedInUseCnt++;
+        }
+    }
+    if (deferredIssuesCnt_ < exhaustedInUseCnt) {
+        deferredIssuesCnt_++;
+        return true;
+    }
+    retryIssuesCnt_++;
+    retryAt_ = now + retryBackoff_;
+    retryBackoff_ = std::min(retryBackoff_ * 2, std::chrono::milliseconds(kLicenseRetryBackoffMaxMs));
+    return false;
+}
+
+void LicenseManager::setMirror(LicenseMirror *mirror) noexcept {
+    mirror_ = mirror;
+    for (size_t i = 0; i < kRecordsCap; i++) {
+        updateMirror((int16_t) i);
+    }
+}
+
+void LicenseManager::recordIssueLatency(std::chrono::microseconds latency) noexcept {
+    updateAverage(issueLatencyMcs_, issueLatencySamples_, latency.count());
+}
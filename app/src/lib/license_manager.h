@@ -0,0 +1,168 @@
+#ifndef HIGHLOADCUP2021_LICENSE_MANAGER_H
+#define HIGHLOADCUP2021_LICENSE_MANAGER_H
+
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <utility>
+#include "api_entities.h"
+#include "const.h"
+#include "error.h"
+
+using LicenseClock = std::chrono::steady_clock;
+
+struct LicenseRecord {
+    License license_{};
+    // time the last dig of the license was reserved
+    LicenseClock::time_point exhaustedAt_{};
+    // licenses placed in the record so far, tells a queued exhaustion of a previous license apart
+    uint32_t generation_{0};
+    bool inUse_{false};
+    bool replacementIssued_{false};
+};
+
+// Copy of a license record in memory that outlives the process, e.g. a snapshot file mapping.
+struct LicenseMirror {
+    License license_;
+    uint32_t inUse_;
+};
+
+// Keeps issued licenses and decides when replacements should be requested.
+// A license occupies one of kMaxLicensesCount server slots until its last dig is processed,
+// so the replacement is requested once the expected time to drain the in flight digs becomes
+// shorter than the license round trip instead of waiting for the last dig confirmation.
+// Reservation and lookup by id are O(1): records with reservable digs are kept on a stack and
+// ids are indexed by a small open addressing table. Exhausted records wait for their replacement in
+// a queue ordered by exhaustion time, released slots wait for a license in another one.
+class LicenseManager {
+public:
+    static constexpr size_t kRecordsCap = kMaxLicensesCount * 4;
+
+private:
+    static constexpr size_t kIndexCap = 64;
+    static constexpr int16_t kEmptyIndex = -1;
+    // entries of released records stay until they reach the front, twice the records always fit
+    static constexpr size_t kExhaustedCap = kRecordsCap * 2;
+
+    struct ExhaustedRecord {
+        int16_t idx_;
+        uint32_t generation_;
+    };
+
+    std::array<LicenseRecord, kRecordsCap> records_{};
+    std::array<int16_t, kRecordsCap> freeRecords_{};
+    size_t freeRecordsCnt_{0};
+    std::array<int16_t, kRecordsCap> available_{};
+    size_t availableCnt_{0};
+    // digs left to reserve in the available records
+    int64_t availableDigsCnt_{0};
+    std::array<int16_t, kIndexCap> index_{};
+    std::array<ExhaustedRecord, kExhaustedCap> exhausted_{};
+    size_t exhaustedHead_{0};
+    size_t exhaustedCnt_{0};
+    std::array<LicenseClock::time_point, kRecordsCap> releases_{};
+    size_t releasesHead_{0};
+    size_t releasesCnt_{0};
+    int inUseCnt_{0};
+    int deferredIssuesCnt_{0};
+    int retryIssuesCnt_{0};
+    LicenseClock::time_point retryAt_{};
+    std::chrono::milliseconds retryBackoff_{kLicenseRetryBackoffMinMs};
+    int64_t digAllowedSum_{0};
+    int64_t addedCnt_{0};
+
+    int64_t drainLagMcs_{0};
+    int64_t drainLagSamples_{0};
+    int64_t issueLatencyMcs_{0};
+    int64_t issueLatencySamples_{0};
+
+    LicenseMirror *mirror_{nullptr};
+
+    [[nodiscard]] static size_t indexBucket(LicenseID id) noexcept {
+        return (size_t) ((uint32_t) id * 2654435761u) % kIndexCap;
+    }
+
+    [[nodiscard]] int16_t findRecord(LicenseID id) const noexcept;
+
+    void insertIndex(int16_t recordIdx) noexcept;
+
+    void eraseIndex(LicenseID id) noexcept;
+
+    [[nodiscard]] bool isExhaustedInUse(const ExhaustedRecord &e) const noexcept {
+        const auto &record = records_[(size_t) e.idx_];
+        return record.inUse_ && record.generation_ == e.generation_;
+    }
+
+    void pushExhausted(int16_t recordIdx) noexcept;
+
+    void updateMirror(int16_t recordIdx) noexcept {
+        if (mirror_ != nullptr) {
+            const auto &record = records_[(size_t) recordIdx];
+            mirror_[recordIdx] = LicenseMirror{record.license_, record.inUse_};
+        }
+    }
+
+public:
+    LicenseManager() noexcept;
+
+    // Places an issued license and returns how long a slot stayed without a license
+    // since the oldest release that was not refilled yet.
+    [[nodiscard]] Expected<std::chrono::microseconds> addLicense(License l, LicenseClock::time_point now) noexcept;
+
+    [[nodiscard]] bool hasAvailableLicense() const noexcept {
+        return availableCnt_ > 0;
+    }
+
+    [[nodiscard]] int64_t getAvailableDigsCount() const noexcept {
+        return availableDigsCnt_;
+    }
+
+    [[nodiscard]] Expected<LicenseID> reserveAvailableLicenseId(LicenseClock::time_point now) noexcept;
+
+    [[nodiscard]] const License *getLicenseById(LicenseID id) const noexcept {
+        auto idx = findRecord(id);
+        if (idx == kEmptyIndex) {
+            return nullptr;
+        }
+        return &records_[(size_t) idx].license_;
+    }
+
+    // Confirms a processed dig and returns how many licenses should be requested now.
+    [[nodiscard]] Expected<int> confirmDig(LicenseID id, LicenseClock::time_point now) noexcept;
+
+    // Returns how many exhausted licenses are expected to drain before a license requested now arrives.
+    [[nodiscard]] int fetchDueReplacements(LicenseClock::time_point now) noexcept;
+
+    // The server rejected a license because all slots are still busy. It is requested again when an
+    // exhausted license is fully confirmed. Returns false if every exhausted license already has an issue
+    // waiting for it, e.g. its last dig was confirmed before the rejection arrived, then the license is
+    // requested again after a backoff, see fetchDueRetries.
+    bool deferIssue(LicenseClock::time_point now) noexcept;
+
+    // Returns how many rejected licenses should be requested again now.
+    [[nodiscard]] int fetchDueRetries(LicenseClock::time_point now) noexcept {
+        if (retryIssuesCnt_ == 0 || now < retryAt_) {
+            return 0;
+        }
+        return std::exchange(retryIssuesCnt_, 0);
+    }
+
+    void recordIssueLatency(std::chrono::microseconds latency) noexcept;
+
+    // Keeps kRecordsCap mirrors up to date with the records from now on, so that the licenses in use
+    // survive a crash. The records are written on every change, a change costs one small copy.
+    void setMirror(LicenseMirror *mirror) noexcept;
+
+    [[nodiscard]] int getInUseLicensesCount() const noexcept {
+        return inUseCnt_;
+    }
+
+    [[nodiscard]] double getAvgDigAllowed() const noexcept {
+        if (addedCnt_ == 0) {
+            return 0.0;
+        }
+        return (double) digAllowedSum_ / (double) addedCnt_;
+    }
+};
+
+#endif //HIGHLOADCUP2021_LICENSE_MANAGER_H
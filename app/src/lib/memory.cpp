@@ -0,0 +1,184 @@
+#include "memory.h"
+#include <sys/mman.h>
+#include <unistd.h>
+#include <algorithm>
+#include <cstdlib>
+#include <string_view>
+
+namespace {
+
+constexpr std::array<const char *, kMemoryArenasCnt> kMemoryArenaNames{"state grid", "http buffers",
+                                                                       "explore tree"};
+
+constexpr size_t alignUp(size_t val, size_t alignment) noexcept {
+    return (val + alignment - 1) / alignment * alignment;
+}
+
+std::once_flag arenasOnce;
+// never freed, blocks may be released by static destructors after main
+std::array<Arena *, kMemoryArenasCnt> arenas{};
+
+void reserveArenas(const MemoryArenasConfig &config) noexcept {
+    arenas[(size_t) MemoryArenaId::StateGrid] = new Arena(config.stateGridCap_, config.mode_);
+    arenas[(size_t) MemoryArenaId::HttpBuffers] = new Arena(config.httpBuffersCap_, config.mode_);
+    arenas[(size_t) MemoryArenaId::ExploreTree] = new Arena(config.exploreTreeCap_, config.mode_);
+}
+
+}
+
+std::ostream &operator<<(std::ostream &os, const HugePagesMode &mode) {
+    switch (mode) {
+        case HugePagesMode::Off:
+            os << "off";
+            break;
+        case HugePagesMode::Transparent:
+            os << "thp";
+            break;
+        case HugePagesMode::Explicit:
+            os << "explicit";
+            break;
+    }
+    return os;
+}
+
+HugePagesMode hugePagesFromEnv() noexcept {
+    auto modeEnv = std::getenv("HUGE_PAGES");
+    if (modeEnv == nullptr) {
+        return kHugePages;
+    }
+    std::string_view mode{modeEnv};
+    if (mode == "off") {
+        return HugePagesMode::Off;
+    }
+    if (mode == "thp") {
+        return HugePagesMode::Transparent;
+    }
+    if (mode == "explicit") {
+        return HugePagesMode::Explicit;
+    }
+    return kHugePages;
+}
+
+const char *getMemoryArenaName(MemoryArenaId id) noexcept {
+    return kMemoryArenaNames[(size_t) id];
+}
+
+Arena::Arena(size_t cap, HugePagesMode mode) noexcept {
+    if (cap == 0) {
+        return;
+    }
+    cap = alignUp(cap, kHugePageSize);
+    if (mode == HugePagesMode::Explicit) {
+        // without MAP_NORESERVE the huge pages are taken from the pool at once, a short pool fails here
+        // and not with SIGBUS on the first touch
+        auto p = mmap(nullptr, cap, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+        if (p != MAP_FAILED) {
+            mapping_ = static_cast<uint8_t *>(p);
+            mappedSize_ = cap;
+            base_ = mapping_;
+            cap_ = cap;
+            mode_ = HugePagesMode::Explicit;
+            return;
+        }
+        mode = HugePagesMode::Transparent;
+    }
+    // one spare huge page to start the arena at a huge page boundary
+    auto size = mode == HugePagesMode::Transparent ? cap + kHugePageSize : cap;
+    auto p = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+    if (p == MAP_FAILED) {
+        return;
+    }
+    mapping_ = static_cast<uint8_t *>(p);
+    mappedSize_ = size;
+    base_ = mapping_;
+    cap_ = cap;
+    if (mode == HugePagesMode::Transparent) {
+        base_ = reinterpret_cast<uint8_t *>(alignUp(reinterpret_cast<uintptr_t>(mapping_), kHugePageSize));
+        // THP disabled by the kernel leaves the arena on regular pages
+        if (madvise(base_, cap_, MADV_HUGEPAGE) == 0) {
+            mode_ = HugePagesMode::Transparent;
+        }
+    }
+}
+
+Arena::~Arena() {
+    if (mapping_ != nullptr) {
+        munmap(mapping_, mappedSize_);
+    }
+}
+
+size_t Arena::getBlockSpan(size_t bytes) noexcept {
+    bytes = alignUp(std::max<size_t>(bytes, 1), kSizeClass);
+    return bytes >= kHugePageSize ? alignUp(bytes, kHugePageSize) : bytes;
+}
+
+void *Arena::allocate(size_t bytes) noexcept {
+    bytes = alignUp(std::max<size_t>(bytes, 1), kSizeClass);
+    std::lock_guard<std::mutex> lock(mu_);
+    if (bytes <= kArenaMaxPooledSize) {
+        auto &head = freeLists_[bytes / kSizeClass];
+        if (head != nullptr) {
+            auto block = head;
+            head = block->next_;
+            live_ += bytes;
+            return block;
+        }
+    } else {
+        auto it = std::find_if(freeLarge_.begin(), freeLarge_.end(), [bytes](const auto &block) {
+            return block.second == bytes;
+        });
+        if (it != freeLarge_.end()) {
+            auto block = it->first;
+            freeLarge_.erase(it);
+            live_ += bytes;
+            return block;
+        }
+    }
+    auto offset = used_.load();
+    if (bytes >= kHugePageSize) {
+        offset = alignUp(offset, kHugePageSize);
+    }
+    if (offset + bytes > cap_) {
+        return nullptr;
+    }
+    used_ = offset + bytes;
+    live_ += bytes;
+    return base_ + offset;
+}
+
+void Arena::deallocate(void *p, size_t bytes) noexcept {
+    bytes = alignUp(std::max<size_t>(bytes, 1), kSizeClass);
+    std::lock_guard<std::mutex> lock(mu_);
+    live_ -= bytes;
+    if (bytes <= kArenaMaxPooledSize) {
+        auto &head = freeLists_[bytes / kSizeClass];
+        head = new(p) FreeBlock{head};
+        return;
+    }
+    freeLarge_.emplace_back(p, bytes);
+}
+
+size_t Arena::getResidentBytes() const noexcept {
+    static const auto pageSize = (size_t) sysconf(_SC_PAGESIZE);
+    auto used = alignUp(used_.load(), pageSize);
+    if (used == 0) {
+        return 0;
+    }
+    std::vector<unsigned char> pages(used / pageSize);
+    if (mincore(base_, used, pages.data()) != 0) {
+        return 0;
+    }
+    auto residentCnt = std::count_if(pages.begin(), pages.end(), [](unsigned char page) {
+        return (page & 1) != 0;
+    });
+    return (size_t) residentCnt * pageSize;
+}
+
+void initMemoryArenas(const MemoryArenasConfig &config) noexcept {
+    std::call_once(arenasOnce, reserveArenas, config);
+}
+
+Arena &memoryArena(MemoryArenaId id) noexcept {
+    std::call_once(arenasOnce, reserveArenas, MemoryArenasConfig{});
+    return *arenas[(size_t) id];
+}
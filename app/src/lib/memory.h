@@ -0,0 +1,192 @@
+#ifndef HIGHLOADCUP2021_MEMORY_H
+#define HIGHLOADCUP2021_MEMORY_H
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <ostream>
+#include <utility>
+#include <vector>
+#include "const.h"
+
+std::ostream &operator<<(std::ostream &os, const HugePagesMode &mode);
+
+// Reads HUGE_PAGES: off, thp or explicit, and falls back to kHugePages.
+HugePagesMode hugePagesFromEnv() noexcept;
+
+// One arena of each kind per process. The explore tree arena is shared by the app threads of all state
+// shards and its mutex is taken for every explore area and queue node, so the shards of a process
+// serialize there. A node costs far less than the explore response that creates it, hence one arena.
+enum class MemoryArenaId : size_t {
+    StateGrid = 0,
+    HttpBuffers,
+    ExploreTree,
+};
+
+constexpr size_t kMemoryArenasCnt = 3;
+
+const char *getMemoryArenaName(MemoryArenaId id) noexcept;
+
+// Virtual memory region of a fixed size reserved at once. Blocks are carved from its start, freed blocks
+// up to kArenaMaxPooledSize go to free lists of 16 byte size classes and larger ones are kept for an
+// allocation of the same size. An exhausted arena returns nullptr and the caller falls back to the heap,
+// so the capacity bounds the arena but never fails the game.
+class Arena {
+    static constexpr size_t kSizeClass = 16;
+    static constexpr size_t kSizeClassesCnt = kArenaMaxPooledSize / kSizeClass + 1;
+
+    struct FreeBlock {
+        FreeBlock *next_;
+    };
+
+    std::mutex mu_;
+    uint8_t *base_{nullptr};
+    size_t mappedSize_{0};
+    uint8_t *mapping_{nullptr};
+    size_t cap_{0};
+    // the bump offset and the bytes of blocks not freed
+    std::atomic<size_t> used_{0};
+    std::atomic<size_t> live_{0};
+    HugePagesMode mode_{HugePagesMode::Off};
+    std::array<FreeBlock *, kSizeClassesCnt> freeLists_{};
+    std::vector<std::pair<void *, size_t>> freeLarge_;
+    std::atomic<int64_t> heapFallbackBytes_{0};
+
+public:
+    Arena(size_t cap, HugePagesMode mode) noexcept;
+
+    ~Arena();
+
+    Arena(const Arena &o) = delete;
+
+    Arena(Arena &&o) = delete;
+
+    Arena &operator=(const Arena &o) = delete;
+
+    Arena &operator=(Arena &&o) = delete;
+
+    // Blocks are 16 byte aligned, blocks of kHugePageSize and more start at a huge page boundary.
+    [[nodiscard]] void *allocate(size_t bytes) noexcept;
+
+    // Bytes of the arena a block takes with its alignment, e.g. to size an arena for several of them.
+    [[nodiscard]] static size_t getBlockSpan(size_t bytes) noexcept;
+
+    void deallocate(void *p, size_t bytes) noexcept;
+
+    [[nodiscard]] bool owns(const void *p) const noexcept {
+        return p >= base_ && p < base_ + cap_;
+    }
+
+    void recordHeapFallback(int64_t bytes) noexcept {
+        heapFallbackBytes_ += bytes;
+    }
+
+    [[nodiscard]] HugePagesMode getMode() const noexcept {
+        return mode_;
+    }
+
+    [[nodiscard]] size_t getCapacity() const noexcept {
+        return cap_;
+    }
+
+    [[nodiscard]] size_t getCarvedBytes() const noexcept {
+        return used_.load();
+    }
+
+    [[nodiscard]] size_t getLiveBytes() const noexcept {
+        return live_.load();
+    }
+
+    // Bytes of the carved part that are in memory, mincore over it.
+    [[nodiscard]] size_t getResidentBytes() const noexcept;
+
+    [[nodiscard]] int64_t getHeapFallbackBytes() const noexcept {
+        return heapFallbackBytes_.load();
+    }
+};
+
+// Capacities of the arenas of the process in bytes.
+struct MemoryArenasConfig {
+    size_t stateGridCap_{kStateGridArenaCap};
+    size_t httpBuffersCap_{kHttpBuffersArenaCap};
+    size_t exploreTreeCap_{kExploreTreeArenaCap};
+    HugePagesMode mode_{kHugePages};
+};
+
+// Reserves the arenas of the process, the first call wins. An arena used before the call
+// reserves all of them with the default config.
+void initMemoryArenas(const MemoryArenasConfig &config) noexcept;
+
+Arena &memoryArena(MemoryArenaId id) noexcept;
+
+// Stateless allocator over an arena of the process, e.g. for allocate_shared and node based containers.
+template<class T, MemoryArenaId Id>
+class ArenaAllocator {
+public:
+    using value_type = T;
+
+    template<class U>
+    struct rebind {
+        using other = ArenaAllocator<U, Id>;
+    };
+
+    ArenaAllocator() noexcept = default;
+
+    template<class U>
+    ArenaAllocator(const ArenaAllocator<U, Id> &) noexcept {} // NOLINT(google-explicit-constructor)
+
+    T *allocate(size_t n) {
+        static_assert(alignof(T) <= 16, "arena blocks are 16 byte aligned");
+        auto bytes = n * sizeof(T);
+        auto &arena = memoryArena(Id);
+        if (auto p = arena.allocate(bytes); p != nullptr) {
+            return static_cast<T *>(p);
+        }
+        arena.recordHeapFallback((int64_t) bytes);
+        return static_cast<T *>(::operator new(bytes));
+    }
+
+    void deallocate(T *p, size_t n) noexcept {
+        auto &arena = memoryArena(Id);
+        if (arena.owns(p)) {
+            arena.deallocate(p, n * sizeof(T));
+            return;
+        }
+        arena.recordHeapFallback(-(int64_t) (n * sizeof(T)));
+        ::operator delete(p);
+    }
+
+    template<class U>
+    bool operator==(const ArenaAllocator<U, Id> &) const noexcept {
+        return true;
+    }
+
+    template<class U>
+    bool operator!=(const ArenaAllocator<U, Id> &) const noexcept {
+        return false;
+    }
+};
+
+template<class T, MemoryArenaId Id>
+struct ArenaDeleter {
+    void operator()(T *p) const noexcept {
+        p->~T();
+        ArenaAllocator<T, Id>().deallocate(p, 1);
+    }
+};
+
+template<class T, MemoryArenaId Id>
+using ArenaUniquePtr = std::unique_ptr<T, ArenaDeleter<T, Id>>;
+
+// Value initializes a T in the arena.
+template<class T, MemoryArenaId Id>
+ArenaUniquePtr<T, Id> makeArenaUnique() {
+    auto p = ArenaAllocator<T, Id>().allocate(1);
+    return ArenaUniquePtr<T, Id>(new(p) T());
+}
+
+#endif //HIGHLOADCUP2021_MEMORY_H
@@ -0,0 +1,45 @@
+#include "shard.h"
+#include "config.h"
+#include <algorithm>
+#include <cstdlib>
+
+size_t stateShardsCntFromEnv() noexcept {
+    auto shardsEnv = std::getenv("STATE_SHARDS");
+    if (shardsEnv == nullptr) {
+        return kStateShardsCnt;
+    }
+    auto cnt = std::strtoll(shardsEnv, nullptr, 10);
+    if (cnt <= 0) {
+        return kStateShardsCnt;
+    }
+    return std::min((size_t) cnt, kStateMaxShardsCnt);
+}
+
+std::vector<ShardConfig>
+ShardConfig::split(size_t cnt, size_t processId, size_t processCnt, std::shared_ptr<Broker> broker) {
+    auto licensesCnt = runtimeConfig().get().maxLicensesCount_;
+    processCnt = std::clamp(processCnt, (size_t) 1, kProcessMaxShardsCnt);
+    cnt = std::clamp(cnt, (size_t) 1, std::min(kStateMaxShardsCnt, std::max((size_t) 1, licensesCnt / processCnt)));
+    auto total = cnt * processCnt;
+    std::vector<ShardConfig> shards(cnt);
+    if (total == 1) {
+        shards[0].licensesQuota_ = licensesCnt;
+        return shards;
+    }
+    if (broker == nullptr) {
+        broker = std::make_shared<Broker>();
+    }
+    for (size_t i = 0; i < cnt; i++) {
+        auto index = processId * cnt + i;
+        auto x = index * (kFieldMaxX / total) + std::min(index, kFieldMaxX % total);
+        auto width = kFieldMaxX / total + (index < kFieldMaxX % total ? 1 : 0);
+        auto &shard = shards[i];
+        shard.id_ = (uint8_t) i;
+        shard.index_ = (uint8_t) index;
+        shard.cnt_ = (uint8_t) total;
+        shard.region_ = Area((int16_t) x, 0, (int16_t) width, (int16_t) kFieldMaxY);
+        shard.licensesQuota_ = licensesCnt / total + (index < licensesCnt % total ? 1 : 0);
+        shard.broker_ = broker;
+    }
+    return shards;
+}
@@ -0,0 +1,33 @@
+#ifndef HIGHLOADCUP2021_SHARD_H
+#define HIGHLOADCUP2021_SHARD_H
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+#include "api_entities.h"
+#include "broker.h"
+#include "const.h"
+
+// Reads STATE_SHARDS and falls back to kStateShardsCnt, the value is clamped to [1, kStateMaxShardsCnt].
+size_t stateShardsCntFromEnv() noexcept;
+
+// Part of the game owned by one App instance: a vertical strip of the field and a share of the license slots.
+// Shards run their own event loops and only meet in the Api workers and the broker.
+struct ShardConfig {
+    // response queue of the shard in its process
+    uint8_t id_{0};
+    // strip of the shard among all shards of the game
+    uint8_t index_{0};
+    uint8_t cnt_{1};
+    Area region_{0, 0, (int16_t) kFieldMaxX, (int16_t) kFieldMaxY};
+    size_t licensesQuota_{kMaxLicensesCount};
+    std::shared_ptr<Broker> broker_{nullptr};
+
+    // Splits the game between cnt shards in each of processCnt processes and returns the shards of the
+    // given process. Strips and license slots are split as evenly as possible, the first shards take the
+    // remainders, and every shard gets at least one license slot. The broker is created if none is given.
+    [[nodiscard]] static std::vector<ShardConfig>
+    split(size_t cnt, size_t processId = 0, size_t processCnt = 1, std::shared_ptr<Broker> broker = nullptr);
+};
+
+#endif //HIGHLOADCUP2021_SHARD_H
@@ -0,0 +1,179 @@
+#ifndef HIGHLOADCUP2021_SMALL_VECTOR_H
+#define HIGHLOADCUP2021_SMALL_VECTOR_H
+
+#include <array>
+#include <cstdlib>
+#include <cstring>
+#include <initializer_list>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+// Vector keeping up to N elements inline and moving to the heap only beyond that. Elements are
+// trivially copyable, so growing and copying are plain memcpy.
+template<class T, size_t N>
+class SmallVector {
+    static_assert(std::is_trivially_copyable_v<T>, "elements are moved with memcpy");
+
+    std::array<T, N> inline_{};
+    T *data_{inline_.data()};
+    size_t size_{0};
+    size_t capacity_{N};
+
+    [[nodiscard]] bool isInline() const noexcept {
+        return data_ == inline_.data();
+    }
+
+    void release() noexcept {
+        if (!isInline()) {
+            std::free(data_);
+        }
+        data_ = inline_.data();
+        capacity_ = N;
+    }
+
+    void copyFrom(const SmallVector &o) {
+        reserve(o.size_);
+        std::memcpy(static_cast<void *>(data_), o.data_, o.size_ * sizeof(T));
+        size_ = o.size_;
+    }
+
+    void moveFrom(SmallVector &o) noexcept {
+        if (o.isInline()) {
+            std::memcpy(static_cast<void *>(data_), o.data_, o.size_ * sizeof(T));
+        } else {
+            data_ = o.data_;
+            capacity_ = o.capacity_;
+            o.data_ = o.inline_.data();
+            o.capacity_ = N;
+        }
+        size_ = o.size_;
+        o.size_ = 0;
+    }
+
+public:
+    using value_type = T;
+    using iterator = T *;
+    using const_iterator = const T *;
+
+    SmallVector() noexcept = default;
+
+    SmallVector(std::initializer_list<T> init) {
+        reserve(init.size());
+        for (const auto &v : init) {
+            data_[size_++] = v;
+        }
+    }
+
+    SmallVector(const SmallVector &o) {
+        copyFrom(o);
+    }
+
+    SmallVector(SmallVector &&o) noexcept {
+        moveFrom(o);
+    }
+
+    SmallVector &operator=(const SmallVector &o) {
+        if (this != &o) {
+            size_ = 0;
+            copyFrom(o);
+        }
+        return *this;
+    }
+
+    SmallVector &operator=(SmallVector &&o) noexcept {
+        if (this != &o) {
+            release();
+            moveFrom(o);
+        }
+        return *this;
+    }
+
+    ~SmallVector() {
+        release();
+    }
+
+    void reserve(size_t capacity) {
+        if (capacity <= capacity_) {
+            return;
+        }
+        auto data = static_cast<T *>(std::malloc(capacity * sizeof(T)));
+        if (data == nullptr) {
+            throw std::bad_alloc();
+        }
+        std::memcpy(static_cast<void *>(data), data_, size_ * sizeof(T));
+        release();
+        data_ = data;
+        capacity_ = capacity;
+    }
+
+    void push_back(const T &v) {
+        if (size_ == capacity_) {
+            reserve(capacity_ * 2);
+        }
+        data_[size_++] = v;
+    }
+
+    template<class... Args>
+    T &emplace_back(Args &&... args) {
+        if (size_ == capacity_) {
+            reserve(capacity_ * 2);
+        }
+        data_[size_] = T(std::forward<Args>(args)...);
+        return data_[size_++];
+    }
+
+    void clear() noexcept {
+        size_ = 0;
+    }
+
+    [[nodiscard]] size_t size() const noexcept {
+        return size_;
+    }
+
+    [[nodiscard]] bool empty() const noexcept {
+        return size_ == 0;
+    }
+
+    T &operator[](size_t i) noexcept {
+        return data_[i];
+    }
+
+    const T &operator[](size_t i) const noexcept {
+        return data_[i];
+    }
+
+    T &back() noexcept {
+        return data_[size_ - 1];
+    }
+
+    iterator begin() noexcept {
+        return data_;
+    }
+
+    iterator end() noexcept {
+        return data_ + size_;
+    }
+
+    const_iterator begin() const noexcept {
+        return data_;
+    }
+
+    const_iterator end() const noexcept {
+        return data_ + size_;
+    }
+
+    friend bool operator==(const SmallVector &l, const SmallVector &r) noexcept {
+        if (l.size_ != r.size_) {
+            return false;
+        }
+        for (size_t i = 0; i < l.size_; i++) {
+            if (!(l.data_[i] == r.data_[i])) {
+                return false;
+            }
+        }
+        return true;
+    }
+};
+
+#endif //HIGHLOADCUP2021_SMALL_VECTOR_H
@@ -0,0 +1,264 @@
+#include "snapshot.h"
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/file.h>
+#include <sys/mman.h>
+#include <type_traits>
+#include <unistd.h>
+#include "util.h"
+
+std::string snapshotPathFromEnv(uint8_t shardIndex, uint8_t shardsCnt) {
+    auto pathEnv = std::getenv("SNAPSHOT_PATH");
+    if (pathEnv == nullptr || *pathEnv == '\0') {
+        return "";
+    }
+    std::string path{pathEnv};
+    if (shardsCnt > 1) {
+        path += "." + std::to_string(shardIndex);
+    }
+    return path;
+}
+
+namespace {
+
+constexpr uint64_t kSnapshotMagic = 0x484c433231534e50;
+constexpr uint32_t kSnapshotVersion = 1;
+constexpr size_t kSnapshotPageSize = 4096;
+
+constexpr size_t alignPage(size_t size) noexcept {
+    return (size + kSnapshotPageSize - 1) / kSnapshotPageSize * kSnapshotPageSize;
+}
+
+constexpr size_t kCellsOffset = kSnapshotPageSize;
+constexpr size_t kLicensesOffset = kCellsOffset + alignPage(sizeof(CellGrid));
+constexpr size_t kSlotsOffset = kLicensesOffset + alignPage(sizeof(LicenseMirror) * LicenseManager::kRecordsCap);
+constexpr size_t kSlotSize = alignPage(kSnapshotSlotCap);
+constexpr size_t kSnapshotFileSize = kSlotsOffset + 2 * kSlotSize;
+
+struct SlotHeader {
+    uint32_t frontierCnt_;
+    uint32_t childAreasCnt_;
+    uint32_t coinsCnt_;
+    uint32_t cashCnt_;
+    uint32_t rootExplored_;
+};
+
+static_assert(std::is_trivially_copyable_v<CellState>);
+static_assert(std::is_trivially_copyable_v<LicenseMirror>);
+static_assert(std::is_trivially_copyable_v<SnapshotFrontierArea>);
+static_assert(std::is_trivially_copyable_v<SnapshotCash>);
+
+int64_t systemNowMs() noexcept {
+    return std::chrono::duration_cast<std::chrono::milliseconds>(
+            std::chrono::system_clock::now().time_since_epoch()).count();
+}
+
+template<class T>
+uint8_t *writeArray(uint8_t *dst, const std::vector<T> &src) noexcept {
+    if (src.empty()) {
+        return dst;
+    }
+    std::memcpy(dst, src.data(), src.size() * sizeof(T));
+    return dst + src.size() * sizeof(T);
+}
+
+template<class T>
+const uint8_t *readArray(const uint8_t *src, uint32_t cnt, std::vector<T> &dst) {
+    dst.resize(cnt);
+    if (cnt == 0) {
+        return src;
+    }
+    std::memcpy(dst.data(), src, cnt * sizeof(T));
+    return src + cnt * sizeof(T);
+}
+
+}
+
+// The header page. seq_ is the number of published slots, the last one is slot seq_ % 2.
+struct Snapshot::Header {
+    uint64_t magic_;
+    uint32_t version_;
+    uint32_t shardIndex_;
+    Area region_;
+    int64_t gameStartedAtMs_;
+    uint32_t closed_;
+    std::atomic<uint64_t> seq_;
+};
+
+static_assert(sizeof(Snapshot::Header) <= kSnapshotPageSize);
+
+ExpectedVoid Snapshot::open(const std::string &path, uint8_t shardIndex, Area region,
+                            std::chrono::milliseconds gameDuration) noexcept {
+    auto fd = ::open(path.c_str(), O_CREAT | O_RDWR | O_CLOEXEC, 0600);
+    if (fd < 0) {
+        return ErrorCode::kSnapshotError;
+    }
+    // the lock is held till the file is closed, so that two processes never write the same shard
+    if (flock(fd, LOCK_EX | LOCK_NB) != 0) {
+        close(fd);
+        return ErrorCode::kSnapshotError;
+    }
+    // a file of another size is left from another build and is reinitialized
+    auto size = lseek(fd, 0, SEEK_END);
+    if (size != (off_t) kSnapshotFileSize && (ftruncate(fd, 0) != 0 || ftruncate(fd, kSnapshotFileSize) != 0)) {
+        close(fd);
+        return ErrorCode::kSnapshotError;
+    }
+    auto addr = mmap(nullptr, kSnapshotFileSize, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (addr == MAP_FAILED) {
+        close(fd);
+        return ErrorCode::kSnapshotError;
+    }
+    auto header = static_cast<Header *>(addr);
+    restorable_ = size == (off_t) kSnapshotFileSize && header->magic_ == kSnapshotMagic &&
+                  header->version_ == kSnapshotVersion && header->closed_ == 0 &&
+                  header->shardIndex_ == shardIndex && std::memcmp(&header->region_, &region, sizeof(Area)) == 0 &&
+                  systemNowMs() - header->gameStartedAtMs_ < gameDuration.count();
+    if (!restorable_) {
+        // truncating zero fills the cells, the license records and the slots of the mapping
+        if (ftruncate(fd, 0) != 0 || ftruncate(fd, kSnapshotFileSize) != 0) {
+            munmap(addr, kSnapshotFileSize);
+            close(fd);
+            return ErrorCode::kSnapshotError;
+        }
+        header->version_ = kSnapshotVersion;
+        header->shardIndex_ = shardIndex;
+        header->region_ = region;
+        header->gameStartedAtMs_ = systemNowMs();
+        header->closed_ = 0;
+        header->seq_ = 0;
+        header->magic_ = kSnapshotMagic;
+    }
+
+    fd_ = fd;
+    addr_ = addr;
+    size_ = kSnapshotFileSize;
+    header_ = header;
+    writer_ = std::thread(&Snapshot::writerLoop, this);
+    return NoErr;
+}
+
+Snapshot::~Snapshot() {
+    if (header_ == nullptr) {
+        return;
+    }
+    {
+        std::lock_guard<std::mutex> lock(mu_);
+        stopped_ = true;
+    }
+    cv_.notify_all();
+    writer_.join();
+    header_->closed_ = 1;
+    munmap(addr_, size_);
+    close(fd_);
+}
+
+CellGrid *Snapshot::getCells() const noexcept {
+    if (header_ == nullptr) {
+        return nullptr;
+    }
+    return reinterpret_cast<CellGrid *>(static_cast<uint8_t *>(addr_) + kCellsOffset);
+}
+
+LicenseMirror *Snapshot::getLicenses() const noexcept {
+    if (header_ == nullptr) {
+        return nullptr;
+    }
+    return reinterpret_cast<LicenseMirror *>(static_cast<uint8_t *>(addr_) + kLicensesOffset);
+}
+
+std::chrono::milliseconds Snapshot::getGameElapsed() const noexcept {
+    if (header_ == nullptr) {
+        return std::chrono::milliseconds(0);
+    }
+    return std::chrono::milliseconds(std::max<int64_t>(0, systemNowMs() - header_->gameStartedAtMs_));
+}
+
+void Snapshot::markGameStarted() noexcept {
+    if (header_ != nullptr) {
+        header_->gameStartedAtMs_ = systemNowMs();
+    }
+}
+
+uint8_t *Snapshot::getSlot(size_t idx) const noexcept {
+    return static_cast<uint8_t *>(addr_) + kSlotsOffset + idx * kSlotSize;
+}
+
+void Snapshot::read(SnapshotData &data) const noexcept {
+    data.clear();
+    data.rootExplored_ = false;
+    if (header_ == nullptr) {
+        return;
+    }
+    auto seq = header_->seq_.load(std::memory_order_acquire);
+    if (seq == 0) {
+        return;
+    }
+    const uint8_t *src = getSlot(seq % 2);
+    SlotHeader slot{};
+    std::memcpy(&slot, src, sizeof(SlotHeader));
+    src += sizeof(SlotHeader);
+    src = readArray(src, slot.frontierCnt_, data.frontier_);
+    src = readArray(src, slot.childAreasCnt_, data.childAreas_);
+    src = readArray(src, slot.coinsCnt_, data.coins_);
+    readArray(src, slot.cashCnt_, data.cash_);
+    data.rootExplored_ = slot.rootExplored_ != 0;
+}
+
+bool Snapshot::submit(SnapshotData &data) noexcept {
+    if (header_ == nullptr || sizeof(SlotHeader) + data.getBytes() > kSlotSize) {
+        return false;
+    }
+    {
+        std::lock_guard<std::mutex> lock(mu_);
+        if (hasPending_) {
+            return false;
+        }
+        std::swap(pending_, data);
+        hasPending_ = true;
+    }
+    cv_.notify_all();
+    return true;
+}
+
+void Snapshot::flush() noexcept {
+    std::unique_lock<std::mutex> lock(mu_);
+    cv_.wait(lock, [this] { return !hasPending_ || stopped_; });
+}
+
+void Snapshot::writeSlot(const SnapshotData &data) noexcept {
+    auto seq = header_->seq_.load(std::memory_order_relaxed);
+    auto dst = getSlot((seq + 1) % 2);
+    SlotHeader slot{(uint32_t) data.frontier_.size(), (uint32_t) data.childAreas_.size(),
+                    (uint32_t) data.coins_.size(), (uint32_t) data.cash_.size(), data.rootExplored_ ? 1u : 0u};
+    std::memcpy(dst, &slot, sizeof(SlotHeader));
+    dst += sizeof(SlotHeader);
+    dst = writeArray(dst, data.frontier_);
+    dst = writeArray(dst, data.childAreas_);
+    dst = writeArray(dst, data.coins_);
+    writeArray(dst, data.cash_);
+    header_->seq_.store(seq + 1, std::memory_order_release);
+}
+
+void Snapshot::writerLoop() noexcept {
+    std::unique_lock<std::mutex> lock(mu_);
+    for (;;) {
+        cv_.wait(lock, [this] { return hasPending_ || stopped_; });
+        if (stopped_) {
+            return;
+        }
+        // the app thread only swaps buffers under the lock, the copy runs without it
+        lock.unlock();
+        Measure<std::chrono::microseconds> tm;
+        writeSlot(pending_);
+        auto writeMcs = tm.getInt64();
+        if (onWritten_) {
+            onWritten_(writeMcs, pending_.getBytes());
+        }
+        lock.lock();
+        hasPending_ = false;
+        cv_.notify_all();
+    }
+}
@@ -0,0 +1,143 @@
+#ifndef HIGHLOADCUP2021_SNAPSHOT_H
+#define HIGHLOADCUP2021_SNAPSHOT_H
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include "api_entities.h"
+#include "error.h"
+#include "license_manager.h"
+#include "state.h"
+
+// Area of the explore tree with children left to explore, the children follow it in childAreas_.
+struct SnapshotFrontierArea {
+    Area area_;
+    uint32_t leftTreasuriesCnt_;
+    uint32_t exploreDepth_;
+    uint32_t childrenCnt_;
+};
+
+struct SnapshotCash {
+    TreasureID treasureId_;
+    int8_t depth_;
+};
+
+// The part of the state that is copied to the snapshot periodically.
+struct SnapshotData {
+    std::vector<SnapshotFrontierArea> frontier_;
+    std::vector<Area> childAreas_;
+    std::vector<CoinID> coins_;
+    // dug treasures that were not cashed yet
+    std::vector<SnapshotCash> cash_;
+    // the amount of treasures of the shard region is known, an empty frontier means nothing is left to explore
+    bool rootExplored_{false};
+
+    void clear() noexcept {
+        frontier_.clear();
+        childAreas_.clear();
+        coins_.clear();
+        cash_.clear();
+    }
+
+    [[nodiscard]] size_t getBytes() const noexcept {
+        return frontier_.size() * sizeof(SnapshotFrontierArea) + childAreas_.size() * sizeof(Area) +
+               coins_.size() * sizeof(CoinID) + cash_.size() * sizeof(SnapshotCash);
+    }
+};
+
+// Reads SNAPSHOT_PATH, an empty string disables snapshots. Shards of a split game add ".<shard index>".
+std::string snapshotPathFromEnv(uint8_t shardIndex, uint8_t shardsCnt);
+
+// State of one shard kept in a memory mapped file, so that a restarted process resumes the game.
+// The file holds plain data addressed by offsets, it does not depend on where it is mapped:
+//  - the cell grid of State lives in the mapping and is written through by the game itself;
+//  - the license records are mirrored on every change, see LicenseManager::setMirror;
+//  - the explore frontier, the coins and the treasures waiting for cash are copied to one of two slots
+//    every kSnapshotPeriodMs. The slot is written by a background thread and published by bumping
+//    the sequence number, so a crash in the middle of a write leaves the previous slot valid.
+// The page cache keeps the mapping when the process dies, msync is not needed for a process crash.
+class Snapshot {
+public:
+    struct Header;
+
+private:
+    int fd_{-1};
+    void *addr_{nullptr};
+    size_t size_{0};
+    Header *header_{nullptr};
+    bool restorable_{false};
+
+    std::thread writer_;
+    std::mutex mu_;
+    std::condition_variable cv_;
+    SnapshotData pending_;
+    bool hasPending_{false};
+    bool stopped_{false};
+    std::function<void(int64_t writeMcs, size_t bytes)> onWritten_;
+
+    void writerLoop() noexcept;
+
+    void writeSlot(const SnapshotData &data) noexcept;
+
+    [[nodiscard]] uint8_t *getSlot(size_t idx) const noexcept;
+
+public:
+    Snapshot() = default;
+
+    Snapshot(const Snapshot &o) = delete;
+
+    Snapshot(Snapshot &&o) = delete;
+
+    Snapshot &operator=(const Snapshot &o) = delete;
+
+    Snapshot &operator=(Snapshot &&o) = delete;
+
+    // A file with the same shard and region of a game that is still running is kept for restoring,
+    // anything else, e.g. a file of a finished game, is reset.
+    [[nodiscard]] ExpectedVoid open(const std::string &path, uint8_t shardIndex, Area region,
+                                    std::chrono::milliseconds gameDuration) noexcept;
+
+    // Marks the game finished, a clean exit is never resumed.
+    ~Snapshot();
+
+    [[nodiscard]] bool isEnabled() const noexcept {
+        return header_ != nullptr;
+    }
+
+    [[nodiscard]] bool isRestorable() const noexcept {
+        return restorable_;
+    }
+
+    [[nodiscard]] CellGrid *getCells() const noexcept;
+
+    [[nodiscard]] LicenseMirror *getLicenses() const noexcept;
+
+    // Time since the game of the file started.
+    [[nodiscard]] std::chrono::milliseconds getGameElapsed() const noexcept;
+
+    // Moves the start of the game of the file to now.
+    void markGameStarted() noexcept;
+
+    // Reads the last published slot, the data is empty if none was published.
+    void read(SnapshotData &data) const noexcept;
+
+    // Hands the data over to the writer thread, data gets the buffers of the previous snapshot.
+    // Returns false and keeps data if the writer is still busy with the previous one.
+    bool submit(SnapshotData &data) noexcept;
+
+    // Called on the writer thread after every published slot.
+    void setOnWritten(std::function<void(int64_t writeMcs, size_t bytes)> onWritten) noexcept {
+        onWritten_ = std::move(onWritten);
+    }
+
+    // Waits for the submitted snapshot to be published.
+    void flush() noexcept;
+};
+
+#endif //HIGHLOADCUP2021_SNAPSHOT_H
@@ -0,0 +1,52 @@
+#include "speculative_dig.h"
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+
+bool speculativeDigFromEnv() noexcept {
+    auto modeEnv = std::getenv("SPECULATIVE_DIG");
+    if (modeEnv == nullptr) {
+        return kSpeculativeDig;
+    }
+    if (std::strcmp(modeEnv, "on") == 0) {
+        return true;
+    }
+    if (std::strcmp(modeEnv, "off") == 0) {
+        return false;
+    }
+    return kSpeculativeDig;
+}
+
+double SpeculativeDigs::expectedWastedDigs(size_t area, size_t treasuriesCnt) noexcept {
+    auto emptyProb = std::pow(1.0 - 1.0 / (double) area, (double) treasuriesCnt);
+    auto depths = (double) kMaxDigDepth;
+    return (double) area * emptyProb * depths + (double) (area - 1) * (1.0 - emptyProb) * depths / 2.0;
+}
+
+bool SpeculativeDigs::shouldSpeculate(const ExploreArea &exploreArea, double exploreCostMcs,
+                                      double digCostMcs, int64_t availableDigsCnt) const noexcept {
+    auto area = exploreArea.area_.getArea();
+    if (!enabled_ || area <= 1 || area > kSpeculativeDigMaxArea || exploreArea.actualTreasuriesCnt_ == 0) {
+        return false;
+    }
+    auto wastedDigs = expectedWastedDigs(area, exploreArea.actualTreasuriesCnt_);
+    return wastedDigs <= (double) availableDigsCnt && wastedDigs * digCostMcs < exploreCostMcs;
+}
+
+void SpeculativeDigs::start(const ExploreAreaPtr &exploreArea) {
+    const auto &a = exploreArea->area_;
+    for (auto x = a.posX_; x < a.posX_ + a.sizeX_; x++) {
+        for (auto y = a.posY_; y < a.posY_ + a.sizeY_; y++) {
+            cells_[cellKey(x, y)] = exploreArea;
+        }
+    }
+}
+
+void SpeculativeDigs::finishArea(const ExploreArea &exploreArea) noexcept {
+    const auto &a = exploreArea.area_;
+    for (auto x = a.posX_; x < a.posX_ + a.sizeX_; x++) {
+        for (auto y = a.posY_; y < a.posY_ + a.sizeY_; y++) {
+            cells_.erase(cellKey(x, y));
+        }
+    }
+}
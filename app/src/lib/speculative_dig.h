@@ -0,0 +1,57 @@
+#ifndef HIGHLOADCUP2021_SPECULATIVE_DIG_H
+#define HIGHLOADCUP2021_SPECULATIVE_DIG_H
+
+#include <cstdint>
+#include <unordered_map>
+#include "api_entities.h"
+#include "const.h"
+
+// Reads SPECULATIVE_DIG (on|off) and falls back to kSpeculativeDig.
+bool speculativeDigFromEnv() noexcept;
+
+// Keeps small explored areas whose cells are dug without resolving them to 1x1 with /explore.
+// Cells of such an area have no exact treasures count, so leftTreasuriesAmount_ of a cell holds the
+// treasures left in the whole area as an upper bound and the area counts found treasures in
+// exploredChildrenTreasuriesCnt_; once they sum up to the area count the rest of its cells are empty.
+class SpeculativeDigs {
+    bool enabled_;
+    std::unordered_map<uint32_t, ExploreAreaPtr> cells_;
+
+    [[nodiscard]] static uint32_t cellKey(int16_t x, int16_t y) noexcept {
+        return (uint32_t) (uint16_t) x << 16 | (uint16_t) y;
+    }
+
+public:
+    explicit SpeculativeDigs(bool enabled) noexcept: enabled_{enabled} {}
+
+    [[nodiscard]] bool isEnabled() const noexcept {
+        return enabled_;
+    }
+
+    // Digs wasted against exploring the area down to 1x1: an empty cell is dug through all depths
+    // and a non empty one through half of them past its last treasure.
+    [[nodiscard]] static double expectedWastedDigs(size_t area, size_t treasuriesCnt) noexcept;
+
+    // A dig costs its latency and its share of the license round trip. The wasted digs must fit the
+    // digs the licenses at hand still allow, they are not worth a license of their own.
+    [[nodiscard]] bool shouldSpeculate(const ExploreArea &exploreArea, double exploreCostMcs,
+                                       double digCostMcs, int64_t availableDigsCnt) const noexcept;
+
+    void start(const ExploreAreaPtr &exploreArea);
+
+    [[nodiscard]] ExploreAreaPtr find(int16_t x, int16_t y) const noexcept {
+        auto it = cells_.find(cellKey(x, y));
+        if (it == cells_.end()) {
+            return nullptr;
+        }
+        return it->second;
+    }
+
+    void finishCell(int16_t x, int16_t y) noexcept {
+        cells_.erase(cellKey(x, y));
+    }
+
+    void finishArea(const ExploreArea &exploreArea) noexcept;
+};
+
+#endif //HIGHLOADCUP2021_SPECULATIVE_DIG_H
@@ -3,7 +3,6 @@
 
 ExploreAreaPtr State::fetchNextExploreArea() noexcept {
 #ifdef _HLC_DEBUG
-    assert(!exploreQueue_.empty());
     ExploreAreaPtr prev = nullptr;
     for (const auto &val : exploreQueue_) {
         if (prev != nullptr) {
@@ -18,8 +17,6 @@ ExploreAreaPtr State::fetchNextExploreArea() noexcept {
             return child;
         }
     }
-#ifdef _HLC_DEBUG
-    assert(false);
-#endif
+    // every area in the queue has its children either in flight or left to be inferred
     return nullptr;
 }
@@ -1,45 +1,60 @@
 #ifndef HIGHLOADCUP2021_STATE_H
 #define HIGHLOADCUP2021_STATE_H
 
+#include <chrono>
 #include <cstdint>
 #include <utility>
 #include "const.h"
 #include <array>
 #include "api_entities.h"
 #include "error.h"
+#include "license_manager.h"
+#include "dig_scheduler.h"
 #include "log.h"
 #include <list>
-#include <stdexcept>
 #include <algorithm>
 #include <memory>
 #include <vector>
 #include "util.h"
+#include "memory.h"
 #include <cassert>
 #include <set>
 
-struct DelayedDigRequest {
-    int16_t x_, y_;
-    int8_t depth_;
+// Known state of a field cell. It is plain data, so the grid can live in a file mapping that outlives
+// the process, see Snapshot.
+struct CellState {
+    int16_t left_;
+    // the deepest dig whose response was processed
+    int8_t dugDepth_;
+    uint8_t flags_;
+};
 
-    DelayedDigRequest(int16_t x, int16_t y, int8_t depth) :
-            x_{x}, y_{y}, depth_{depth} {}
+constexpr uint8_t kCellDigInFlight = 1;
+// the left count is the one of the whole speculatively dug area
+constexpr uint8_t kCellSpeculative = 2;
+// the previous process died with a dig of the cell in flight, so its depth is unknown
+constexpr uint8_t kCellLost = 4;
 
-    bool operator<(const DelayedDigRequest &r2) const noexcept {
-        return depth_ > r2.depth_;
-    }
-};
+using CellGrid = std::array<std::array<CellState, kFieldMaxY>, kFieldMaxX>;
+using ExploreQueue = std::set<ExploreAreaPtr, std::less<ExploreAreaPtr>,
+        ArenaAllocator<ExploreAreaPtr, MemoryArenaId::ExploreTree>>;
 
 class State {
 private:
-    std::array<License, kMaxLicensesCount> licenses_{};
-    std::array<std::array<int32_t, kFieldMaxX>, kFieldMaxY> leftTreasuriesAmount_{};
+    LicenseManager licenses_{};
+    ArenaUniquePtr<CellGrid, MemoryArenaId::StateGrid> ownedCells_;
+    CellGrid &cells_;
     std::list<CoinID> coins_;
-    std::multiset<DelayedDigRequest> digRequests_;
-    std::set<ExploreAreaPtr> exploreQueue_{};
+    DigScheduler digRequests_;
+    ExploreQueue exploreQueue_{};
     ExploreAreaPtr root_{nullptr};
 
 public:
-    State() = default;
+    // The grid is allocated in the state grid arena unless an external one, e.g. a snapshot file mapping,
+    // is given.
+    explicit State(CellGrid *cells = nullptr) :
+            ownedCells_{cells == nullptr ? makeArenaUnique<CellGrid, MemoryArenaId::StateGrid>() : nullptr},
+            cells_{cells == nullptr ? *ownedCells_ : *cells} {}
 
     State(const State &s) = delete;
 
@@ -49,21 +64,6 @@ public:
 
     State &operator=(State &&s) = delete;
 
-    ~State() {
-        if (root_ != nullptr) {
-            cleanExploreAreaPtrs(root_);
-        }
-        root_ = nullptr;
-    }
-
-    void cleanExploreAreaPtrs(const ExploreAreaPtr &node) {
-        for (const auto &child : node->children_) {
-            cleanExploreAreaPtrs(child);
-        }
-        node->children_.resize(0);
-        node->parent_ = nullptr;
-    }
-
 
     void setRootExploreArea(ExploreAreaPtr r) noexcept {
         root_ = std::move(r);
@@ -75,7 +75,7 @@ public:
 
     ExploreAreaPtr fetchNextExploreArea() noexcept;
 
-    bool hasMoreExploreAreas() noexcept {
+    [[nodiscard]] bool hasMoreExploreAreas() const noexcept {
         return !exploreQueue_.empty();
     }
 
@@ -86,37 +86,56 @@ public:
 #endif
     }
 
-    void addLicence(License l) {
-        for (auto &v: licenses_) {
-            if (v.digAllowed_ == v.digConfirmed_) {
-                v = l;
-                break;
-            }
-        }
+    Expected<std::chrono::microseconds> addLicence(License l) noexcept {
+        return licenses_.addLicense(l, LicenseClock::now());
     }
 
-    bool hasAvailableLicense() {
-        return std::any_of(licenses_.begin(), licenses_.end(), [](const License &l) {
-            return l.digAllowed_ - l.digUsed_ > 0;
-        });
+    [[nodiscard]] bool hasAvailableLicense() const noexcept {
+        return licenses_.hasAvailableLicense();
     }
 
-    [[nodiscard]] Expected<LicenseID> reserveAvailableLicenseId() {
-        for (auto &v : licenses_) {
-            if (v.digAllowed_ - v.digUsed_ > 0) {
-                v.digUsed_++;
-                return v.id_;
-            }
-        }
-        return ErrorCode::kNoAvailableLicense;
+    [[nodiscard]] Expected<LicenseID> reserveAvailableLicenseId() noexcept {
+        return licenses_.reserveAvailableLicenseId(LicenseClock::now());
+    }
+
+    [[nodiscard]] LicenseManager &getLicenseManager() noexcept {
+        return licenses_;
     }
 
     void setLeftTreasuriesAmount(int16_t x, int16_t y, int32_t amount) {
-        leftTreasuriesAmount_[(size_t) x][(size_t) y] = amount;
+        cells_[(size_t) x][(size_t) y].left_ = (int16_t) std::clamp<int32_t>(amount, INT16_MIN, INT16_MAX);
     }
 
     int32_t getLeftTreasuriesAmount(int16_t x, int16_t y) {
-        return leftTreasuriesAmount_[(size_t) x][(size_t) y];
+        return cells_[(size_t) x][(size_t) y].left_;
+    }
+
+    [[nodiscard]] const CellState &getCell(int16_t x, int16_t y) const noexcept {
+        return cells_[(size_t) x][(size_t) y];
+    }
+
+    [[nodiscard]] CellState &getCell(int16_t x, int16_t y) noexcept {
+        return cells_[(size_t) x][(size_t) y];
+    }
+
+    // A cell is known once its treasures were counted or a dig touched it.
+    [[nodiscard]] bool isCellKnown(int16_t x, int16_t y) const noexcept {
+        const auto &cell = getCell(x, y);
+        return cell.left_ != 0 || cell.dugDepth_ != 0 || cell.flags_ != 0;
+    }
+
+    void startDig(int16_t x, int16_t y) noexcept {
+        getCell(x, y).flags_ |= kCellDigInFlight;
+    }
+
+    void finishDig(int16_t x, int16_t y, int8_t depth) noexcept {
+        auto &cell = getCell(x, y);
+        cell.dugDepth_ = depth;
+        cell.flags_ &= (uint8_t) ~kCellDigInFlight;
+    }
+
+    void markSpeculative(int16_t x, int16_t y) noexcept {
+        getCell(x, y).flags_ |= kCellSpeculative;
     }
 
     void addCoins(const Wallet &w) {
@@ -125,6 +144,17 @@ public:
         }
     }
 
+    // The server checks the license limit before it takes the payment, so a paid license refused for any
+    // reason but bogus coins spent nothing and its coins go back. Bogus coins are spent already, e.g. by
+    // a crashed process. Returns true if the coins are returned.
+    bool refundLicenseCoins(const Wallet &coins, int32_t httpCode, int32_t errorCode) {
+        if (httpCode == 200 || errorCode == kApiErrBogusCoin) {
+            return false;
+        }
+        addCoins(coins);
+        return true;
+    }
+
     bool hasCoins() {
         return !coins_.empty();
     }
@@ -135,48 +165,50 @@ public:
         return ret;
     }
 
+    Wallet borrowCoins(size_t cnt) {
+        Wallet ret;
+        ret.coins.reserve(cnt);
+        for (size_t i = 0; i < cnt && !coins_.empty(); i++) {
+            ret.coins.push_back(borrowCoin());
+        }
+        return ret;
+    }
+
     size_t getCoinsAmount() {
         return coins_.size();
     }
 
-    License &getLicenseById(LicenseID id) {
-        for (auto &v : licenses_) {
-            if (v.id_ == id) {
-                return v;
-            }
-        }
+    [[nodiscard]] const std::list<CoinID> &getCoins() const noexcept {
+        return coins_;
+    }
 
-        throw std::runtime_error("license not found");
+    // Parents with children left to explore.
+    [[nodiscard]] const ExploreQueue &getExploreAreas() const noexcept {
+        return exploreQueue_;
     }
 
-    int getInUseLicensesCount() noexcept {
-        int cnt = 0;
-        for (const auto &v: licenses_) {
-            if (v.digAllowed_ > v.digConfirmed_) {
-                cnt++;
-            }
-        }
-        return cnt;
+    [[nodiscard]] int getInUseLicensesCount() const noexcept {
+        return licenses_.getInUseLicensesCount();
     }
 
     void addDigRequest(DelayedDigRequest r) noexcept {
-        digRequests_.insert(r);
+        digRequests_.push(r, getLeftTreasuriesAmount(r.x_, r.y_));
+    }
+
+    void recordFoundTreasures(int8_t depth, size_t cnt) noexcept {
+        digRequests_.recordFoundTreasures(depth, cnt);
     }
 
-    bool hasQueuedDigRequests() noexcept {
+    [[nodiscard]] bool hasQueuedDigRequests() const noexcept {
         return !digRequests_.empty();
     }
 
+    [[nodiscard]] size_t getQueuedDigRequestsCount() const noexcept {
+        return digRequests_.size();
+    }
+
     DelayedDigRequest getNextDigRequest() noexcept {
-        auto r = digRequests_.extract(digRequests_.begin()).value();
-#ifdef _HLC_DEBUG
-        for (const auto &it : digRequests_) {
-            if (it.depth_ > r.depth_) {
-                assert(false);
-            }
-        }
-#endif
-        return r;
+        return digRequests_.pop();
     }
 };
 
@@ -2,6 +2,9 @@
 #include <chrono>
 #include <thread>
 #include "app.h"
+#include "config.h"
+#include "memory.h"
+#include "thread_placement.h"
 #include "util.h"
 #include <algorithm>
 #include "sys.h"
@@ -26,15 +29,50 @@ void Stats::print() noexcept {
     log_->info() << "Tick RPS: " << tickRPS;
     log_->info() << "Curl errs: " << curlErrCnt_.load();
     log_->info() << "Time elapsed: " << timeElapsedMs << " ms";
+    log_->info() << "Game phase: " << gamePhase_.load();
     log_->info() << "Timeouts: " << timeoutCnt_.load();
     log_->info() << "Explored area: " << exploredArea_.load();
     log_->info() << "Explored treasuries amount: " << treasuriesCnt_.load();
     log_->info() << "Cash skipped: " << cashSkippedCnt_.load();
+    auto cashDecisionsCnt = (double) (cashDecisions_[0].load() + cashDecisions_[1].load() + cashDecisions_[2].load());
+    log_->info() << "Cash decisions: cash " << (double) cashDecisions_[0].load() / cashDecisionsCnt << " defer "
+                 << (double) cashDecisions_[1].load() / cashDecisionsCnt << " drop "
+                 << (double) cashDecisions_[2].load() / cashDecisionsCnt;
     log_->info() << "Duplicate set explored: " << duplicateSetExplored_.load();
+    log_->info() << "Inferred explored (requests saved): " << inferredExplored_.load();
+    log_->info() << "Speculatively dug areas: " << speculativeDigAreas_.load();
+    log_->info() << "Sibling union explored: " << siblingUnionExplored_.load() << " empty: "
+                 << emptySiblingUnionExplored_.load() << " members: " << siblingUnionMembersCnt_.load();
     log_->info() << "Total process time: " << totalProcessResponseTime_.load() <<
                  " explore time: " << totalProcessExploreResponseTime_.load();
     log_->info() << "Avg explore request cost: "
                  << (double) exploreRequestTotalCost_.load() / (double) exploreRequestsCnt_.load();
+    log_->info() << "Explore controller: setpoint " << exploreControllerSetpoint_.load() << " backlog "
+                 << exploreControllerBacklog_.load() << " concurrency " << exploreControllerConcurrency_.load();
+    log_->info() << "Avg explore split fanout: "
+                 << (double) exploreSplitChildrenCnt_.load() / (double) exploreSplitsCnt_.load();
+    if (densityPriorMismatch_.load() >= 0.0) {
+        log_->info() << "Density prior mismatch: " << densityPriorMismatch_.load();
+    }
+    log_->info() << "Config: " << runtimeConfig().get() << " reloads " << runtimeConfig().getReloadsCnt();
+    for (size_t i = 0; i < kMemoryArenasCnt; i++) {
+        auto &arena = memoryArena((MemoryArenaId) i);
+        log_->info() << "Memory " << getMemoryArenaName((MemoryArenaId) i) << ": huge pages " << arena.getMode()
+                     << " resident " << arena.getResidentBytes() << " carved " << arena.getCarvedBytes() << " live "
+                     << arena.getLiveBytes() << " of " << arena.getCapacity() << " bytes heap fallback "
+                     << arena.getHeapFallbackBytes() << " bytes";
+    }
+    printCpuCores();
+    log_->info() << "Memory process resident: " << getProcessResidentBytes() << " bytes";
+    log_->info() << "Density map save time: " << densityMapSaveTime_.load() << " mcs";
+    if (snapshotsCnt_.load() > 0 || snapshotRestoreTime_.load() > 0) {
+        log_->info() << "Snapshot: written " << snapshotsCnt_.load() << " skipped " << snapshotsSkipped_.load()
+                     << " capture time " << snapshotCaptureTime_.load() << " mcs avg write time "
+                     << (double) snapshotWriteTime_.load() / (double) std::max<int64_t>(1, snapshotsCnt_.load())
+                     << " mcs max " << snapshotMaxWriteTime_.load() << " mcs last size " << snapshotBytes_.load()
+                     << " bytes restore time " << snapshotRestoreTime_.load() << " mcs restored cells "
+                     << snapshotRestoredCells_.load() << " lost " << snapshotLostCells_.load();
+    }
     log_->info() << "Treasures per second:" << (double) treasuriesCnt_.load() / (double) timeElapsedMs * 1000.0;
     if (treasuriesCnt_.load() > 0) {
         log_->info() << "Avg explore request per treasure: " <<
@@ -52,7 +90,17 @@ void Stats::print() noexcept {
 //          (double) inFlightExploreRequestsSum_ / (double) inFlightExploreRequestsCnt_);
     log_->info() << "Total cashed: " << cashedCoinsSum_.load() << " coins, " << cashedTreasuriesCnt_.load()
                  << " treasuries, " << (double) cashedCoinsSum_.load() / (double) cashedTreasuriesCnt_.load() << " avg";
+    log_->info() << "Cash lane: background " << cashLaneBackgroundCnt_.load() << " promoted "
+                 << cashLanePromotedCnt_.load() << " now promoted: " << cashLanePromoted_.load();
+    log_->info() << "Coin exchange: offered " << coinsOffered_.load() << " taken " << coinsTaken_.load();
+    log_->info() << "License pool: released " << licenseSlotsReleased_.load() << " taken "
+                 << licenseSlotsTaken_.load();
     log_->info() << "Issued licenses: " << issuedLicenses_.load();
+    log_->info() << "Early license issues: " << earlyLicenseIssues_.load() << " deferred: "
+                 << deferredLicenseIssues_.load();
+    log_->info() << "License slot idle time: " << licenseSlotIdleTime_.load() << " mcs";
+    log_->info() << "Paid licenses: " << paidLicenses_.load() << " coins: " << paidLicensesCoins_.load()
+                 << " digs per coin: " << (double) paidLicensesDigs_.load() / (double) paidLicensesCoins_.load();
     log_->info() << "Coins amount: " << coinsAmount_.load();
 
     printEndpointsStats();
@@ -146,6 +194,30 @@ void Stats::printCoinsDepthHistogram() noexcept {
     log_->info() << "depth coins histogram: " << logString.c_str();
 }
 
+void Stats::printCpuCores() noexcept {
+    const auto &placement = threadPlacement();
+    const auto &appCpus = placement.appCpus_;
+    auto perCpuStats = getPerCpuStats();
+    std::string logString{};
+    for (auto cpu : placement.allowedCpus_) {
+        auto idx = (size_t) cpu;
+        if (idx >= perCpuStats.size()) {
+            continue;
+        }
+        auto delta = idx < prevPerCpuStats_.size() ? perCpuStats[idx] - prevPerCpuStats_[idx] : perCpuStats[idx];
+        if (delta.getTotalTime() == 0) {
+            continue;
+        }
+        auto isApp = std::find(appCpus.begin(), appCpus.end(), cpu) != appCpus.end();
+        logString += " " + std::to_string(cpu) + (isApp ? " app " : " ") +
+                     std::to_string((int) delta.getActivePercent()) + "%";
+    }
+    prevPerCpuStats_ = std::move(perCpuStats);
+    log_->info() << "CPU cores active:" << logString;
+    log_->info() << "Thread placement: " << placement << " app thread migrations " << appThreadMigrationsCnt_.load()
+                 << " all threads migrations " << getThreadsMigrationsCnt();
+}
+
 //void Stats::printCpuStat() noexcept {
 //    auto stats = getCpuStats();
 //    infof("CPU active: %f%% CPU idle: %f%%\nUser: %f%% Nice: %f%% System: %f%% Idle: %f%% IOWait: %f%% Irq: %f%% SoftIrq: %f%% Steal: %f%% Guest: %f%% GuestNice: %f%%",
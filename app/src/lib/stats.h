@@ -13,6 +13,8 @@
 #include <array>
 #include <shared_mutex>
 #include <thread>
+#include <memory>
+#include "sys.h"
 
 struct EndpointStats {
     std::map<int32_t, int32_t> httpCodes;
@@ -35,21 +37,61 @@ private:
     std::atomic<int64_t> inUseLicensesCnt_{0};
     std::atomic<size_t> coinsAmount_{0};
     std::atomic<int64_t> issuedLicenses_{0};
+    std::atomic<int64_t> earlyLicenseIssues_{0};
+    std::atomic<int64_t> deferredLicenseIssues_{0};
+    std::atomic<int64_t> licenseSlotIdleTime_{0};
+    std::atomic<int64_t> paidLicenses_{0};
+    std::atomic<int64_t> paidLicensesCoins_{0};
+    std::atomic<int64_t> paidLicensesDigs_{0};
     std::atomic<int64_t> treasuriesCnt_{0};
     std::atomic<int64_t> cashSkippedCnt_{0};
+    // cash, defer and drop decisions of the cash policy
+    std::array<std::atomic<int64_t>, 3> cashDecisions_{};
     std::atomic<int64_t> exploredArea_{0};
     std::atomic<int64_t> duplicateSetExplored_{0};
+    std::atomic<int64_t> inferredExplored_{0};
+    std::atomic<int64_t> speculativeDigAreas_{0};
+    std::atomic<int64_t> siblingUnionExplored_{0};
+    std::atomic<int64_t> siblingUnionMembersCnt_{0};
+    std::atomic<int64_t> emptySiblingUnionExplored_{0};
     std::atomic<int32_t> timeoutCnt_{0};
     std::atomic<int64_t> totalProcessResponseTime_{0};
     std::atomic<int64_t> totalProcessExploreResponseTime_{0};
     std::atomic<int64_t> exploreRequestsCnt_{0};
     std::atomic<int64_t> exploreRequestTotalArea_{0};
     std::atomic<int64_t> exploreRequestTotalCost_{0};
+    std::atomic<double> densityPriorMismatch_{-1.0};
+    std::atomic<int64_t> densityMapSaveTime_{0};
+    std::atomic<int64_t> snapshotsCnt_{0};
+    std::atomic<int64_t> snapshotsSkipped_{0};
+    std::atomic<int64_t> snapshotCaptureTime_{0};
+    std::atomic<int64_t> snapshotWriteTime_{0};
+    std::atomic<int64_t> snapshotMaxWriteTime_{0};
+    std::atomic<int64_t> snapshotBytes_{0};
+    std::atomic<int64_t> snapshotRestoreTime_{0};
+    std::atomic<int64_t> snapshotRestoredCells_{0};
+    std::atomic<int64_t> snapshotLostCells_{0};
+    std::atomic<int64_t> appThreadMigrationsCnt_{0};
+    // touched by the stats thread only
+    std::vector<CpuStats> prevPerCpuStats_;
+    std::atomic<int64_t> exploreSplitsCnt_{0};
+    std::atomic<int64_t> exploreSplitChildrenCnt_{0};
 
     std::atomic<int64_t> inFlightRequestsSum_{0};
     std::atomic<int64_t> inFlightRequestsCnt_{0};
 
     std::atomic<int64_t> inFlightExploreRequestsSum_{0};
+    std::atomic<double> exploreControllerSetpoint_{0.0};
+    std::atomic<int> gamePhase_{0};
+    std::atomic<int64_t> cashLaneBackgroundCnt_{0};
+    std::atomic<int64_t> cashLanePromotedCnt_{0};
+    std::atomic<bool> cashLanePromoted_{false};
+    std::atomic<int64_t> coinsOffered_{0};
+    std::atomic<int64_t> coinsTaken_{0};
+    std::atomic<int64_t> licenseSlotsReleased_{0};
+    std::atomic<int64_t> licenseSlotsTaken_{0};
+    std::atomic<size_t> exploreControllerBacklog_{0};
+    std::atomic<size_t> exploreControllerConcurrency_{0};
     std::atomic<int64_t> inFlightExploreRequestsCnt_{0};
 
     std::atomic<int64_t> cashedCoinsSum_{0};
@@ -86,6 +128,8 @@ private:
 
 //    void printCpuStat() noexcept;
 
+    void printCpuCores() noexcept;
+
 public:
 
     Stats(std::shared_ptr<Log> log);
@@ -132,6 +176,98 @@ public:
         duplicateSetExplored_++;
     }
 
+    void incInferredExplored() noexcept {
+        inferredExplored_++;
+    }
+
+    void recordSiblingUnionExplore(size_t membersCnt) noexcept {
+        siblingUnionExplored_++;
+        siblingUnionMembersCnt_ += (int64_t) membersCnt;
+    }
+
+    void incEmptySiblingUnionExplored() noexcept {
+        emptySiblingUnionExplored_++;
+    }
+
+    void recordDensityPriorMismatch(double mismatch) noexcept {
+        densityPriorMismatch_ = mismatch;
+    }
+
+    void addDensityMapSaveTime(int64_t t) noexcept {
+        densityMapSaveTime_ += t;
+    }
+
+    // Copy of the state on the app thread, skipped while the writer is busy with the previous one.
+    void recordSnapshotCapture(int64_t captureMcs, bool submitted) noexcept {
+        snapshotCaptureTime_ += captureMcs;
+        if (!submitted) {
+            snapshotsSkipped_++;
+        }
+    }
+
+    // Called on the snapshot writer thread.
+    void recordSnapshotWrite(int64_t writeMcs, size_t bytes) noexcept {
+        snapshotsCnt_++;
+        snapshotWriteTime_ += writeMcs;
+        snapshotBytes_ = (int64_t) bytes;
+        auto prevMax = snapshotMaxWriteTime_.load();
+        while (prevMax < writeMcs && !snapshotMaxWriteTime_.compare_exchange_weak(prevMax, writeMcs)) {
+        }
+    }
+
+    // Called on an app thread that runs on another CPU than at its previous check.
+    void incAppThreadMigrations() noexcept {
+        appThreadMigrationsCnt_++;
+    }
+
+    void recordSnapshotRestore(int64_t restoreMcs, int64_t restoredCells, int64_t lostCells) noexcept {
+        snapshotRestoreTime_ += restoreMcs;
+        snapshotRestoredCells_ += restoredCells;
+        snapshotLostCells_ += lostCells;
+    }
+
+    void incCashLaneDispatched(bool promoted) noexcept {
+        if (promoted) {
+            cashLanePromotedCnt_++;
+        } else {
+            cashLaneBackgroundCnt_++;
+        }
+    }
+
+    void addExchangedCoins(bool offered, int64_t cnt) noexcept {
+        if (offered) {
+            coinsOffered_ += cnt;
+        } else {
+            coinsTaken_ += cnt;
+        }
+    }
+
+    void incLicenseSlotsMoved(bool released) noexcept {
+        if (released) {
+            licenseSlotsReleased_++;
+        } else {
+            licenseSlotsTaken_++;
+        }
+    }
+
+    void recordCashLanePromoted(bool promoted) noexcept {
+        cashLanePromoted_ = promoted;
+    }
+
+    void incSpeculativeDigAreas() noexcept {
+        speculativeDigAreas_++;
+    }
+
+    void recordGamePhase(int phase) noexcept {
+        gamePhase_ = phase;
+    }
+
+    void recordExploreController(double setpoint, size_t backlog, size_t concurrency) noexcept {
+        exploreControllerSetpoint_ = setpoint;
+        exploreControllerBacklog_ = backlog;
+        exploreControllerConcurrency_ = concurrency;
+    }
+
     void recordInUseLicenses(int cnt) noexcept {
         inUseLicensesSum_ += cnt;
         inUseLicensesCnt_++;
@@ -151,6 +287,24 @@ public:
         issuedLicenses_++;
     }
 
+    void incEarlyLicenseIssues() noexcept {
+        earlyLicenseIssues_++;
+    }
+
+    void incDeferredLicenseIssues() noexcept {
+        deferredLicenseIssues_++;
+    }
+
+    void addLicenseSlotIdleTime(int64_t mcs) noexcept {
+        licenseSlotIdleTime_ += mcs;
+    }
+
+    void recordPaidLicense(int64_t coinsCnt, int64_t digAllowed) noexcept {
+        paidLicenses_++;
+        paidLicensesCoins_ += coinsCnt;
+        paidLicensesDigs_ += digAllowed;
+    }
+
     void recordTreasureDepth(int depth, int count) noexcept {
         std::scoped_lock lock(depthHistogramMutex_);
 
@@ -182,6 +336,10 @@ public:
         cashSkippedCnt_++;
     }
 
+    void recordCashDecision(size_t decision) noexcept {
+        cashDecisions_[decision]++;
+    }
+
     void recordExploreArea(int area, int32_t durationMs) noexcept {
         size_t idx = 0;
         while (area >= 10) {
@@ -200,7 +358,12 @@ public:
         exploreRequestTotalCost_ += calculateExploreCost(area);
     }
 
-    int64_t calculateExploreCost(int64_t area) noexcept;
+    void recordExploreSplit(size_t childrenCnt) noexcept {
+        exploreSplitsCnt_++;
+        exploreSplitChildrenCnt_ += (int64_t) childrenCnt;
+    }
+
+    static int64_t calculateExploreCost(int64_t area) noexcept;
 
     void print() noexcept;
 
@@ -2,6 +2,9 @@
 
 #include <fstream>
 #include <sstream>
+#include <dirent.h>
+#include <unistd.h>
+#include <cstdlib>
 #include "log.h"
 
 const std::string CPU_STR = "cpu ";
@@ -32,3 +35,63 @@ CpuStats getCpuStats() noexcept {
     prevStats = stats;
     return ret;
 }
+
+size_t getProcessResidentBytes() noexcept {
+    std::ifstream fileStatm("/proc/self/statm");
+    size_t sizePages{0};
+    size_t residentPages{0};
+    if (!(fileStatm >> sizePages >> residentPages)) {
+        return 0;
+    }
+    return residentPages * (size_t) sysconf(_SC_PAGESIZE);
+}
+
+std::vector<CpuStats> getPerCpuStats() noexcept {
+    std::ifstream fileStat("/proc/stat");
+    std::vector<CpuStats> ret;
+    std::string line{};
+    while (std::getline(fileStat, line)) {
+        // the aggregate line is "cpu ", the per CPU ones are "cpuN "
+        if (line.rfind("cpu", 0) != 0 || line.size() < 4 || line[3] < '0' || line[3] > '9') {
+            continue;
+        }
+        std::istringstream ss(line.substr(3));
+        size_t cpu{0};
+        ss >> cpu;
+        if (cpu >= ret.size()) {
+            ret.resize(cpu + 1);
+        }
+        for (auto &val : ret[cpu].data_) {
+            ss >> val;
+        }
+    }
+    return ret;
+}
+
+int64_t getThreadsMigrationsCnt() noexcept {
+    auto dir = opendir("/proc/self/task");
+    if (dir == nullptr) {
+        return -1;
+    }
+    int64_t total{0};
+    bool found{false};
+    while (auto entry = readdir(dir)) {
+        if (entry->d_name[0] == '.') {
+            continue;
+        }
+        std::ifstream fileSched(std::string("/proc/self/task/") + entry->d_name + "/sched");
+        std::string line{};
+        while (std::getline(fileSched, line)) {
+            if (line.rfind("se.nr_migrations", 0) == 0) {
+                auto colon = line.find(':');
+                if (colon != std::string::npos) {
+                    total += std::strtoll(line.c_str() + colon + 1, nullptr, 10);
+                    found = true;
+                }
+                break;
+            }
+        }
+    }
+    closedir(dir);
+    return found ? total : -1;
+}
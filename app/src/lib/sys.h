@@ -2,7 +2,9 @@
 #define HIGHLOADCUP2021_SYS_H
 
 #include <array>
+#include <cstdint>
 #include <string>
+#include <vector>
 
 
 enum CpuStatsState : size_t {
@@ -63,5 +65,15 @@ struct CpuStats {
 
 [[maybe_unused]] CpuStats getCpuStats() noexcept;
 
+// Cumulative times of every CPU from the cpuN lines of /proc/stat, indexed by the CPU number.
+std::vector<CpuStats> getPerCpuStats() noexcept;
+
+// Sum of se.nr_migrations over the threads of the process from /proc/self/task/*/sched, -1 if the kernel
+// does not expose it.
+int64_t getThreadsMigrationsCnt() noexcept;
+
+// Resident set size of the process from /proc/self/statm, 0 if it is not readable.
+size_t getProcessResidentBytes() noexcept;
+
 
 #endif //HIGHLOADCUP2021_SYS_H
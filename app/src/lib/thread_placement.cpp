@@ -0,0 +1,177 @@
+#include "thread_placement.h"
+#include <pthread.h>
+#include <sched.h>
+#include <sys/resource.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include <algorithm>
+#include <cstdlib>
+#include <fstream>
+#include <string>
+#include <string_view>
+#include <utility>
+
+namespace {
+
+ThreadPlacement placement;
+
+bool readTopologyId(int cpu, const char *name, int &id) noexcept {
+    std::ifstream in("/sys/devices/system/cpu/cpu" + std::to_string(cpu) + "/topology/" + name);
+    return static_cast<bool>(in >> id);
+}
+
+bool parseEnvInt(const char *name, long minVal, long maxVal, int &out) noexcept {
+    auto valueEnv = std::getenv(name);
+    if (valueEnv == nullptr || *valueEnv == '\0') {
+        return false;
+    }
+    char *end{nullptr};
+    auto val = std::strtol(valueEnv, &end, 10);
+    if (*end != '\0' || val < minVal || val > maxVal) {
+        return false;
+    }
+    out = (int) val;
+    return true;
+}
+
+ExpectedVoid pinCurrentThread(const std::vector<int> &cpus) noexcept {
+    if (cpus.empty()) {
+        return NoErr;
+    }
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    for (auto cpu : cpus) {
+        CPU_SET((size_t) cpu, &set);
+    }
+    if (pthread_setaffinity_np(pthread_self(), sizeof(set), &set) != 0) {
+        return ErrorCode::kThreadPlacementError;
+    }
+    return NoErr;
+}
+
+}
+
+std::ostream &operator<<(std::ostream &os, const ThreadPlacementMode &mode) {
+    switch (mode) {
+        case ThreadPlacementMode::Off:
+            os << "off";
+            break;
+        case ThreadPlacementMode::Pinned:
+            os << "pinned";
+            break;
+    }
+    return os;
+}
+
+ThreadPlacementConfig threadPlacementConfigFromEnv() noexcept {
+    ThreadPlacementConfig config;
+    if (auto modeEnv = std::getenv("THREAD_PLACEMENT"); modeEnv != nullptr) {
+        std::string_view mode{modeEnv};
+        if (mode == "off") {
+            config.mode_ = ThreadPlacementMode::Off;
+        } else if (mode == "pinned") {
+            config.mode_ = ThreadPlacementMode::Pinned;
+        }
+    }
+    parseEnvInt("APP_SCHED_FIFO", 1, 99, config.appFifoPriority_);
+    parseEnvInt("APP_NICE", -20, 19, config.appNice_);
+    return config;
+}
+
+CpuCores detectCpuCores() noexcept {
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    if (sched_getaffinity(0, sizeof(set), &set) != 0) {
+        return {};
+    }
+    CpuCores cores;
+    std::vector<std::pair<int, int>> coreIds;
+    for (int cpu = 0; cpu < CPU_SETSIZE; cpu++) {
+        if (!CPU_ISSET((size_t) cpu, &set)) {
+            continue;
+        }
+        int packageId{0};
+        int coreId{0};
+        if (!readTopologyId(cpu, "physical_package_id", packageId) || !readTopologyId(cpu, "core_id", coreId)) {
+            cores.push_back({cpu});
+            coreIds.emplace_back(-1, cpu);
+            continue;
+        }
+        auto it = std::find(coreIds.begin(), coreIds.end(), std::make_pair(packageId, coreId));
+        if (it == coreIds.end()) {
+            cores.push_back({cpu});
+            coreIds.emplace_back(packageId, coreId);
+        } else {
+            cores[(size_t) (it - coreIds.begin())].push_back(cpu);
+        }
+    }
+    return cores;
+}
+
+ThreadPlacement ThreadPlacement::plan(const CpuCores &cores, size_t appThreadsCnt, ThreadPlacementConfig config,
+                                      size_t processId, size_t processCnt) noexcept {
+    ThreadPlacement ret;
+    ret.config_ = config;
+    for (const auto &core : cores) {
+        ret.allowedCpus_.insert(ret.allowedCpus_.end(), core.begin(), core.end());
+    }
+    std::sort(ret.allowedCpus_.begin(), ret.allowedCpus_.end());
+    if (config.mode_ == ThreadPlacementMode::Off || cores.size() < 2) {
+        return ret;
+    }
+    auto dedicatedCnt = std::min(appThreadsCnt * processCnt, cores.size() - 1);
+    for (auto i = processId * appThreadsCnt; i < std::min((processId + 1) * appThreadsCnt, dedicatedCnt); i++) {
+        ret.appCpus_.push_back(cores[cores.size() - 1 - i].front());
+    }
+    for (size_t i = 0; i < cores.size() - dedicatedCnt; i++) {
+        ret.ioCpus_.insert(ret.ioCpus_.end(), cores[i].begin(), cores[i].end());
+    }
+    std::sort(ret.ioCpus_.begin(), ret.ioCpus_.end());
+    return ret;
+}
+
+std::ostream &operator<<(std::ostream &os, const ThreadPlacement &placement) {
+    auto printCpus = [&os](const std::vector<int> &cpus) {
+        os << "[";
+        for (size_t i = 0; i < cpus.size(); i++) {
+            os << (i > 0 ? "," : "") << cpus[i];
+        }
+        os << "]";
+    };
+    os << placement.config_.mode_ << " app cpus ";
+    printCpus(placement.appCpus_);
+    os << " io cpus ";
+    printCpus(placement.ioCpus_);
+    os << " of ";
+    printCpus(placement.allowedCpus_);
+    os << " app sched fifo " << placement.config_.appFifoPriority_ << " nice " << placement.config_.appNice_;
+    return os;
+}
+
+const ThreadPlacement &threadPlacement() noexcept {
+    return placement;
+}
+
+ExpectedVoid initThreadPlacement(size_t appThreadsCnt, ThreadPlacementConfig config, size_t processId,
+                                 size_t processCnt) noexcept {
+    placement = ThreadPlacement::plan(detectCpuCores(), appThreadsCnt, config, processId, processCnt);
+    return pinCurrentThread(placement.ioCpus_);
+}
+
+ExpectedVoid placeAppThread(size_t shardId) noexcept {
+    auto err = shardId < placement.appCpus_.size() ? pinCurrentThread({placement.appCpus_[shardId]}) : NoErr;
+    if (placement.config_.appFifoPriority_ > 0) {
+        sched_param param{};
+        param.sched_priority = placement.config_.appFifoPriority_;
+        if (pthread_setschedparam(pthread_self(), SCHED_FIFO, &param) != 0) {
+            err = ErrorCode::kThreadPlacementError;
+        }
+    } else if (placement.config_.appNice_ != 0) {
+        // the nice value of a Linux thread is set by its tid
+        auto tid = (id_t) syscall(SYS_gettid);
+        if (setpriority(PRIO_PROCESS, tid, placement.config_.appNice_) != 0) {
+            err = ErrorCode::kThreadPlacementError;
+        }
+    }
+    return err;
+}
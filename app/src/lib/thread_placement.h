@@ -0,0 +1,57 @@
+#ifndef HIGHLOADCUP2021_THREAD_PLACEMENT_H
+#define HIGHLOADCUP2021_THREAD_PLACEMENT_H
+
+#include <cstddef>
+#include <ostream>
+#include <vector>
+#include "const.h"
+#include "error.h"
+
+struct ThreadPlacementConfig {
+    ThreadPlacementMode mode_{kThreadPlacement};
+    int appFifoPriority_{kAppThreadFifoPriority};
+    int appNice_{kAppThreadNice};
+};
+
+std::ostream &operator<<(std::ostream &os, const ThreadPlacementMode &mode);
+
+// Reads THREAD_PLACEMENT: off or pinned, APP_SCHED_FIFO: 1..99 and APP_NICE: -20..19, a missing or bad
+// value keeps the default.
+ThreadPlacementConfig threadPlacementConfigFromEnv() noexcept;
+
+// CPUs the process may run on grouped by physical core, the SMT siblings of a core are together.
+using CpuCores = std::vector<std::vector<int>>;
+
+// sched_getaffinity and the core ids of /sys/devices/system/cpu, a CPU without topology is a core.
+CpuCores detectCpuCores() noexcept;
+
+struct ThreadPlacement {
+    ThreadPlacementConfig config_;
+    std::vector<int> allowedCpus_;
+    // the dedicated CPU of the app thread of each shard, shards past the end run on ioCpus_
+    std::vector<int> appCpus_;
+    // api workers, stats and snapshot writer, empty if the threads are not pinned
+    std::vector<int> ioCpus_;
+
+    // App threads take whole cores from the end while at least one core is left for the other threads,
+    // the SMT siblings of a taken core stay idle. The processes of PROCESS_SHARDS run appThreadsCnt app
+    // threads each and take their cores in the order of processId, the rest of the cores is shared.
+    [[nodiscard]] static ThreadPlacement
+    plan(const CpuCores &cores, size_t appThreadsCnt, ThreadPlacementConfig config, size_t processId = 0,
+         size_t processCnt = 1) noexcept;
+};
+
+std::ostream &operator<<(std::ostream &os, const ThreadPlacement &placement);
+
+// The placement of the process.
+const ThreadPlacement &threadPlacement() noexcept;
+
+// Plans the placement of the process and moves the calling thread to the io CPUs, threads created by it
+// later inherit them. Called before the api workers and the app threads are started.
+[[nodiscard]] ExpectedVoid initThreadPlacement(size_t appThreadsCnt, ThreadPlacementConfig config, size_t processId,
+                                              size_t processCnt) noexcept;
+
+// Moves the calling thread to the CPU of the app thread of the shard and applies its scheduling policy.
+[[nodiscard]] ExpectedVoid placeAppThread(size_t shardId) noexcept;
+
+#endif //HIGHLOADCUP2021_THREAD_PLACEMENT_H
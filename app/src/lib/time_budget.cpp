@@ -0,0 +1,102 @@
+#include "time_budget.h"
+#include <cstdlib>
+#include <cstring>
+
+constexpr int64_t kStageLatencySmoothing = 16;
+
+std::ostream &operator<<(std::ostream &os, const GamePhase &phase) {
+    switch (phase) {
+        case GamePhase::Full:
+            os << "full";
+            break;
+        case GamePhase::NoExplore:
+            os << "no explore";
+            break;
+        case GamePhase::NoLicenses:
+            os << "no licenses";
+            break;
+        case GamePhase::CashOnly:
+            os << "cash only";
+            break;
+    }
+    return os;
+}
+
+std::chrono::milliseconds gameDurationFromEnv() noexcept {
+    auto durationEnv = std::getenv("SERVER_RUN_TIME_IN_SECONDS");
+    if (durationEnv == nullptr) {
+        return std::chrono::milliseconds(kGameDurationMs);
+    }
+    auto seconds = std::strtoll(durationEnv, nullptr, 10);
+    if (seconds <= 0) {
+        return std::chrono::milliseconds(kGameDurationMs);
+    }
+    return std::chrono::seconds(seconds);
+}
+
+bool endGameModeFromEnv() noexcept {
+    auto modeEnv = std::getenv("END_GAME_MODE");
+    if (modeEnv == nullptr) {
+        return kEndGameMode;
+    }
+    if (std::strcmp(modeEnv, "on") == 0) {
+        return true;
+    }
+    if (std::strcmp(modeEnv, "off") == 0) {
+        return false;
+    }
+    return kEndGameMode;
+}
+
+TimeBudget::TimeBudget(GameClock::time_point startedAt, std::chrono::milliseconds gameDuration, bool enabled) noexcept:
+        enabled_{enabled},
+        deadline_{startedAt + gameDuration - std::chrono::milliseconds(kGameDeadlineMarginMs)},
+        gameDuration_{gameDuration} {}
+
+void TimeBudget::rebase(GameClock::time_point startedAt) noexcept {
+    deadline_ = startedAt + gameDuration_ - std::chrono::milliseconds(kGameDeadlineMarginMs);
+}
+
+int64_t TimeBudget::getStageLatencyMcs(PipelineStage stage) const noexcept {
+    auto idx = (size_t) stage;
+    if (stageSamples_[idx] == 0) {
+        return kStageLatencyPriorMs * 1000;
+    }
+    return stageLatencyMcs_[idx];
+}
+
+void TimeBudget::recordStageLatency(PipelineStage stage, std::chrono::microseconds latency) noexcept {
+    auto idx = (size_t) stage;
+    if (stageSamples_[idx] == 0) {
+        stageLatencyMcs_[idx] = latency.count();
+    } else {
+        stageLatencyMcs_[idx] += (latency.count() - stageLatencyMcs_[idx]) / kStageLatencySmoothing;
+    }
+    stageSamples_[idx]++;
+}
+
+bool TimeBudget::update(GameClock::time_point now) noexcept {
+    if (!enabled_ || phase_ == GamePhase::CashOnly) {
+        return false;
+    }
+    auto timeLeftMcs = std::chrono::duration_cast<std::chrono::microseconds>(deadline_ - now).count();
+    auto cash = getStageLatencyMcs(PipelineStage::Cash);
+    auto dig = getStageLatencyMcs(PipelineStage::Dig);
+    auto license = getStageLatencyMcs(PipelineStage::License);
+    auto explore = getStageLatencyMcs(PipelineStage::Explore);
+
+    auto phase = GamePhase::Full;
+    if (timeLeftMcs < dig + cash) {
+        phase = GamePhase::CashOnly;
+    } else if (timeLeftMcs < license + dig + cash) {
+        phase = GamePhase::NoLicenses;
+    } else if (timeLeftMcs < explore + license + kEndGameDigChainLength * dig + cash) {
+        phase = GamePhase::NoExplore;
+    }
+    // stages are never resumed
+    if (phase <= phase_) {
+        return false;
+    }
+    phase_ = phase;
+    return true;
+}
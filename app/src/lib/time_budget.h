@@ -0,0 +1,78 @@
+#ifndef HIGHLOADCUP2021_TIME_BUDGET_H
+#define HIGHLOADCUP2021_TIME_BUDGET_H
+
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <ostream>
+#include "const.h"
+
+using GameClock = std::chrono::steady_clock;
+
+// Stages are phased out in this order as the deadline approaches.
+enum class GamePhase : int {
+    Full = 0,
+    NoExplore = 1,
+    NoLicenses = 2,
+    CashOnly = 3,
+};
+
+std::ostream &operator<<(std::ostream &os, const GamePhase &phase);
+
+enum class PipelineStage : size_t {
+    Explore = 0,
+    License = 1,
+    Dig = 2,
+    Cash = 3,
+};
+
+// Reads SERVER_RUN_TIME_IN_SECONDS (the variable the stub server reads) and falls back to kGameDurationMs.
+std::chrono::milliseconds gameDurationFromEnv() noexcept;
+
+// Reads END_GAME_MODE (on|off) and falls back to kEndGameMode.
+bool endGameModeFromEnv() noexcept;
+
+// Knows the game deadline and phases out stages whose results can not be cashed before it.
+// Each stage latency is a moving average of its responses (kStageLatencyPriorMs until measured).
+// Explore stops when the rest of the game is shorter than explore, license, kEndGameDigChainLength digs
+// and cash in a row, licenses stop when it is shorter than license, dig and cash, digs stop when it is
+// shorter than dig and cash, then only cash requests are drained. kGameDeadlineMarginMs is kept in reserve.
+class TimeBudget {
+    bool enabled_;
+    GameClock::time_point deadline_;
+    std::chrono::milliseconds gameDuration_;
+    std::array<int64_t, 4> stageLatencyMcs_{};
+    std::array<int64_t, 4> stageSamples_{};
+    GamePhase phase_{GamePhase::Full};
+
+public:
+    TimeBudget(GameClock::time_point startedAt, std::chrono::milliseconds gameDuration, bool enabled) noexcept;
+
+    // Moves the deadline for a game that started before the process, e.g. after a warm restart.
+    void rebase(GameClock::time_point startedAt) noexcept;
+
+    void recordStageLatency(PipelineStage stage, std::chrono::microseconds latency) noexcept;
+
+    [[nodiscard]] int64_t getStageLatencyMcs(PipelineStage stage) const noexcept;
+
+    // Returns true when the phase changed.
+    bool update(GameClock::time_point now) noexcept;
+
+    [[nodiscard]] GamePhase getPhase() const noexcept {
+        return phase_;
+    }
+
+    [[nodiscard]] bool allows(GamePhase stopsAt) const noexcept {
+        return phase_ < stopsAt;
+    }
+
+    [[nodiscard]] std::chrono::milliseconds getTimeLeft(GameClock::time_point now) const noexcept {
+        return std::chrono::duration_cast<std::chrono::milliseconds>(deadline_ - now);
+    }
+
+    [[nodiscard]] std::chrono::milliseconds getGameDuration() const noexcept {
+        return gameDuration_;
+    }
+};
+
+#endif //HIGHLOADCUP2021_TIME_BUDGET_H
@@ -1,7 +1,7 @@
 #include "lib/app.h"
 
 int main() {
-    auto app = App::createApp();
-    app->run();
+    auto apps = App::createApps();
+    App::runShards(apps);
     return 0;
 }
@@ -0,0 +1,60 @@
+#include <gtest/gtest.h>
+#include <string>
+#include <unistd.h>
+#include "broker.h"
+
+TEST(BrokerTest, TestLicensePool) {
+    LicensePool pool;
+    ASSERT_FALSE(pool.tryTake());
+    pool.release();
+    pool.release();
+    ASSERT_EQ(2, pool.getSpareSlots());
+    ASSERT_TRUE(pool.tryTake());
+    ASSERT_TRUE(pool.tryTake());
+    ASSERT_FALSE(pool.tryTake());
+}
+
+TEST(BrokerTest, TestRateBudget) {
+    RateBudget budget(10);
+    auto now = BrokerClock::now();
+    ASSERT_EQ(0, budget.tryAcquire(6, now).count());
+    ASSERT_EQ(0, budget.tryAcquire(4, now + std::chrono::milliseconds(100)).count());
+    ASSERT_EQ(900, budget.tryAcquire(1, now + std::chrono::milliseconds(100)).count());
+    // the next window starts with the whole budget
+    ASSERT_EQ(0, budget.tryAcquire(10, now + std::chrono::milliseconds(1000)).count());
+}
+
+TEST(BrokerTest, TestSharedBroker) {
+    auto name = "/highloadcup2021_test_" + std::to_string(getpid());
+    auto first = attachSharedBroker(name, std::chrono::milliseconds(60'000));
+    ASSERT_FALSE(first.hasError());
+    auto second = attachSharedBroker(name, std::chrono::milliseconds(60'000));
+    ASSERT_FALSE(second.hasError());
+
+    // both mappings see one segment
+    ASSERT_TRUE(first.get()->coins_.offer(7));
+    first.get()->licenses_.release();
+    CoinID coin{};
+    ASSERT_TRUE(second.get()->coins_.take(coin));
+    ASSERT_EQ(7u, coin);
+    ASSERT_TRUE(second.get()->licenses_.tryTake());
+}
+
+TEST(BrokerTest, TestProcessShardFromEnv) {
+    unsetenv("PROCESS_SHARDS");
+    unsetenv("PROCESS_SHARD_ID");
+    ASSERT_EQ((std::pair<size_t, size_t>{0, 1}), processShardFromEnv().get());
+
+    setenv("PROCESS_SHARDS", "4", 1);
+    setenv("PROCESS_SHARD_ID", "3", 1);
+    ASSERT_EQ((std::pair<size_t, size_t>{3, 4}), processShardFromEnv().get());
+    setenv("PROCESS_SHARD_ID", "4", 1);
+    ASSERT_EQ(ErrorCode::kConfigError, processShardFromEnv().error());
+
+    // the count is not clamped, the higher ids would get regions outside the field
+    setenv("PROCESS_SHARDS", std::to_string(kProcessMaxShardsCnt + 2).c_str(), 1);
+    setenv("PROCESS_SHARD_ID", std::to_string(kProcessMaxShardsCnt + 1).c_str(), 1);
+    ASSERT_EQ(ErrorCode::kConfigError, processShardFromEnv().error());
+    unsetenv("PROCESS_SHARDS");
+    unsetenv("PROCESS_SHARD_ID");
+}
@@ -0,0 +1,38 @@
+#include <gtest/gtest.h>
+#include "cash_policy.h"
+
+TEST(CashPolicyTest, TestDecide) {
+    CashPolicy policy;
+    ASSERT_EQ(CashDecision::Cash, policy.decide("a", 1, false));
+
+    for (int64_t i = 0; i < kCashPolicyMinSamples; i++) {
+        policy.recordCash(1, 1, 1000);
+        policy.recordCash(5, 10, 1000);
+    }
+    ASSERT_EQ(CashDecision::Cash, policy.decide("b", 5, false));
+    ASSERT_EQ(CashDecision::Cash, policy.decide("c", 1, true));
+    // not measured yet
+    ASSERT_EQ(CashDecision::Cash, policy.decide("d", 3, false));
+    ASSERT_EQ(CashDecision::Defer, policy.decide("e", 1, false));
+    ASSERT_EQ(1u, policy.getDeferredCnt());
+
+    auto deferred = policy.fetchDeferred();
+    ASSERT_TRUE(deferred.has_value());
+    ASSERT_EQ("e", deferred->first);
+    ASSERT_EQ(1, deferred->second);
+    ASSERT_FALSE(policy.fetchDeferred().has_value());
+}
+
+TEST(CashPolicyTest, TestDepthOutOfRange) {
+    CashPolicy policy;
+    for (int64_t i = 0; i < kCashPolicyMinSamples; i++) {
+        policy.recordCash(1, 1, 1000);
+        policy.recordCash(127, 10, 1000);
+    }
+    // depth 127 is counted at the deepest level and depth 0 at the first one
+    ASSERT_EQ(CashDecision::Defer, policy.decide("a", 0, false));
+    ASSERT_EQ(CashDecision::Cash, policy.decide("b", (int8_t) kMaxDigDepth, false));
+    auto deferred = policy.fetchDeferred();
+    ASSERT_TRUE(deferred.has_value());
+    ASSERT_EQ(1, deferred->second);
+}
@@ -0,0 +1,66 @@
+#include <gtest/gtest.h>
+#include "coin_spend_optimizer.h"
+
+// digs per license of the local stub server
+static uint32_t stubDigAllowed(size_t coinsCnt) {
+    if (coinsCnt == 0) {
+        return 3;
+    }
+    if (coinsCnt <= 5) {
+        return 5;
+    }
+    if (coinsCnt <= 10) {
+        return 10;
+    }
+    if (coinsCnt <= 20) {
+        return 25;
+    }
+    return 45;
+}
+
+TEST(CoinSpendOptimizerTest, TestEstimate) {
+    CoinSpendOptimizer optimizer{LicenseClock::now()};
+    ASSERT_DOUBLE_EQ(4.0 * kCoinSpendPriorDigsPerCoin, optimizer.estimateDigs(2));
+
+    optimizer.recordLicense(1, stubDigAllowed(1));
+    optimizer.recordLicense(16, stubDigAllowed(16));
+    ASSERT_DOUBLE_EQ(5.0, optimizer.estimateDigs(0));
+    ASSERT_DOUBLE_EQ(25.0, optimizer.estimateDigs(4));
+    ASSERT_DOUBLE_EQ(5.0 + 20.0 * 7.0 / 15.0, optimizer.estimateDigs(3));
+    ASSERT_DOUBLE_EQ(50.0, optimizer.estimateDigs(5));
+}
+
+TEST(CoinSpendOptimizerTest, TestLicenseCostPerDig) {
+    CoinSpendOptimizer optimizer{LicenseClock::now()};
+    ASSERT_DOUBLE_EQ(1'000.0, optimizer.licenseCostPerDig(1'000.0));
+
+    optimizer.recordLicense(0, stubDigAllowed(0));
+    optimizer.recordLicense(16, stubDigAllowed(16));
+    ASSERT_DOUBLE_EQ(1'000.0 / 14.0, optimizer.licenseCostPerDig(1'000.0));
+}
+
+TEST(CoinSpendOptimizerTest, TestChooseCoinsCount) {
+    auto start = LicenseClock::now();
+    CoinSpendOptimizer optimizer{start};
+    auto now = start + std::chrono::seconds(60);
+    for (int i = 0; i < 100; i++) {
+        optimizer.recordLicense(0, stubDigAllowed(0));
+    }
+    ASSERT_EQ(0u, optimizer.chooseCoinsCount(0, 1000, now));
+    // free licenses cover the backlog
+    ASSERT_EQ(0u, optimizer.chooseCoinsCount(1000, 20, now));
+
+    size_t spent{0};
+    for (int i = 0; i < 100; i++) {
+        auto coins = optimizer.chooseCoinsCount(1000 - spent, 1000, now);
+        spent += coins;
+        if (coins > 0) {
+            optimizer.recordLicense(coins, stubDigAllowed(coins));
+        }
+    }
+    // the balance is spread over the 900 licenses expected till the end of the game
+    ASSERT_GT(spent, 50u);
+    ASSERT_LT(spent, 200u);
+
+    ASSERT_EQ(0u, optimizer.chooseCoinsCount(1000, 1000, start + std::chrono::milliseconds(kGameDurationMs)));
+}
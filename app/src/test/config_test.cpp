@@ -0,0 +1,62 @@
+#include <gtest/gtest.h>
+#include <string>
+#include "config.h"
+
+TEST(ConfigTest, TestApplyConfigText) {
+    RuntimeConfig config;
+    ASSERT_EQ(kApiThreadCount, config.apiThreadCount_);
+    ASSERT_EQ(kExploreAreas.size(), config.exploreAreasCnt_);
+    ASSERT_EQ(kExploreAreas[1].height, config.getExploreAreaShift(1).height);
+
+    std::string badLine;
+    ASSERT_FALSE(applyConfigText(config, "# tuning\n"
+                                         "API_THREADS=64\n"
+                                         "\n"
+                                         " CASH_RATIO = 0.25\r\n"
+                                         "REQUEST_TIMEOUT_MS=500\n"
+                                         "EXPLORE_AREAS=3500x1, 100x1,1x1", badLine).hasError());
+    ASSERT_EQ(64u, config.apiThreadCount_);
+    ASSERT_DOUBLE_EQ(0.25, config.cashPolicyCashRatio_);
+    ASSERT_EQ(500, config.requestTimeoutMs_);
+    ASSERT_EQ(3u, config.exploreAreasCnt_);
+    ASSERT_EQ(100, config.getExploreAreaShift(1).height);
+    // the last split repeats
+    ASSERT_EQ(1, config.getExploreAreaShift(10).height);
+
+    ASSERT_TRUE(applyConfigText(config, "MAX_LICENSES=11", badLine).hasError());
+    ASSERT_EQ("MAX_LICENSES=11", badLine);
+    ASSERT_TRUE(applyConfigText(config, "CASH_RATIO=high", badLine).hasError());
+    ASSERT_TRUE(applyConfigText(config, "EXPLORE_AREAS=10x0", badLine).hasError());
+    ASSERT_TRUE(applyConfigText(config, "UNKNOWN=1", badLine).hasError());
+    ASSERT_TRUE(applyConfigText(config, "API_THREADS", badLine).hasError());
+    ASSERT_EQ(kMaxLicensesCount, config.maxLicensesCount_);
+    ASSERT_EQ(3u, config.exploreAreasCnt_);
+}
+
+TEST(ConfigTest, TestStoreKeepsStartupValues) {
+    RuntimeConfigStore store;
+    const auto &defaults = store.get();
+    ASSERT_EQ(0u, defaults.version_);
+
+    RuntimeConfig startup;
+    startup.apiThreadCount_ = 20;
+    startup.exploreConcurrentRequestsCnt_ = 5;
+    ASSERT_EQ(1u, store.publish(startup).version_);
+    ASSERT_EQ(20u, store.get().apiThreadCount_);
+
+    RuntimeConfig reloaded;
+    reloaded.apiThreadCount_ = 30;
+    reloaded.exploreConcurrentRequestsCnt_ = 7;
+    store.publish(reloaded);
+    ASSERT_EQ(2u, store.get().version_);
+    ASSERT_EQ(20u, store.get().apiThreadCount_);
+    ASSERT_EQ(7u, store.get().exploreConcurrentRequestsCnt_);
+    ASSERT_EQ(1, store.getReloadsCnt());
+    // older versions stay valid for readers that still hold them
+    ASSERT_EQ(0u, defaults.version_);
+
+    ASSERT_FALSE(store.takeReloadRequest());
+    store.requestReload();
+    ASSERT_TRUE(store.takeReloadRequest());
+    ASSERT_FALSE(store.takeReloadRequest());
+}
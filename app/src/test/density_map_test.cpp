@@ -0,0 +1,52 @@
+#include <gtest/gtest.h>
+#include <cstdio>
+#include "density_map.h"
+
+TEST(DensityMapTest, TestSaveLoadPrior) {
+    auto path = testing::TempDir() + "density_map_test.txt";
+
+    DensityMap observed;
+    ASSERT_FALSE(observed.hasPrior());
+    observed.recordExploredArea(Area(0, 0, 1, 1), 3);
+    observed.recordExploredArea(Area(0, 1, 174, 1), 0);
+    observed.recordExploredArea(Area(175, 0, 175, 175), 0);
+    ASSERT_FALSE(observed.save(path).hasError());
+
+    DensityMap prior;
+    ASSERT_FALSE(prior.load(path).hasError());
+    ASSERT_TRUE(prior.hasPrior());
+    ASSERT_NEAR(3.0 / 175.0, prior.getPriorExpectedTreasuriesCnt(Area(0, 0, 1, 1)), 1e-9);
+    ASSERT_NEAR(0.0, prior.getPriorExpectedTreasuriesCnt(Area(175, 0, 10, 10)), 1e-9);
+
+    prior.recordExploredArea(Area(0, 0, 1, 1), 1);
+    prior.recordExploredArea(Area(175, 0, 1, 1), 1);
+    ASSERT_GT(prior.getPriorMismatch(), 0.0);
+
+    DensityMap missing;
+    ASSERT_TRUE(missing.load(path + ".missing").hasError());
+}
+
+TEST(DensityMapTest, TestWriter) {
+    auto path = testing::TempDir() + "density_map_writer_test.txt";
+    std::remove(path.c_str());
+
+    DensityMap observed;
+    observed.recordExploredArea(Area(0, 0, 1, 1), 3);
+    int savesCnt{0};
+    {
+        DensityMapWriter writer;
+        ASSERT_FALSE(writer.submit(observed));
+        writer.start(path, [&savesCnt](int64_t, ErrorCode err) {
+            ASSERT_EQ(ErrorCode::kNoErr, err);
+            savesCnt++;
+        });
+        ASSERT_TRUE(writer.submit(observed));
+        writer.flush();
+    }
+    ASSERT_EQ(1, savesCnt);
+
+    DensityMap prior;
+    ASSERT_FALSE(prior.load(path).hasError());
+    ASSERT_TRUE(prior.hasPrior());
+    ASSERT_GT(prior.getPriorExpectedTreasuriesCnt(Area(0, 0, 1, 1)), 0.0);
+}
@@ -0,0 +1,52 @@
+#include <gtest/gtest.h>
+#include "dig_scheduler.h"
+
+TEST(DigSchedulerTest, TestOrder) {
+    DigScheduler scheduler;
+    ASSERT_TRUE(scheduler.empty());
+    scheduler.push({1, 1, 1}, 1);
+    scheduler.push({2, 2, 1}, 5);
+    scheduler.push({3, 3, 10}, 1);
+    scheduler.push({4, 4, 1}, 5);
+    ASSERT_EQ(4u, scheduler.size());
+
+    // the last depth holds all treasures left in the cell
+    ASSERT_DOUBLE_EQ(1.0, scheduler.getExpectedTreasuresPerDig(10, 1));
+    ASSERT_DOUBLE_EQ(0.5, scheduler.getExpectedTreasuresPerDig(1, 5));
+    auto r = scheduler.pop();
+    ASSERT_EQ(3, r.x_);
+    r = scheduler.pop();
+    ASSERT_EQ(2, r.x_);
+    r = scheduler.pop();
+    ASSERT_EQ(4, r.x_);
+
+    // the freed node is reused
+    scheduler.push({5, 5, 2}, 2);
+    ASSERT_EQ(5, scheduler.pop().x_);
+    ASSERT_EQ(1, scheduler.pop().x_);
+    ASSERT_TRUE(scheduler.empty());
+}
+
+TEST(DigSchedulerTest, TestObservedDepths) {
+    DigScheduler scheduler;
+    for (int8_t depth = 1; depth <= (int8_t) kMaxDigDepth; depth++) {
+        scheduler.recordFoundTreasures(depth, depth == 1 ? 0 : 100);
+    }
+    scheduler.push({1, 1, 1}, 3);
+    scheduler.push({2, 2, 2}, 3);
+    ASSERT_LT(scheduler.getExpectedTreasuresPerDig(1, 3), scheduler.getExpectedTreasuresPerDig(2, 3));
+    ASSERT_EQ(2, scheduler.pop().x_);
+    ASSERT_EQ(1, scheduler.pop().x_);
+}
+
+TEST(DigSchedulerTest, TestDepthOutOfRange) {
+    DigScheduler scheduler;
+    scheduler.recordFoundTreasures((int8_t) (kMaxDigDepth + 1), 5);
+    scheduler.push({1, 1, (int8_t) (kMaxDigDepth + 1)}, 1);
+    scheduler.push({2, 2, 0}, 1);
+    ASSERT_DOUBLE_EQ(scheduler.getExpectedTreasuresPerDig((int8_t) kMaxDigDepth, 1),
+                     scheduler.getExpectedTreasuresPerDig((int8_t) (kMaxDigDepth + 1), 1));
+    ASSERT_EQ(1, scheduler.pop().x_);
+    ASSERT_EQ(2, scheduler.pop().x_);
+    ASSERT_TRUE(scheduler.empty());
+}
@@ -0,0 +1,30 @@
+#include <gtest/gtest.h>
+#include "explore_controller.h"
+
+TEST(ExploreControllerTest, TestBand) {
+    ExploreController controller;
+    auto now = std::chrono::steady_clock::now();
+    ASSERT_EQ(kExploreConcurrentRequestsCnt, controller.getConcurrency());
+
+    // digs are starving
+    ASSERT_TRUE(controller.update(now, 0, 100.0));
+    ASSERT_DOUBLE_EQ(200.0, controller.getSetpoint());
+    ASSERT_GT(controller.getConcurrency(), kExploreConcurrentRequestsCnt);
+    ASSERT_FALSE(controller.update(now, 0, 100.0));
+
+    // inside the band the output holds
+    auto step = std::chrono::milliseconds(kExploreControllerPeriodMs);
+    now += step;
+    ASSERT_TRUE(controller.update(now, 200, 100.0));
+    auto held = controller.getConcurrency();
+    now += step;
+    ASSERT_TRUE(controller.update(now, 220, 100.0));
+    ASSERT_EQ(held, controller.getConcurrency());
+
+    // the backlog exceeds what the licenses absorb
+    for (int i = 0; i < 100; i++) {
+        now += step;
+        ASSERT_TRUE(controller.update(now, 10'000, 100.0));
+    }
+    ASSERT_EQ(kExploreControllerMinConcurrency, controller.getConcurrency());
+}
@@ -0,0 +1,93 @@
+#include <gtest/gtest.h>
+#include "explore_inference.h"
+
+namespace {
+std::vector<ExploreAreaPtr> createChildren(const ExploreAreaPtr &parent, int16_t cnt) {
+    std::vector<ExploreAreaPtr> children;
+    for (int16_t i = 0; i < cnt; i++) {
+        auto child = ExploreArea::NewExploreArea(parent, Area(i, 0, 1, 1), 1, 0);
+        parent->addChild(child);
+        children.push_back(child);
+    }
+    return children;
+}
+
+void markExplored(const ExploreAreaPtr &child, size_t cnt) {
+    child->actualTreasuriesCnt_ = cnt;
+    child->explored_ = true;
+    child->getParent()->updateChildExplored(child);
+}
+}
+
+TEST(ExploreInferenceTest, TestLastChild) {
+    ExploreInference inference;
+    auto parent = ExploreArea::NewExploreArea(nullptr, Area(0, 0, 3, 1), 0, 5);
+    auto children = createChildren(parent, 3);
+    markExplored(children[0], 2);
+    markExplored(children[1], 1);
+
+    std::vector<InferredArea> inferred;
+    inference.derive(parent, inferred);
+    ASSERT_EQ(1u, inferred.size());
+    ASSERT_EQ(children[2], inferred[0].first);
+    ASSERT_EQ(2u, inferred[0].second);
+}
+
+TEST(ExploreInferenceTest, TestZeroUnionPrunesSiblings) {
+    ExploreInference inference;
+    auto parent = ExploreArea::NewExploreArea(nullptr, Area(0, 0, 5, 1), 0, 3);
+    auto children = createChildren(parent, 5);
+    inference.addConstraint(parent, {children[0], children[1], children[2]}, 0);
+
+    std::vector<InferredArea> inferred;
+    inference.derive(parent, inferred);
+    ASSERT_EQ(3u, inferred.size());
+    for (const auto &[area, cnt] : inferred) {
+        ASSERT_EQ(0u, cnt);
+    }
+    ASSERT_EQ(3u, inference.query(parent, {children[3], children[4]}).value());
+    ASSERT_FALSE(inference.query(parent, {children[3]}).has_value());
+}
+
+TEST(ExploreInferenceTest, TestSubsetDifference) {
+    ExploreInference inference;
+    auto parent = ExploreArea::NewExploreArea(nullptr, Area(0, 0, 4, 1), 0, 6);
+    auto children = createChildren(parent, 4);
+    inference.addConstraint(parent, {children[0], children[1]}, 4);
+    markExplored(children[0], 1);
+
+    std::vector<InferredArea> inferred;
+    inference.derive(parent, inferred);
+    ASSERT_EQ(1u, inferred.size());
+    ASSERT_EQ(children[1], inferred[0].first);
+    ASSERT_EQ(3u, inferred[0].second);
+    ASSERT_EQ(2u, inference.query(parent, {children[2], children[3]}).value());
+}
+
+TEST(ExploreInferenceTest, TestExploredChildrenHoldAllTreasures) {
+    ExploreInference inference;
+    auto parent = ExploreArea::NewExploreArea(nullptr, Area(0, 0, 4, 1), 0, 2);
+    auto children = createChildren(parent, 4);
+    markExplored(children[1], 2);
+
+    std::vector<InferredArea> inferred;
+    inference.derive(parent, inferred);
+    ASSERT_EQ(3u, inferred.size());
+    for (const auto &[area, cnt] : inferred) {
+        ASSERT_NE(children[1], area);
+        ASSERT_EQ(0u, cnt);
+    }
+
+    // the same through the solver once a union constraint is known
+    auto other = ExploreArea::NewExploreArea(nullptr, Area(0, 0, 4, 1), 0, 3);
+    auto otherChildren = createChildren(other, 4);
+    inference.addConstraint(other, {otherChildren[0], otherChildren[1]}, 1);
+    markExplored(otherChildren[2], 2);
+    markExplored(otherChildren[0], 1);
+    inferred.clear();
+    inference.derive(other, inferred);
+    ASSERT_EQ(2u, inferred.size());
+    for (const auto &[area, cnt] : inferred) {
+        ASSERT_EQ(0u, cnt);
+    }
+}
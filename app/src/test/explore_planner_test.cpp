@@ -0,0 +1,69 @@
+#include <gtest/gtest.h>
+#include "explore_planner.h"
+
+TEST(ExplorePlannerTest, TestStaticModeUsesTable) {
+    ExplorePlanner planner(ExploreSplitMode::Static, ExplorePartitionScheme::Strips);
+    auto root = ExploreArea::NewExploreArea(nullptr, Area(0, 0, kFieldMaxX, kFieldMaxY), 0, kTreasuriesCount);
+    auto shift = planner.plan(*root);
+    ASSERT_EQ(kExploreAreas[0].height, shift.height);
+    ASSERT_EQ(kExploreAreas[0].width, shift.width);
+}
+
+TEST(ExplorePlannerTest, TestAdaptiveModeTilesParent) {
+    ExplorePlanner planner(ExploreSplitMode::Adaptive, ExplorePartitionScheme::Strips);
+    auto area = ExploreArea::NewExploreArea(nullptr, Area(0, 0, 3500, 1), 1, 140);
+    auto shift = planner.plan(*area);
+    ASSERT_GE(shift.height, 1);
+    ASSERT_LT(shift.height, 3500);
+    ASSERT_EQ(1, shift.width);
+
+    auto column = ExploreArea::NewExploreArea(nullptr, Area(0, 0, 1, 16), 1, 1);
+    shift = planner.plan(*column);
+    ASSERT_EQ(1, shift.height);
+    ASSERT_LT(shift.width, 16);
+}
+
+TEST(ExplorePlannerTest, TestExpectedCostGrowsWithTreasuries) {
+    ExplorePlanner planner(ExploreSplitMode::Adaptive, ExplorePartitionScheme::Strips);
+    ASSERT_LT(planner.getExpectedCost(1024, 1), planner.getExpectedCost(1024, 8));
+    ASSERT_LT(planner.getExpectedCost(64, 2), planner.getExpectedCost(4096, 2));
+    ASSERT_DOUBLE_EQ(0.0, planner.getExpectedCost(1024, 0));
+}
+
+TEST(ExplorePlannerTest, TestTwoDimensionalSchemes) {
+    auto area = ExploreArea::NewExploreArea(nullptr, Area(0, 0, 64, 64), 1, 16);
+
+    ExplorePlanner quadtree(ExploreSplitMode::Static, ExplorePartitionScheme::Quadtree);
+    auto shift = quadtree.plan(*area);
+    ASSERT_EQ(32, shift.height);
+    ASSERT_EQ(32, shift.width);
+
+    ExplorePlanner grid(ExploreSplitMode::Adaptive, ExplorePartitionScheme::Grid);
+    shift = grid.plan(*area);
+    ASSERT_GT(shift.height, 1);
+    ASSERT_GT(shift.width, 1);
+    ASSERT_LE(std::abs(shift.height - shift.width), 1);
+
+    auto cell = ExploreArea::NewExploreArea(nullptr, Area(0, 0, 2, 1), 1, 1);
+    shift = grid.plan(*cell);
+    ASSERT_EQ(1, shift.height);
+    ASSERT_EQ(1, shift.width);
+}
+
+TEST(ExplorePlannerTest, TestSiblingUnion) {
+    ExplorePlanner planner(ExploreSplitMode::Static, ExplorePartitionScheme::Strips);
+    auto parent = ExploreArea::NewExploreArea(nullptr, Area(0, 0, 1, 64), 1, 1);
+    for (int i = 0; i < 64; i += 4) {
+        parent->addChild(ExploreArea::NewExploreArea(parent, Area(0, (int16_t) i, 1, 4), 2, 0));
+    }
+    auto first = parent->children_[0];
+    first->requestInFlight_ = true;
+    auto siblings = parent->getAdjacentChildrenForRequest(first, kExploreSiblingUnionMaxMembers);
+    ASSERT_EQ(kExploreSiblingUnionMaxMembers, siblings.size());
+    for (size_t i = 1; i < siblings.size(); i++) {
+        ASSERT_EQ(siblings[i - 1]->area_.posY_ + 4, siblings[i]->area_.posY_);
+    }
+
+    ASSERT_GT(planner.planSiblingUnion(siblings, 0.001), 1u);
+    ASSERT_EQ(1u, planner.planSiblingUnion(siblings, 2.0));
+}
@@ -0,0 +1,86 @@
+#include <gtest/gtest.h>
+#include <string>
+#include "json_schema.h"
+
+TEST(JsonSchemaTest, TestExploreResponse) {
+    ExploreResponse resp(Area(), 0);
+    ASSERT_TRUE(decodeJson(R"({"area":{"posX":12,"posY":3400,"sizeX":1,"sizeY":20},"amount":7})", resp));
+    ASSERT_EQ(12, resp.area_.posX_);
+    ASSERT_EQ(3400, resp.area_.posY_);
+    ASSERT_EQ(1, resp.area_.sizeX_);
+    ASSERT_EQ(20, resp.area_.sizeY_);
+    ASSERT_EQ(7u, resp.amount_);
+
+    // field order and spaces are free
+    ASSERT_TRUE(decodeJson(R"( { "amount" : 1, "area" : {"sizeY":1,"sizeX":2,"posY":3,"posX":4} } )", resp));
+    ASSERT_EQ(1u, resp.amount_);
+    ASSERT_EQ(4, resp.area_.posX_);
+
+    ASSERT_FALSE(decodeJson(R"({"area":{"posX":1,"posY":1,"sizeX":1},"amount":1})", resp));
+    ASSERT_FALSE(decodeJson(R"({"area":{"posX":1,"posY":1,"sizeX":1,"sizeY":1},"amount":-1})", resp));
+    ASSERT_FALSE(decodeJson(R"({"area":{"posX":40000,"posY":1,"sizeX":1,"sizeY":1},"amount":1})", resp));
+    ASSERT_FALSE(decodeJson(R"({"area":{"posX":1,"posY":1,"sizeX":1,"sizeY":1},"amount":1)", resp));
+    ASSERT_FALSE(decodeJson(R"({"area":{"posX":1,"posY":1,"sizeX":1,"sizeY":1},"amount":1}x)", resp));
+}
+
+TEST(JsonSchemaTest, TestLicense) {
+    License license;
+    ASSERT_TRUE(decodeJson(R"({"id":123456,"digAllowed":3,"digUsed":0})", license));
+    ASSERT_EQ(123456, license.id_);
+    ASSERT_EQ(3u, license.digAllowed_);
+    ASSERT_EQ(0u, license.digUsed_);
+    ASSERT_FALSE(decodeJson(R"({"id":1,"digAllowed":3,"digUsed":0,"extra":1})", license));
+}
+
+TEST(JsonSchemaTest, TestWallet) {
+    Wallet wallet;
+    ASSERT_TRUE(decodeJson("[]", wallet));
+    ASSERT_TRUE(wallet.coins.empty());
+    // long enough for the 16 bytes scan
+    ASSERT_TRUE(decodeJson("[1, 2, 4294967295, 100000]", wallet));
+    ASSERT_EQ(decltype(wallet.coins)({1, 2, 4294967295u, 100000}), wallet.coins);
+    ASSERT_FALSE(decodeJson("[1,2,]", wallet));
+    ASSERT_FALSE(decodeJson("[4294967296]", wallet));
+    ASSERT_FALSE(decodeJson("[12345678901234567890123]", wallet));
+}
+
+TEST(JsonSchemaTest, TestTreasuriesList) {
+    Treasuries treasuries;
+    ASSERT_TRUE(decodeJson(R"(["AbCdEfGhIjKlMnOpQrStUvWxYz0123456789", "b"])", treasuries));
+    ASSERT_EQ(Treasuries({"AbCdEfGhIjKlMnOpQrStUvWxYz0123456789", "b"}), treasuries);
+    ASSERT_FALSE(decodeJson("[\"" + std::string(kTreasureIdCap + 1, 'a') + "\"]", treasuries));
+    ASSERT_FALSE(decodeJson(R"(["a\"b"])", treasuries));
+    ASSERT_FALSE(decodeJson(R"(["a)", treasuries));
+}
+
+TEST(JsonSchemaTest, TestApiError) {
+    ApiError apiError(ApiErrorCodeUnknown, "");
+    ASSERT_TRUE(decodeJson(R"({"code":1002,"message":"no more active licenses allowed"})", apiError));
+    ASSERT_EQ(1002, apiError.errorCode_);
+    ASSERT_EQ("no more active licenses allowed", apiError.message_);
+    ASSERT_FALSE(decodeJson(R"({"code":1002})", apiError));
+}
+
+TEST(JsonSchemaTest, TestEncode) {
+    std::string buffer;
+    encodeJson(Area(1, 2, 3, 4), buffer);
+    ASSERT_EQ(R"({"posX":1,"posY":2,"sizeX":3,"sizeY":4})", buffer);
+    encodeJson(DigRequest(7, 10, -1, 3), buffer);
+    ASSERT_EQ(R"({"licenseID":7,"posX":10,"posY":-1,"depth":3})", buffer);
+    encodeJson(Wallet{}, buffer);
+    ASSERT_EQ("[]", buffer);
+    encodeJson(Wallet{{1, 22, 333}}, buffer);
+    ASSERT_EQ("[1,22,333]", buffer);
+    encodeJson(TreasureID("abc"), buffer);
+    ASSERT_EQ(R"("abc")", buffer);
+}
+
+TEST(JsonSchemaTest, TestRoundTrip) {
+    std::string buffer;
+    encodeJson(ExploreResponse(Area(3499, 0, 1, 3500), 42), buffer);
+    ExploreResponse resp(Area(), 0);
+    ASSERT_TRUE(decodeJson(buffer, resp));
+    ASSERT_EQ(3499, resp.area_.posX_);
+    ASSERT_EQ(3500, resp.area_.sizeY_);
+    ASSERT_EQ(42u, resp.amount_);
+}
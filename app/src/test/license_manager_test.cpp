@@ -0,0 +1,81 @@
+#include <gtest/gtest.h>
+#include "license_manager.h"
+
+TEST(LicenseManagerTest, TestLookupAndRelease) {
+    LicenseManager manager;
+    auto now = LicenseClock::now();
+    for (int32_t id = 1; id <= (int32_t) kMaxLicensesCount; id++) {
+        ASSERT_FALSE(manager.addLicense(License(id * 64, 1, 0), now).hasError());
+    }
+    ASSERT_EQ((int) kMaxLicensesCount, manager.getInUseLicensesCount());
+    ASSERT_EQ((int64_t) kMaxLicensesCount, manager.getAvailableDigsCount());
+    ASSERT_EQ(nullptr, manager.getLicenseById(7));
+
+    for (size_t i = 0; i < kMaxLicensesCount; i++) {
+        ASSERT_FALSE(manager.reserveAvailableLicenseId(now).hasError());
+    }
+    ASSERT_FALSE(manager.hasAvailableLicense());
+    ASSERT_EQ(0, manager.getAvailableDigsCount());
+
+    // ids share a bucket, so releasing one must keep the rest reachable
+    ASSERT_EQ(1, manager.confirmDig(64, now).get());
+    ASSERT_EQ(nullptr, manager.getLicenseById(64));
+    for (int32_t id = 2; id <= (int32_t) kMaxLicensesCount; id++) {
+        ASSERT_NE(nullptr, manager.getLicenseById(id * 64));
+    }
+    ASSERT_EQ(ErrorCode::kLicenseNotFound, manager.confirmDig(64, now).error());
+
+    auto idle = manager.addLicense(License(5, 1, 0), now + std::chrono::milliseconds(3));
+    ASSERT_EQ(std::chrono::microseconds(3000), idle.get());
+}
+
+TEST(LicenseManagerTest, TestEarlyReplacement) {
+    LicenseManager manager;
+    auto now = LicenseClock::now();
+    ASSERT_EQ(0, manager.fetchDueReplacements(now));
+
+    for (int64_t i = 0; i < kLicenseEarlyIssueMinSamples; i++) {
+        ASSERT_FALSE(manager.addLicense(License((int32_t) i, 1, 0), now).hasError());
+        ASSERT_FALSE(manager.reserveAvailableLicenseId(now).hasError());
+        ASSERT_EQ(1, manager.confirmDig((int32_t) i, now + std::chrono::milliseconds(10)).get());
+        manager.recordIssueLatency(std::chrono::milliseconds(8));
+    }
+
+    ASSERT_FALSE(manager.addLicense(License(100, 1, 0), now).hasError());
+    ASSERT_FALSE(manager.reserveAvailableLicenseId(now).hasError());
+    ASSERT_EQ(0, manager.fetchDueReplacements(now + std::chrono::milliseconds(5)));
+    ASSERT_EQ(1, manager.fetchDueReplacements(now + std::chrono::milliseconds(6)));
+    ASSERT_EQ(0, manager.fetchDueReplacements(now + std::chrono::milliseconds(7)));
+
+    // the replacement is already requested, a deferred issue is repeated on release
+    ASSERT_TRUE(manager.deferIssue(now + std::chrono::milliseconds(8)));
+    ASSERT_EQ(1, manager.confirmDig(100, now + std::chrono::milliseconds(10)).get());
+}
+
+TEST(LicenseManagerTest, TestRejectedAfterLastConfirmation) {
+    LicenseManager manager;
+    auto now = LicenseClock::now();
+    for (int64_t i = 0; i < kLicenseEarlyIssueMinSamples; i++) {
+        ASSERT_FALSE(manager.addLicense(License((int32_t) i, 1, 0), now).hasError());
+        ASSERT_FALSE(manager.reserveAvailableLicenseId(now).hasError());
+        ASSERT_EQ(1, manager.confirmDig((int32_t) i, now + std::chrono::milliseconds(10)).get());
+        manager.recordIssueLatency(std::chrono::milliseconds(8));
+    }
+
+    // the last license of the shard is replaced early
+    ASSERT_FALSE(manager.addLicense(License(100, 1, 0), now).hasError());
+    ASSERT_FALSE(manager.reserveAvailableLicenseId(now).hasError());
+    ASSERT_EQ(1, manager.fetchDueReplacements(now + std::chrono::milliseconds(6)));
+    // its last dig is confirmed before the server rejects the replacement
+    ASSERT_EQ(0, manager.confirmDig(100, now + std::chrono::milliseconds(7)).get());
+    ASSERT_EQ(0, manager.getInUseLicensesCount());
+    ASSERT_FALSE(manager.deferIssue(now + std::chrono::milliseconds(8)));
+
+    ASSERT_EQ(0, manager.fetchDueRetries(now + std::chrono::milliseconds(8)));
+    ASSERT_EQ(1, manager.fetchDueRetries(now + std::chrono::milliseconds(8 + kLicenseRetryBackoffMinMs)));
+    ASSERT_EQ(0, manager.fetchDueRetries(now + std::chrono::milliseconds(20)));
+
+    // the slot was idle from the release, not from the reservation of the last dig
+    auto idle = manager.addLicense(License(101, 1, 0), now + std::chrono::milliseconds(12));
+    ASSERT_EQ(std::chrono::microseconds(5000), idle.get());
+}
@@ -0,0 +1,62 @@
+#include <gtest/gtest.h>
+#include <cstring>
+#include "memory.h"
+#include "state.h"
+
+TEST(MemoryTest, TestArenaReusesBlocks) {
+    Arena arena(kHugePageSize * 4, HugePagesMode::Off);
+    ASSERT_EQ(kHugePageSize * 4, arena.getCapacity());
+    ASSERT_EQ(HugePagesMode::Off, arena.getMode());
+
+    auto small = arena.allocate(40);
+    ASSERT_NE(nullptr, small);
+    ASSERT_TRUE(arena.owns(small));
+    ASSERT_EQ(0u, reinterpret_cast<uintptr_t>(small) % 16);
+    ASSERT_EQ(48u, arena.getLiveBytes());
+    arena.deallocate(small, 40);
+    ASSERT_EQ(0u, arena.getLiveBytes());
+    // the same size class takes the freed block
+    ASSERT_EQ(small, arena.allocate(33));
+
+    auto large = arena.allocate(kHugePageSize);
+    ASSERT_NE(nullptr, large);
+    ASSERT_EQ(0u, (reinterpret_cast<uintptr_t>(large) - reinterpret_cast<uintptr_t>(small)) % kHugePageSize);
+    std::memset(large, 1, kHugePageSize);
+    ASSERT_GE(arena.getResidentBytes(), kHugePageSize);
+    arena.deallocate(large, kHugePageSize);
+    ASSERT_EQ(large, arena.allocate(kHugePageSize));
+
+    // an exhausted arena leaves the allocation to the heap
+    ASSERT_EQ(nullptr, arena.allocate(kHugePageSize * 3));
+    int x{0};
+    ASSERT_FALSE(arena.owns(&x));
+}
+
+TEST(MemoryTest, TestExploreTreeArena) {
+    auto &arena = memoryArena(MemoryArenaId::ExploreTree);
+    auto liveBytes = arena.getLiveBytes();
+    {
+        auto root = ExploreArea::NewExploreArea(nullptr, Area(0, 0, 10, 10), 0, 5);
+        ASSERT_TRUE(arena.owns(root.get()));
+        ExploreQueue queue;
+        queue.insert(root);
+        queue.insert(ExploreArea::NewExploreArea(root, Area(0, 0, 5, 10), 1, 0));
+        ASSERT_EQ(2u, queue.size());
+        ASSERT_GT(arena.getLiveBytes(), liveBytes);
+    }
+    ASSERT_EQ(liveBytes, arena.getLiveBytes());
+
+    auto grid = makeArenaUnique<CellGrid, MemoryArenaId::StateGrid>();
+    ASSERT_TRUE(memoryArena(MemoryArenaId::StateGrid).owns(grid.get()));
+    ASSERT_EQ(0, (*grid)[kFieldMaxX - 1][kFieldMaxY - 1].left_);
+}
+
+TEST(MemoryTest, TestStateGridArenaFitsShards) {
+    // a grid is larger than a huge page, so each one starts at a huge page boundary
+    Arena arena(Arena::getBlockSpan(sizeof(CellGrid)) * 2, HugePagesMode::Off);
+    auto first = arena.allocate(sizeof(CellGrid));
+    auto second = arena.allocate(sizeof(CellGrid));
+    ASSERT_TRUE(arena.owns(first));
+    ASSERT_TRUE(arena.owns(second));
+    ASSERT_EQ(nullptr, arena.allocate(sizeof(CellGrid)));
+}
@@ -0,0 +1,65 @@
+#include <gtest/gtest.h>
+#include <chrono>
+#include "api.h"
+
+namespace {
+
+struct RecordingHandler {
+    int treasuriesCalls_{0};
+    int walletCalls_{0};
+    const Wallet *wallet_{nullptr};
+
+    template<class T>
+    ExpectedVoid processResponse(Request &, HttpResponse<T> &) noexcept {
+        return ErrorCode::kUnknownRequestType;
+    }
+
+    ExpectedVoid processResponse(Request &, HttpResponse<Treasuries> &resp) noexcept {
+        treasuriesCalls_++;
+        EXPECT_EQ(1u, resp.getResponse().size());
+        return NoErr;
+    }
+
+    ExpectedVoid processResponse(Request &req, HttpResponse<Wallet> &resp) noexcept {
+        walletCalls_++;
+        EXPECT_EQ(ApiEndpointType::Cash, req.type_);
+        wallet_ = &resp.getResponse();
+        return NoErr;
+    }
+};
+
+}
+
+TEST(ResponseDispatchTest, TestBoundHandler) {
+    RecordingHandler handler;
+
+    Response dig(Request::NewDigRequest(DigRequest(1, 2, 3, 4)),
+                 ApiResult<Treasuries>(HttpResponse<Treasuries>(Treasuries{"treasure"}, 200,
+                                                                std::chrono::microseconds(10))));
+    ASSERT_FALSE(dig.dispatch(handler).hasError());
+    ASSERT_EQ(1, handler.treasuriesCalls_);
+    ASSERT_EQ(0, handler.walletCalls_);
+
+    Wallet wallet;
+    wallet.coins.push_back(7);
+    Response cash(Request::NewCashRequest("treasure", 1),
+                  ApiResult<Wallet>(HttpResponse<Wallet>(std::move(wallet), 200, std::chrono::microseconds(10))));
+    ASSERT_FALSE(cash.dispatch(handler).hasError());
+    ASSERT_EQ(1, handler.walletCalls_);
+    ASSERT_NE(nullptr, handler.wallet_);
+    ASSERT_EQ(7u, handler.wallet_->coins[0]);
+    // the handler gets the stored result, not a copy of it
+    auto stored = handler.wallet_;
+    ASSERT_FALSE(cash.dispatch(handler).hasError());
+    ASSERT_EQ(2, handler.walletCalls_);
+    ASSERT_EQ(stored, handler.wallet_);
+}
+
+TEST(ResponseDispatchTest, TestTransportErrorSkipsHandler) {
+    RecordingHandler handler;
+    Response dig(Request::NewDigRequest(DigRequest(1, 2, 3, 4)), ApiResult<Treasuries>(ErrorCode::kErrCurlTimeout));
+    auto err = dig.dispatch(handler);
+    ASSERT_TRUE(err.hasError());
+    ASSERT_EQ(ErrorCode::kErrCurlTimeout, err.error());
+    ASSERT_EQ(0, handler.treasuriesCalls_);
+}
@@ -0,0 +1,86 @@
+#include <gtest/gtest.h>
+#include <thread>
+#include <vector>
+#include "shard.h"
+
+TEST(ShardTest, TestSplit) {
+    auto single = ShardConfig::split(1);
+    ASSERT_EQ(1u, single.size());
+    ASSERT_EQ(kMaxLicensesCount, single[0].licensesQuota_);
+    ASSERT_EQ(nullptr, single[0].broker_);
+
+    auto shards = ShardConfig::split(3);
+    ASSERT_EQ(3u, shards.size());
+    size_t licenses{0};
+    int16_t x{0};
+    for (const auto &shard : shards) {
+        ASSERT_EQ(x, shard.region_.posX_);
+        ASSERT_EQ((int16_t) kFieldMaxY, shard.region_.sizeY_);
+        ASSERT_EQ(shards[0].broker_, shard.broker_);
+        x = (int16_t) (x + shard.region_.sizeX_);
+        licenses += shard.licensesQuota_;
+    }
+    ASSERT_EQ((int16_t) kFieldMaxX, x);
+    ASSERT_EQ(kMaxLicensesCount, licenses);
+    ASSERT_EQ(4u, shards[0].licensesQuota_);
+    ASSERT_EQ(3u, shards[2].licensesQuota_);
+}
+
+TEST(ShardTest, TestSplitProcesses) {
+    auto broker = std::make_shared<Broker>();
+    auto shards = ShardConfig::split(2, 1, 2, broker);
+    ASSERT_EQ(2u, shards.size());
+    ASSERT_EQ(0, shards[0].id_);
+    ASSERT_EQ(2, shards[0].index_);
+    ASSERT_EQ(4, shards[0].cnt_);
+    ASSERT_EQ((int16_t) (kFieldMaxX / 2), shards[0].region_.posX_);
+    ASSERT_EQ((int16_t) kFieldMaxX, (int16_t) (shards[1].region_.posX_ + shards[1].region_.sizeX_));
+    ASSERT_EQ(2u, shards[0].licensesQuota_);
+    ASSERT_EQ(2u, shards[1].licensesQuota_);
+    ASSERT_EQ(broker, shards[1].broker_);
+
+    // every shard of the game keeps a license slot
+    shards = ShardConfig::split(8, 0, 5);
+    ASSERT_EQ(2u, shards.size());
+    ASSERT_EQ(1u, shards[0].licensesQuota_);
+}
+
+TEST(ShardTest, TestCoinExchange) {
+    CoinExchange exchange;
+    CoinID coin{};
+    ASSERT_FALSE(exchange.take(coin));
+    ASSERT_TRUE(exchange.offer(1));
+    ASSERT_TRUE(exchange.offer(2));
+    ASSERT_TRUE(exchange.take(coin));
+    ASSERT_EQ(1u, coin);
+    ASSERT_TRUE(exchange.take(coin));
+    ASSERT_EQ(2u, coin);
+    ASSERT_FALSE(exchange.take(coin));
+}
+
+TEST(ShardTest, TestCoinExchangeConcurrent) {
+    constexpr CoinID kCoinsPerProducer = 10'000;
+    CoinExchange exchange;
+    std::vector<std::thread> producers;
+    for (CoinID p = 0; p < 4; p++) {
+        producers.emplace_back([&exchange, p] {
+            for (CoinID i = 0; i < kCoinsPerProducer; i++) {
+                while (!exchange.offer(p * kCoinsPerProducer + i)) {}
+            }
+        });
+    }
+    std::vector<bool> seen(4 * kCoinsPerProducer, false);
+    size_t taken{0};
+    CoinID coin{};
+    while (taken < seen.size()) {
+        if (exchange.take(coin)) {
+            ASSERT_FALSE(seen[coin]);
+            seen[coin] = true;
+            taken++;
+        }
+    }
+    for (auto &t : producers) {
+        t.join();
+    }
+    ASSERT_FALSE(exchange.take(coin));
+}
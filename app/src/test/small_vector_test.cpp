@@ -0,0 +1,41 @@
+#include <gtest/gtest.h>
+#include <utility>
+#include "small_vector.h"
+#include "inline_string.h"
+
+TEST(SmallVectorTest, TestSpill) {
+    SmallVector<int, 2> v;
+    v.push_back(1);
+    v.push_back(2);
+    ASSERT_EQ(2u, v.size());
+    v.push_back(3);
+    v.emplace_back(4);
+    ASSERT_EQ((SmallVector<int, 2>{1, 2, 3, 4}), v);
+
+    auto copy = v;
+    auto moved = std::move(v);
+    ASSERT_TRUE(v.empty());
+    ASSERT_EQ(copy, moved);
+    moved.clear();
+    ASSERT_TRUE(moved.empty());
+
+    SmallVector<int, 2> small{5};
+    copy = small;
+    ASSERT_EQ(1u, copy.size());
+    ASSERT_EQ(5, copy[0]);
+    small = std::move(copy);
+    ASSERT_EQ(5, small.back());
+}
+
+TEST(SmallVectorTest, TestInlineString) {
+    InlineString<4> s("abcdef");
+    ASSERT_EQ("abcd", s);
+    ASSERT_FALSE(s.assign("abcde"));
+    ASSERT_TRUE(s.assign("xy"));
+    ASSERT_EQ(2u, s.size());
+
+    SmallVector<InlineString<4>, 1> ids;
+    ids.emplace_back("a");
+    ids.emplace_back("b");
+    ASSERT_EQ("b", ids.back());
+}
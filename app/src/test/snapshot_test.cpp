@@ -0,0 +1,143 @@
+#include <gtest/gtest.h>
+#include <cstdio>
+#include <string>
+#include <sys/wait.h>
+#include <unistd.h>
+#include "snapshot.h"
+
+namespace {
+
+const Area kRegion{0, 0, (int16_t) kFieldMaxX, (int16_t) kFieldMaxY};
+constexpr std::chrono::milliseconds kGameDuration{60'000};
+
+std::string snapshotPath(const std::string &name) {
+    auto path = testing::TempDir() + name + "_" + std::to_string(getpid());
+    std::remove(path.c_str());
+    return path;
+}
+
+// Fills the snapshot in a child process that dies without closing it, as a crashed game would.
+void crashAfterWrite(const std::string &path) {
+    auto pid = fork();
+    ASSERT_GE(pid, 0);
+    if (pid == 0) {
+        auto snapshot = new Snapshot();
+        if (snapshot->open(path, 0, kRegion, kGameDuration).hasError()) {
+            _exit(1);
+        }
+        auto &cell = (*snapshot->getCells())[12][34];
+        cell.left_ = 2;
+        cell.dugDepth_ = 3;
+        cell.flags_ = kCellDigInFlight;
+
+        LicenseManager licenses;
+        licenses.setMirror(snapshot->getLicenses());
+        (void) licenses.addLicense(License(7, 3, 1), LicenseClock::now());
+
+        SnapshotData data;
+        data.frontier_.push_back(SnapshotFrontierArea{Area(0, 0, 8, 8), 5, 2, 2});
+        data.childAreas_.emplace_back(0, 0, 4, 8);
+        data.childAreas_.emplace_back(4, 0, 4, 8);
+        data.coins_ = {11, 12};
+        data.cash_.push_back(SnapshotCash{"treasure", 4});
+        data.rootExplored_ = true;
+        if (!snapshot->submit(data)) {
+            _exit(1);
+        }
+        snapshot->flush();
+        _exit(0);
+    }
+    int status{0};
+    ASSERT_EQ(pid, waitpid(pid, &status, 0));
+    ASSERT_TRUE(WIFEXITED(status));
+    ASSERT_EQ(0, WEXITSTATUS(status));
+}
+
+}
+
+TEST(SnapshotTest, TestRestoreAfterCrash) {
+    auto path = snapshotPath("snapshot_test_restore");
+    crashAfterWrite(path);
+
+    Snapshot snapshot;
+    ASSERT_FALSE(snapshot.open(path, 0, kRegion, kGameDuration).hasError());
+    ASSERT_TRUE(snapshot.isRestorable());
+    ASSERT_LT(snapshot.getGameElapsed().count(), kGameDuration.count());
+
+    const auto &cell = (*snapshot.getCells())[12][34];
+    ASSERT_EQ(2, cell.left_);
+    ASSERT_EQ(3, cell.dugDepth_);
+    ASSERT_EQ(kCellDigInFlight, cell.flags_);
+
+    size_t inUse{0};
+    for (size_t i = 0; i < LicenseManager::kRecordsCap; i++) {
+        const auto &mirror = snapshot.getLicenses()[i];
+        if (mirror.inUse_ != 0) {
+            inUse++;
+            ASSERT_EQ(7, mirror.license_.id_);
+            ASSERT_EQ(3u, mirror.license_.digAllowed_);
+            ASSERT_EQ(1u, mirror.license_.digUsed_);
+        }
+    }
+    ASSERT_EQ(1u, inUse);
+
+    SnapshotData data;
+    snapshot.read(data);
+    ASSERT_TRUE(data.rootExplored_);
+    ASSERT_EQ(1u, data.frontier_.size());
+    ASSERT_EQ(5u, data.frontier_[0].leftTreasuriesCnt_);
+    ASSERT_EQ(2u, data.frontier_[0].childrenCnt_);
+    ASSERT_EQ(2u, data.childAreas_.size());
+    ASSERT_EQ(4, data.childAreas_[1].posX_);
+    ASSERT_EQ((std::vector<CoinID>{11, 12}), data.coins_);
+    ASSERT_EQ(1u, data.cash_.size());
+    ASSERT_EQ(TreasureID("treasure"), data.cash_[0].treasureId_);
+    ASSERT_EQ(4, data.cash_[0].depth_);
+
+    // the file is locked by its owner
+    Snapshot second;
+    ASSERT_TRUE(second.open(path, 0, kRegion, kGameDuration).hasError());
+    std::remove(path.c_str());
+}
+
+TEST(SnapshotTest, TestNotRestorable) {
+    auto path = snapshotPath("snapshot_test_reset");
+    crashAfterWrite(path);
+    {
+        // another shard of the game starts over
+        Snapshot snapshot;
+        ASSERT_FALSE(snapshot.open(path, 1, kRegion, kGameDuration).hasError());
+        ASSERT_FALSE(snapshot.isRestorable());
+        ASSERT_EQ(0, (*snapshot.getCells())[12][34].left_);
+        SnapshotData data;
+        snapshot.read(data);
+        ASSERT_TRUE(data.frontier_.empty());
+        ASSERT_FALSE(data.rootExplored_);
+    }
+    {
+        // the previous process exited normally
+        Snapshot snapshot;
+        ASSERT_FALSE(snapshot.open(path, 1, kRegion, kGameDuration).hasError());
+        ASSERT_FALSE(snapshot.isRestorable());
+    }
+    std::remove(path.c_str());
+}
+
+TEST(SnapshotTest, TestLatestSlot) {
+    auto path = snapshotPath("snapshot_test_slots");
+    Snapshot snapshot;
+    ASSERT_FALSE(snapshot.open(path, 0, kRegion, kGameDuration).hasError());
+    SnapshotData read;
+    snapshot.read(read);
+    ASSERT_TRUE(read.coins_.empty());
+
+    for (CoinID coin = 1; coin <= 3; coin++) {
+        SnapshotData data;
+        data.coins_.push_back(coin);
+        ASSERT_TRUE(snapshot.submit(data));
+        snapshot.flush();
+        snapshot.read(read);
+        ASSERT_EQ((std::vector<CoinID>{coin}), read.coins_);
+    }
+    std::remove(path.c_str());
+}
@@ -0,0 +1,26 @@
+#include <gtest/gtest.h>
+#include "speculative_dig.h"
+
+TEST(SpeculativeDigTest, TestShouldSpeculate) {
+    auto area = ExploreArea::NewExploreArea(nullptr, Area(2, 4, 1, 2), 3, 8);
+    SpeculativeDigs disabled{false};
+    ASSERT_FALSE(disabled.shouldSpeculate(*area, 1e9, 1.0, 100));
+
+    SpeculativeDigs digs{true};
+    // a dense pair of cells is rarely empty, so mostly the overrun past the last treasure is wasted
+    ASSERT_LT(SpeculativeDigs::expectedWastedDigs(2, 8), 6.0);
+    ASSERT_GT(SpeculativeDigs::expectedWastedDigs(2, 1), SpeculativeDigs::expectedWastedDigs(2, 8));
+    ASSERT_TRUE(digs.shouldSpeculate(*area, 10'000.0, 1'000.0, 100));
+    ASSERT_FALSE(digs.shouldSpeculate(*area, 1'000.0, 1'000.0, 100));
+    // the wasted digs do not fit the licenses at hand
+    ASSERT_FALSE(digs.shouldSpeculate(*area, 10'000.0, 1'000.0, 1));
+
+    digs.start(area);
+    ASSERT_EQ(area, digs.find(2, 4));
+    ASSERT_EQ(area, digs.find(2, 5));
+    ASSERT_EQ(nullptr, digs.find(3, 4));
+    digs.finishCell(2, 4);
+    ASSERT_EQ(nullptr, digs.find(2, 4));
+    digs.finishArea(*area);
+    ASSERT_EQ(nullptr, digs.find(2, 5));
+}
@@ -13,3 +13,39 @@ TEST(StateTest, TestLicenses) {
     ASSERT_TRUE(state->reserveAvailableLicenseId().hasError());
     ASSERT_FALSE(state->hasAvailableLicense());
 }
+
+TEST(StateTest, TestExploredChildrenKeepRequestOrder) {
+    auto parent = ExploreArea::NewExploreArea(nullptr, Area(0, 0, 4, 1), 0, 5);
+    // the order of the children is the density prior ranking
+    std::vector<ExploreAreaPtr> children;
+    for (int16_t i = 0; i < 4; i++) {
+        children.push_back(ExploreArea::NewExploreArea(parent, Area(i, 0, 1, 1), 1, 0));
+        parent->addChild(children.back());
+    }
+    ASSERT_EQ(children[0], parent->getChildForRequest());
+    ASSERT_EQ(children[1], parent->getChildForRequest());
+    for (size_t i = 0; i < 2; i++) {
+        children[i]->actualTreasuriesCnt_ = 1;
+        children[i]->explored_ = true;
+        parent->updateChildExplored(children[i]);
+    }
+    ASSERT_EQ(children[2], parent->getChildForRequest());
+    // the last one is left for the inference
+    ASSERT_EQ(nullptr, parent->getChildForRequest());
+}
+
+TEST(StateTest, TestRefundLicenseCoins) {
+    auto state = std::make_shared<State>();
+    Wallet coins;
+    for (CoinID coin = 1; coin <= 3; coin++) {
+        coins.coins.push_back(coin);
+    }
+    ASSERT_FALSE(state->refundLicenseCoins(coins, 200, 0));
+    ASSERT_EQ(0u, state->getCoinsAmount());
+    ASSERT_TRUE(state->refundLicenseCoins(coins, 409, kApiErrNoMoreActiveLicenses));
+    ASSERT_EQ(3u, state->getCoinsAmount());
+    ASSERT_TRUE(state->refundLicenseCoins(coins, 504, 0));
+    ASSERT_EQ(6u, state->getCoinsAmount());
+    ASSERT_FALSE(state->refundLicenseCoins(coins, 402, kApiErrBogusCoin));
+    ASSERT_EQ(6u, state->getCoinsAmount());
+}
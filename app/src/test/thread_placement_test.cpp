@@ -0,0 +1,48 @@
+#include <gtest/gtest.h>
+#include "thread_placement.h"
+
+TEST(ThreadPlacementTest, TestPlan) {
+    ThreadPlacementConfig config;
+    config.mode_ = ThreadPlacementMode::Pinned;
+    // 4 cores with SMT siblings n and n + 4
+    CpuCores cores{{0, 4}, {1, 5}, {2, 6}, {3, 7}};
+
+    auto placement = ThreadPlacement::plan(cores, 1, config);
+    ASSERT_EQ(std::vector<int>({3}), placement.appCpus_);
+    // the sibling of the app cpu stays idle
+    ASSERT_EQ(std::vector<int>({0, 1, 2, 4, 5, 6}), placement.ioCpus_);
+    ASSERT_EQ(8u, placement.allowedCpus_.size());
+
+    // one core is always left for the other threads
+    placement = ThreadPlacement::plan(cores, 5, config);
+    ASSERT_EQ(std::vector<int>({3, 2, 1}), placement.appCpus_);
+    ASSERT_EQ(std::vector<int>({0, 4}), placement.ioCpus_);
+
+    placement = ThreadPlacement::plan({{0}}, 1, config);
+    ASSERT_TRUE(placement.appCpus_.empty());
+    ASSERT_TRUE(placement.ioCpus_.empty());
+
+    config.mode_ = ThreadPlacementMode::Off;
+    placement = ThreadPlacement::plan(cores, 1, config);
+    ASSERT_TRUE(placement.appCpus_.empty());
+    ASSERT_TRUE(placement.ioCpus_.empty());
+}
+
+TEST(ThreadPlacementTest, TestPlanProcesses) {
+    ThreadPlacementConfig config;
+    config.mode_ = ThreadPlacementMode::Pinned;
+    CpuCores cores{{0, 4}, {1, 5}, {2, 6}, {3, 7}};
+
+    // the processes of PROCESS_SHARDS do not share app cores, the io cores are common
+    auto first = ThreadPlacement::plan(cores, 1, config, 0, 2);
+    auto second = ThreadPlacement::plan(cores, 1, config, 1, 2);
+    ASSERT_EQ(std::vector<int>({3}), first.appCpus_);
+    ASSERT_EQ(std::vector<int>({2}), second.appCpus_);
+    ASSERT_EQ(std::vector<int>({0, 1, 4, 5}), first.ioCpus_);
+    ASSERT_EQ(first.ioCpus_, second.ioCpus_);
+
+    // a process past the cores left runs its app threads on the io cores
+    auto third = ThreadPlacement::plan(cores, 2, config, 1, 2);
+    ASSERT_EQ(std::vector<int>({1}), third.appCpus_);
+    ASSERT_EQ(std::vector<int>({0, 4}), third.ioCpus_);
+}
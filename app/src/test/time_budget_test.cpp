@@ -0,0 +1,36 @@
+#include <gtest/gtest.h>
+#include "time_budget.h"
+
+TEST(TimeBudgetTest, TestPhases) {
+    auto start = GameClock::now();
+    TimeBudget budget{start, std::chrono::seconds(10), true};
+    budget.recordStageLatency(PipelineStage::Explore, std::chrono::milliseconds(1000));
+    budget.recordStageLatency(PipelineStage::License, std::chrono::milliseconds(500));
+    budget.recordStageLatency(PipelineStage::Dig, std::chrono::milliseconds(200));
+    budget.recordStageLatency(PipelineStage::Cash, std::chrono::milliseconds(100));
+
+    auto deadline = start + std::chrono::seconds(10) - std::chrono::milliseconds(kGameDeadlineMarginMs);
+    ASSERT_FALSE(budget.update(start));
+    ASSERT_TRUE(budget.allows(GamePhase::NoExplore));
+
+    auto exploreChain = std::chrono::milliseconds(1000 + 500 + 200 * kEndGameDigChainLength + 100);
+    ASSERT_TRUE(budget.update(deadline - exploreChain + std::chrono::milliseconds(1)));
+    ASSERT_EQ(GamePhase::NoExplore, budget.getPhase());
+    ASSERT_FALSE(budget.allows(GamePhase::NoExplore));
+    ASSERT_TRUE(budget.allows(GamePhase::NoLicenses));
+
+    // the last dig and cash still fit, licenses do not
+    ASSERT_TRUE(budget.update(deadline - std::chrono::milliseconds(700)));
+    ASSERT_EQ(GamePhase::NoLicenses, budget.getPhase());
+    ASSERT_TRUE(budget.update(deadline - std::chrono::milliseconds(200)));
+    ASSERT_EQ(GamePhase::CashOnly, budget.getPhase());
+    ASSERT_FALSE(budget.update(start));
+    ASSERT_EQ(GamePhase::CashOnly, budget.getPhase());
+}
+
+TEST(TimeBudgetTest, TestDisabled) {
+    auto start = GameClock::now();
+    TimeBudget budget{start, std::chrono::seconds(1), false};
+    ASSERT_FALSE(budget.update(start + std::chrono::seconds(2)));
+    ASSERT_EQ(GamePhase::Full, budget.getPhase());
+}
@@ -0,0 +1,214 @@
+#!/usr/bin/env python3
+
+# Sweeps runtime config parameters of the real client against local stub servers:
+#   ./tune.py --binary out/release/highloadcup2021 --duration 60 --parallel 4 \
+#       --grid 'EXPLORE_CONCURRENCY=5|10|20' --grid 'CASH_RATIO=0|0.5'
+# Every combination of the grid values runs once per seed. A run starts its own stub server on a free
+# port of --base-port and the client with the combination in its environment, the keys are the ones of
+# RuntimeConfig or any other environment knob, e.g. SPECULATIVE_DIG. Once the stub server stops after
+# --duration seconds its client report gives the treasures found and the coins balance at the end.
+# Runs of one combination are averaged, the report lists all combinations and marks the Pareto-best
+# ones by treasures per second and coins. Logs and results.csv are kept in --out.
+# The stub server requirements are expected to be installed, see ../stubserver/README.md.
+
+import argparse
+import csv
+import itertools
+import os
+import queue
+import re
+import signal
+import subprocess
+import sys
+import time
+import urllib.error
+import urllib.request
+from concurrent.futures import ThreadPoolExecutor
+
+DEFAULT_GRID = [
+    "EXPLORE_AREAS=3500x1,875x1,219x1,55x1,14x1,7x1,4x1,2x1,1x1|3500x1,700x1,140x1,28x1,7x1,2x1,1x1"
+    "|3500x1,350x1,35x1,7x1,1x1",
+    "EXPLORE_CONCURRENCY=5|10|20",
+    "MAX_LICENSES=5|10",
+    "CASH_RATIO=0|0.5|0.9",
+]
+
+# the knobs that would leak state between runs or into the grid
+ISOLATED_ENV = ["CONFIG_PATH", "SNAPSHOT_PATH", "DENSITY_MAP_PATH", "PROCESS_SHARDS", "PROCESS_SHARD_ID", "BROKER_SHM"]
+
+SERVER_START_TIMEOUT = 120
+CLIENT_STOP_TIMEOUT = 10
+
+
+def parse_grid(items):
+    grid = []
+    for item in items:
+        key, sep, values = item.partition("=")
+        if not sep or not key or not values:
+            sys.exit(f"bad grid item {item}, expected KEY=v1|v2")
+        grid.append((key, values.split("|")))
+    return grid
+
+
+def wait_for_server(port, proc):
+    url = f"http://localhost:{port}/explore"
+    body = b'{"posX":0,"posY":0,"sizeX":1,"sizeY":1}'
+    deadline = time.monotonic() + SERVER_START_TIMEOUT
+    while time.monotonic() < deadline:
+        if proc.poll() is not None:
+            return False
+        request = urllib.request.Request(url, data=body, headers={"Content-Type": "application/json"})
+        try:
+            urllib.request.urlopen(request, timeout=1).read()
+            return True
+        except urllib.error.HTTPError:
+            # rate limits and 50x still mean that the server is up
+            return True
+        except (urllib.error.URLError, ConnectionError, OSError):
+            time.sleep(0.2)
+    return False
+
+
+def parse_client_report(path):
+    report = {}
+    with open(path) as f:
+        for line in f:
+            m = re.match(r"^(Balance|Treasures found):\t(\d+)", line)
+            if m:
+                report[m.group(1)] = int(m.group(2))
+    if "Balance" not in report or "Treasures found" not in report:
+        return None
+    return report
+
+
+def stop(proc):
+    if proc.poll() is not None:
+        return
+    proc.send_signal(signal.SIGTERM)
+    try:
+        proc.wait(timeout=CLIENT_STOP_TIMEOUT)
+    except subprocess.TimeoutExpired:
+        proc.kill()
+        proc.wait()
+
+
+def run_one(args, ports, run_id, params, seed):
+    port = ports.get()
+    name = f"{run_id:04d}_seed{seed}"
+    server_log = os.path.join(args.out, "logs", name + ".server.log")
+    client_log = os.path.join(args.out, "logs", name + ".client.log")
+    base_env = {k: v for k, v in os.environ.items() if k not in ISOLATED_ENV}
+    server_env = dict(base_env, SERVER_PORT=str(port), SERVER_SEED=str(seed),
+                      SERVER_RUN_TIME_IN_SECONDS=str(args.duration))
+    client_env = dict(base_env, ADDRESS="localhost", Port=str(port), SERVER_RUN_TIME_IN_SECONDS=str(args.duration))
+    client_env.update(params)
+    server = client = None
+    try:
+        with open(server_log, "w") as server_out, open(client_log, "w") as client_out:
+            server = subprocess.Popen([sys.executable, "-m", "openapi_server"], cwd=args.stub_dir, env=server_env,
+                                      stdout=server_out, stderr=subprocess.STDOUT)
+            if not wait_for_server(port, server):
+                return name, params, seed, None
+            started = time.monotonic()
+            client = subprocess.Popen([args.binary], env=client_env, stdout=client_out, stderr=subprocess.STDOUT)
+            # the server prints the client report and exits once its run time is over
+            server.wait(timeout=args.duration + SERVER_START_TIMEOUT)
+            elapsed = time.monotonic() - started
+        report = parse_client_report(server_log)
+        if report is None:
+            return name, params, seed, None
+        return name, params, seed, {
+            "treasures_per_second": report["Treasures found"] / max(elapsed, 1.0),
+            "coins": report["Balance"],
+            # the client runs till it is stopped, an exit before is a crash or a fatal error
+            "crashed": client.poll() is not None,
+        }
+    except subprocess.TimeoutExpired:
+        return name, params, seed, None
+    finally:
+        for proc in (client, server):
+            if proc is not None:
+                stop(proc)
+        ports.put(port)
+
+
+def pareto_front(rows):
+    front = set()
+    for i, a in enumerate(rows):
+        dominated = any(
+            b["treasures_per_second"] >= a["treasures_per_second"] and b["coins"] >= a["coins"] and
+            (b["treasures_per_second"] > a["treasures_per_second"] or b["coins"] > a["coins"])
+            for b in rows)
+        if not dominated:
+            front.add(i)
+    return front
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Sweeps runtime config parameters against local stub servers")
+    parser.add_argument("--binary", default="out/release/highloadcup2021")
+    parser.add_argument("--stub-dir", default=os.path.join(os.path.dirname(os.path.abspath(__file__)), "..",
+                                                           "stubserver"))
+    parser.add_argument("--duration", type=int, default=60, help="game duration of a run in seconds")
+    parser.add_argument("--parallel", type=int, default=max(1, (os.cpu_count() or 2) // 4))
+    parser.add_argument("--base-port", type=int, default=18000)
+    parser.add_argument("--seeds", default="0", help="comma separated stub server seeds")
+    parser.add_argument("--grid", action="append", help="KEY=v1|v2, repeatable, replaces the default grid")
+    parser.add_argument("--out", default="tune-out")
+    args = parser.parse_args()
+    args.binary = os.path.abspath(args.binary)
+
+    grid = parse_grid(args.grid or DEFAULT_GRID)
+    seeds = [int(s) for s in args.seeds.split(",")]
+    combinations = [dict(zip([k for k, _ in grid], values)) for values in itertools.product(*[v for _, v in grid])]
+    os.makedirs(os.path.join(args.out, "logs"), exist_ok=True)
+    print(f"{len(combinations)} combinations x {len(seeds)} seeds, {args.parallel} in parallel, "
+          f"{args.duration} s each", flush=True)
+
+    ports = queue.Queue()
+    for i in range(args.parallel):
+        ports.put(args.base_port + i)
+    results = {}
+    with ThreadPoolExecutor(max_workers=args.parallel) as pool:
+        futures = [pool.submit(run_one, args, ports, run_id, params, seed)
+                   for run_id, params in enumerate(combinations) for seed in seeds]
+        for future in futures:
+            name, params, seed, result = future.result()
+            if result is None:
+                print(f"{name}: failed, see {args.out}/logs", flush=True)
+                continue
+            print(f"{name}: {result['treasures_per_second']:.2f} treasures/s {result['coins']} coins"
+                  f"{' crashed' if result['crashed'] else ''} {params}", flush=True)
+            results.setdefault(tuple(sorted(params.items())), []).append(result)
+
+    rows = []
+    for key, runs in results.items():
+        rows.append({
+            "params": dict(key),
+            "runs": len(runs),
+            "treasures_per_second": sum(r["treasures_per_second"] for r in runs) / len(runs),
+            "coins": sum(r["coins"] for r in runs) / len(runs),
+            "crashes": sum(1 for r in runs if r["crashed"]),
+        })
+    rows.sort(key=lambda r: (r["treasures_per_second"], r["coins"]), reverse=True)
+    front = pareto_front(rows)
+
+    keys = [k for k, _ in grid]
+    with open(os.path.join(args.out, "results.csv"), "w", newline="") as f:
+        writer = csv.writer(f)
+        writer.writerow(keys + ["runs", "treasures_per_second", "coins", "crashes", "pareto"])
+        for i, row in enumerate(rows):
+            writer.writerow([row["params"].get(k, "") for k in keys] +
+                            [row["runs"], f"{row['treasures_per_second']:.3f}", f"{row['coins']:.1f}",
+                             row["crashes"], int(i in front)])
+
+    print("\nPareto-best by treasures per second and coins:")
+    for i, row in enumerate(rows):
+        if i in front:
+            print(f"  {row['treasures_per_second']:.2f} treasures/s {row['coins']:.0f} coins "
+                  f"({row['runs']} runs, {row['crashes']} crashes) {row['params']}")
+    print(f"\nAll {len(rows)} combinations: {args.out}/results.csv")
+
+
+if __name__ == "__main__":
+    main()
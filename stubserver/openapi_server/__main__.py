@@ -29,6 +29,7 @@ def kill_handler(_signum, _frame):
 seed = int(os.getenv("SERVER_SEED", 0))
 rate_limit = os.getenv("DEFAULT_RATE_LIMIT", "1000 per second")
 run_time = int(os.getenv("SERVER_RUN_TIME_IN_SECONDS", 600))
+port = int(os.getenv("SERVER_PORT", 8000))
 
 ctrl.world = World(seed)
 cnx_app = connexion.App(__name__, specification_dir='./openapi/')
@@ -50,7 +51,7 @@ logger.info(ctrl.world.get_world_report())
 def main():
     from gevent.pywsgi import WSGIServer
     try:
-        http_server = WSGIServer(('0.0.0.0', 8000), cnx_app.app)
+        http_server = WSGIServer(('0.0.0.0', port), cnx_app.app)
         http_server.serve_forever()
     finally:
         print(f"Final balance: {ctrl.world.balance}")